@@ -3,9 +3,14 @@
 #include <ACL/general.h>
 #include <ACL/type_traits.h>
 #include <concepts>
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iterator>
 #include <memory>
+#include <string_view>
 #include "storage.h"
+#include "hash.h"
 
 
 namespace mylib {
@@ -202,6 +207,9 @@ public:
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+    static constexpr bool is_dynamic = storage_type::is_dynamic;
+    static constexpr bool is_contiguous = storage_type::is_contiguous;
+
     Array() : storage() {}
 
     Array(size_type size) : storage(size) {
@@ -314,8 +322,17 @@ public:
         } else {
             static_assert(std::is_default_constructible_v<value_type>);
 
-            for (size_type i = 0; i < storage.size(); ++i) {
-                storage.item(i) = value_type{};
+            fill(value_type{});
+        }
+    }
+
+    void fill(const value_type &value) {
+        if constexpr (is_contiguous) {
+            // Becomes a memset for bytes and a vectorized store loop otherwise
+            std::fill_n(data(), size(), value);
+        } else {
+            for (size_type i = 0, sz = size(); i < sz; ++i) {
+                storage.item(i) = value;
             }
         }
     }
@@ -324,6 +341,15 @@ public:
         return storage.size();
     }
 
+    /// Only for contiguous storages, where elements [0, size()) form a plain array
+    inline pointer data() requires is_contiguous {
+        return storage.data();
+    }
+
+    inline const_pointer data() const requires is_contiguous {
+        return storage.data();
+    }
+
     inline bool empty() const {
         static_assert(storage.is_dynamic);
 
@@ -356,6 +382,56 @@ public:
         }
     }
 
+    /// Only a hint: storages that can't preallocate ignore it
+    inline void reserve(size_type capacity) {
+        if constexpr (requires (storage_type storage) { storage.reserve(capacity); }) {
+            storage.reserve(capacity);
+        }
+    }
+
+    #pragma region Comparison
+    template <template <typename T> typename OtherStorage>
+    requires std::equality_comparable<value_type>
+    bool operator==(const Array<value_type, OtherStorage> &other) const {
+        size_type sz = size();
+
+        if (sz != other.size()) {
+            return false;
+        }
+
+        if constexpr (is_contiguous && Array<value_type, OtherStorage>::is_contiguous &&
+                      std::has_unique_object_representations_v<value_type>) {
+            return sz == 0 || std::memcmp(data(), other.data(), sz * sizeof(value_type)) == 0;
+        } else if constexpr (is_contiguous && Array<value_type, OtherStorage>::is_contiguous) {
+            return std::equal(data(), data() + sz, other.data());
+        } else {
+            return std::equal(begin(), end(), other.begin());
+        }
+    }
+
+    /**
+     * Order-dependent hash of the elements. Contiguous arrays of types
+     * whose value is fully determined by their bytes are hashed as one blob.
+     */
+    size_t hash() const requires requires (const value_type &value) {
+        { std::hash<value_type>{}(value) } -> std::convertible_to<size_t>;
+    } {
+        if constexpr (is_contiguous && std::has_unique_object_representations_v<value_type>) {
+            return hash_bytes(data(), size() * sizeof(value_type));
+        } else {
+            size_t result = size();
+
+            for (const value_type &item : *this) {
+                // The boost::hash_combine mixer
+                result ^= std::hash<value_type>{}(item) + 0x9e3779b97f4a7c15ull +
+                          (result << 6) + (result >> 2);
+            }
+
+            return result;
+        }
+    }
+    #pragma endregion Comparison
+
     #pragma region Arithmetics
     #define ELEMENTWISE_OP_(OP)                                                     \
         template <typename OtherT, template <typename T> typename OtherStorage>     \
@@ -365,15 +441,26 @@ public:
         Array &operator OP##=(const Array<OtherT, OtherStorage> &other) {           \
             size_type sz = size();                                                  \
                                                                                     \
-            if constexpr (storage_type::is_dynamic ||                               \
-                          other.storage_type::is_dynamic) {                         \
+            if constexpr (is_dynamic ||                                             \
+                          Array<OtherT, OtherStorage>::is_dynamic) {                \
                 if (sz != other.size()) {                                           \
                     throw std::length_error("Argument size mismatch");              \
                 }                                                                   \
             }                                                                       \
                                                                                     \
-            for (size_type idx = 0; idx < sz; ++idx) {                              \
-                (*this)[idx] OP##= other[idx];                                      \
+            if constexpr (is_contiguous &&                                          \
+                          Array<OtherT, OtherStorage>::is_contiguous) {             \
+                /* No range checks, so the loop vectorizes */                       \
+                value_type *lhs = data();                                           \
+                const OtherT *rhs = other.data();                                   \
+                                                                                    \
+                for (size_type idx = 0; idx < sz; ++idx) {                          \
+                    lhs[idx] OP##= rhs[idx];                                        \
+                }                                                                   \
+            } else {                                                                \
+                for (size_type idx = 0; idx < sz; ++idx) {                          \
+                    (*this)[idx] OP##= other[idx];                                  \
+                }                                                                   \
             }                                                                       \
                                                                                     \
             return *this;                                                           \
@@ -408,7 +495,7 @@ public:
     value_type dot(const Array<OtherT, OtherStorage> &other) const {
         size_type sz = size();
 
-        if constexpr (storage_type::is_dynamic || other.storage_type::is_dynamic) {
+        if constexpr (is_dynamic || Array<OtherT, OtherStorage>::is_dynamic) {
             if (sz != other.size()) {
                 throw std::length_error("Argument size mismatch");
             }
@@ -419,19 +506,50 @@ public:
             return value_type{};
         }
 
+        if constexpr (is_contiguous && Array<OtherT, OtherStorage>::is_contiguous &&
+                      std::is_arithmetic_v<value_type>) {
+            return _dot_contiguous(data(), other.data(), sz);
+        }
+
         value_type result{(*this)[0] * other[0]};
 
         for (size_type idx = 1; idx < sz; ++idx) {
             result += (*this)[idx] * other[idx];
         }
 
-        return *this;
+        return result;
     }
     #pragma endregion Arithmetics
 
 protected:
     storage_type storage;
 
+
+    /**
+     * Several independent accumulators break the dependency chain on result,
+     * so the loop can be vectorized (for floats the summation order changes,
+     * as it would with any SIMD implementation).
+     */
+    template <typename OtherT>
+    static value_type _dot_contiguous(const value_type *lhs, const OtherT *rhs, size_type sz) {
+        constexpr size_type lanes = 4;
+
+        value_type acc[lanes] = {};
+        size_type idx = 0;
+
+        for (; idx + lanes <= sz; idx += lanes) {
+            for (size_type lane = 0; lane < lanes; ++lane) {
+                acc[lane] += lhs[idx + lane] * rhs[idx + lane];
+            }
+        }
+
+        for (; idx < sz; ++idx) {
+            acc[0] += lhs[idx] * rhs[idx];
+        }
+
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+
 };
 #pragma endregion Array
 
@@ -467,6 +585,10 @@ public:
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+    using Base::is_dynamic;
+    // Elements aren't addressable
+    static constexpr bool is_contiguous = false;
+
 
     Array() : Base(1) {}
 
@@ -502,6 +624,26 @@ public:
         }
     }
 
+    Array(const Array &other) = default;
+    Array &operator=(const Array &other) = default;
+
+    Array(Array &&other) noexcept :
+        Base(std::move(other)), bits_last{other.bits_last} {
+
+        // Dynamic storage is left without bytes, and so must the bit count be
+        if constexpr (is_dynamic) {
+            other.bits_last = 0;
+        }
+    }
+
+    Array &operator=(Array &&other) noexcept {
+        // Storages swap on move assignment
+        Base::operator=(std::move(other));
+        std::swap(bits_last, other.bits_last);
+
+        return *this;
+    }
+
     constexpr reference operator[](difference_type idx) {
         size_type sz = size();
 
@@ -555,6 +697,11 @@ public:
     void push_back(value_type value) {
         static_assert(storage.is_dynamic);
 
+        // Cleared and moved-from arrays have no last byte to fill
+        if (storage.size() == 0) {
+            *storage.expand_one() = 0x00;
+        }
+
         ++bits_last;
         if (bits_last == 8) {
             *storage.expand_one() = 0x00;
@@ -628,6 +775,10 @@ public:
 
     using Base::allocate_now;
 
+    inline void reserve(size_type capacity) {
+        Base::reserve(_bytes_floor(capacity) + 1);
+    }
+
 protected:
     uint8_t bits_last{0};
 
@@ -736,6 +887,14 @@ inline void swap(mylib::Array<bool, mylib::DynamicLinearStorage>::reference a,
 }
 #endif
 
+template <typename T, template <typename T_> typename Storage_>
+requires requires (const mylib::Array<T, Storage_> &array) { array.hash(); }
+struct hash<mylib::Array<T, Storage_>> {
+    size_t operator()(const mylib::Array<T, Storage_> &array) const {
+        return array.hash();
+    }
+};
+
 template <typename Arr, typename T>
 requires (std::same_as<bool, std::remove_const_t<T>>)
 inline void iter_swap(mylib::_impl::ArrayIterator<Arr, T> a,
@@ -3,50 +3,876 @@
 #include <ACL/general.h>
 #include <ACL/type_traits.h>
 #include <concepts>
+#include <cmath>
+#include <type_traits>
+#include <utility>
 
 
-// Uncomment to employ a cooler trick
-#define MATH_TEST_COOLER_DOT_PRODUCT
+#if defined(__AVX__)
+#define MATH_TEST_USE_AVX_ 1
+#else
+#define MATH_TEST_USE_AVX_ 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_TEST_USE_SSE2_ 1
+#else
+#define MATH_TEST_USE_SSE2_ 0
+#endif
+
+#if MATH_TEST_USE_AVX_ || MATH_TEST_USE_SSE2_
+#include <immintrin.h>
+#endif
 
 
+/**
+ * Small fixed-size vectors and matrices. Every operation is unrolled at compile
+ * time, and how exactly is up to the kernel the type is parametrized with:
+ * RecursiveKernel and FoldKernel only differ in the C++ used to express it,
+ * while SimdKernel packs float and double vectors into SSE/AVX registers.
+ */
 namespace math_test {
 
 
-#ifndef MATH_TEST_COOLER_DOT_PRODUCT
-template <typename T, size_t N>
-requires (std::signed_integral<T> || std::floating_point<T>)
-T _dot_product(T *data_a, T *data_b) {
-    if constexpr (N == 0) {
-        return T{};
+template <typename T>
+concept scalar = std::signed_integral<T> || std::floating_point<T>;
+
+
+namespace _impl {
+
+
+/// Calls func(i) for every i < N, with the loop unrolled
+template <size_t N, typename F>
+constexpr void unroll(F &&func) {
+    [&]<size_t ... Is>(std::index_sequence<Is...>) {
+        (func(Is), ...);
+    }(std::make_index_sequence<N>());
+}
+
+
+#pragma region Operations
+/// Element-wise operations, in a form both the scalar and the SIMD code can apply
+struct Add {
+    template <typename T>
+    static constexpr T apply(T a, T b) noexcept {
+        return a + b;
+    }
+
+    template <typename Isa>
+    static inline typename Isa::reg apply_simd(typename Isa::reg a, typename Isa::reg b) noexcept {
+        return Isa::add(a, b);
+    }
+};
+
+struct Sub {
+    template <typename T>
+    static constexpr T apply(T a, T b) noexcept {
+        return a - b;
+    }
+
+    template <typename Isa>
+    static inline typename Isa::reg apply_simd(typename Isa::reg a, typename Isa::reg b) noexcept {
+        return Isa::sub(a, b);
+    }
+};
+
+struct Mul {
+    template <typename T>
+    static constexpr T apply(T a, T b) noexcept {
+        return a * b;
+    }
+
+    template <typename Isa>
+    static inline typename Isa::reg apply_simd(typename Isa::reg a, typename Isa::reg b) noexcept {
+        return Isa::mul(a, b);
+    }
+};
+
+struct Div {
+    template <typename T>
+    static constexpr T apply(T a, T b) noexcept {
+        return a / b;
+    }
+
+    template <typename Isa>
+    static inline typename Isa::reg apply_simd(typename Isa::reg a, typename Isa::reg b) noexcept {
+        return Isa::div(a, b);
+    }
+};
+#pragma endregion Operations
+
+
+#pragma region SIMD
+#if MATH_TEST_USE_SSE2_
+struct SseFloat {
+    using value_type = float;
+    using reg = __m128;
+
+    static constexpr size_t width = 4;
+
+    static inline reg load(const float *ptr) noexcept {
+        return _mm_loadu_ps(ptr);
+    }
+
+    static inline void store(float *ptr, reg value) noexcept {
+        _mm_storeu_ps(ptr, value);
+    }
+
+    /// Loads the first Count lanes and zeroes the rest, without reading past them
+    template <size_t Count>
+    static inline reg load_partial(const float *ptr) noexcept {
+        static_assert(Count < width);
+
+        if constexpr (Count == 1) {
+            return _mm_load_ss(ptr);
+        } else if constexpr (Count == 2) {
+            return _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)ptr);
+        } else {
+            return _mm_movelh_ps(load_partial<2>(ptr), _mm_load_ss(ptr + 2));
+        }
+    }
+
+    template <size_t Count>
+    static inline void store_partial(float *ptr, reg value) noexcept {
+        static_assert(Count < width);
+
+        if constexpr (Count == 1) {
+            _mm_store_ss(ptr, value);
+        } else {
+            _mm_storel_pi((__m64 *)ptr, value);
+
+            if constexpr (Count == 3) {
+                _mm_store_ss(ptr + 2, _mm_movehl_ps(value, value));
+            }
+        }
+    }
+
+    static inline reg splat(float value) noexcept {
+        return _mm_set1_ps(value);
+    }
+
+    static inline reg zero() noexcept {
+        return _mm_setzero_ps();
+    }
+
+    static inline reg add(reg a, reg b) noexcept {
+        return _mm_add_ps(a, b);
+    }
+
+    static inline reg sub(reg a, reg b) noexcept {
+        return _mm_sub_ps(a, b);
+    }
+
+    static inline reg mul(reg a, reg b) noexcept {
+        return _mm_mul_ps(a, b);
+    }
+
+    static inline reg div(reg a, reg b) noexcept {
+        return _mm_div_ps(a, b);
+    }
+
+    /// The sum of all the lanes
+    static inline float sum(reg a) noexcept {
+        reg shuffled = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+        reg sums = _mm_add_ps(a, shuffled);
+        shuffled = _mm_movehl_ps(shuffled, sums);
+
+        return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+    }
+};
+
+struct SseDouble {
+    using value_type = double;
+    using reg = __m128d;
+
+    static constexpr size_t width = 2;
+
+    static inline reg load(const double *ptr) noexcept {
+        return _mm_loadu_pd(ptr);
+    }
+
+    static inline void store(double *ptr, reg value) noexcept {
+        _mm_storeu_pd(ptr, value);
+    }
+
+    template <size_t Count>
+    static inline reg load_partial(const double *ptr) noexcept {
+        static_assert(Count == 1);
+
+        return _mm_load_sd(ptr);
+    }
+
+    template <size_t Count>
+    static inline void store_partial(double *ptr, reg value) noexcept {
+        static_assert(Count == 1);
+
+        _mm_store_sd(ptr, value);
+    }
+
+    static inline reg splat(double value) noexcept {
+        return _mm_set1_pd(value);
+    }
+
+    static inline reg zero() noexcept {
+        return _mm_setzero_pd();
+    }
+
+    static inline reg add(reg a, reg b) noexcept {
+        return _mm_add_pd(a, b);
+    }
+
+    static inline reg sub(reg a, reg b) noexcept {
+        return _mm_sub_pd(a, b);
+    }
+
+    static inline reg mul(reg a, reg b) noexcept {
+        return _mm_mul_pd(a, b);
+    }
+
+    static inline reg div(reg a, reg b) noexcept {
+        return _mm_div_pd(a, b);
+    }
+
+    static inline double sum(reg a) noexcept {
+        return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+    }
+};
+#endif
+
+#if MATH_TEST_USE_AVX_
+/// An AVX register's tail is an SSE register or two, one of them partial
+template <typename Avx, typename Sse, size_t Count>
+inline typename Avx::reg load_halves(const typename Avx::value_type *ptr) noexcept {
+    static_assert(Count < Avx::width);
+
+    constexpr size_t half = Sse::width;
+
+    if constexpr (Count < half) {
+        return Avx::join(Sse::template load_partial<Count>(ptr), Sse::zero());
+    } else if constexpr (Count == half) {
+        return Avx::join(Sse::load(ptr), Sse::zero());
+    } else {
+        return Avx::join(Sse::load(ptr), Sse::template load_partial<Count - half>(ptr + half));
+    }
+}
+
+template <typename Avx, typename Sse, size_t Count>
+inline void store_halves(typename Avx::value_type *ptr, typename Avx::reg value) noexcept {
+    static_assert(Count < Avx::width);
+
+    constexpr size_t half = Sse::width;
+
+    if constexpr (Count < half) {
+        Sse::template store_partial<Count>(ptr, Avx::lo(value));
     } else {
-        return data_a * data_b + _dot_product<T, N - 1>(data_a + 1, data_b + 1);
+        Sse::store(ptr, Avx::lo(value));
+
+        if constexpr (Count > half) {
+            Sse::template store_partial<Count - half>(ptr + half, Avx::hi(value));
+        }
     }
 }
+
+struct AvxFloat {
+    using value_type = float;
+    using reg = __m256;
+
+    static constexpr size_t width = 8;
+
+    static inline reg load(const float *ptr) noexcept {
+        return _mm256_loadu_ps(ptr);
+    }
+
+    static inline void store(float *ptr, reg value) noexcept {
+        _mm256_storeu_ps(ptr, value);
+    }
+
+    template <size_t Count>
+    static inline reg load_partial(const float *ptr) noexcept {
+        return _impl::load_halves<AvxFloat, SseFloat, Count>(ptr);
+    }
+
+    template <size_t Count>
+    static inline void store_partial(float *ptr, reg value) noexcept {
+        _impl::store_halves<AvxFloat, SseFloat, Count>(ptr, value);
+    }
+
+    static inline reg join(__m128 lo, __m128 hi) noexcept {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+
+    static inline __m128 lo(reg value) noexcept {
+        return _mm256_castps256_ps128(value);
+    }
+
+    static inline __m128 hi(reg value) noexcept {
+        return _mm256_extractf128_ps(value, 1);
+    }
+
+    static inline reg splat(float value) noexcept {
+        return _mm256_set1_ps(value);
+    }
+
+    static inline reg zero() noexcept {
+        return _mm256_setzero_ps();
+    }
+
+    static inline reg add(reg a, reg b) noexcept {
+        return _mm256_add_ps(a, b);
+    }
+
+    static inline reg sub(reg a, reg b) noexcept {
+        return _mm256_sub_ps(a, b);
+    }
+
+    static inline reg mul(reg a, reg b) noexcept {
+        return _mm256_mul_ps(a, b);
+    }
+
+    static inline reg div(reg a, reg b) noexcept {
+        return _mm256_div_ps(a, b);
+    }
+
+    static inline float sum(reg a) noexcept {
+        return SseFloat::sum(_mm_add_ps(lo(a), hi(a)));
+    }
+};
+
+struct AvxDouble {
+    using value_type = double;
+    using reg = __m256d;
+
+    static constexpr size_t width = 4;
+
+    static inline reg load(const double *ptr) noexcept {
+        return _mm256_loadu_pd(ptr);
+    }
+
+    static inline void store(double *ptr, reg value) noexcept {
+        _mm256_storeu_pd(ptr, value);
+    }
+
+    template <size_t Count>
+    static inline reg load_partial(const double *ptr) noexcept {
+        return _impl::load_halves<AvxDouble, SseDouble, Count>(ptr);
+    }
+
+    template <size_t Count>
+    static inline void store_partial(double *ptr, reg value) noexcept {
+        _impl::store_halves<AvxDouble, SseDouble, Count>(ptr, value);
+    }
+
+    static inline reg join(__m128d lo, __m128d hi) noexcept {
+        return _mm256_insertf128_pd(_mm256_castpd128_pd256(lo), hi, 1);
+    }
+
+    static inline __m128d lo(reg value) noexcept {
+        return _mm256_castpd256_pd128(value);
+    }
+
+    static inline __m128d hi(reg value) noexcept {
+        return _mm256_extractf128_pd(value, 1);
+    }
+
+    static inline reg splat(double value) noexcept {
+        return _mm256_set1_pd(value);
+    }
+
+    static inline reg zero() noexcept {
+        return _mm256_setzero_pd();
+    }
+
+    static inline reg add(reg a, reg b) noexcept {
+        return _mm256_add_pd(a, b);
+    }
+
+    static inline reg sub(reg a, reg b) noexcept {
+        return _mm256_sub_pd(a, b);
+    }
+
+    static inline reg mul(reg a, reg b) noexcept {
+        return _mm256_mul_pd(a, b);
+    }
+
+    static inline reg div(reg a, reg b) noexcept {
+        return _mm256_div_pd(a, b);
+    }
+
+    static inline double sum(reg a) noexcept {
+        return SseDouble::sum(_mm_add_pd(lo(a), hi(a)));
+    }
+};
 #endif
 
+/// The instruction set to pack N values of T with, or void if there's none
+template <typename T, size_t N>
+struct SimdFor {
+    using type = void;
+};
+
+#if MATH_TEST_USE_SSE2_
+// Vectors too short to fill an AVX register are better off with SSE,
+// so that their tails don't have to be padded as much
+template <size_t N>
+struct SimdFor<float, N> {
+    #if MATH_TEST_USE_AVX_
+    using type = std::conditional_t<N >= AvxFloat::width, AvxFloat, SseFloat>;
+    #else
+    using type = SseFloat;
+    #endif
+};
+
+template <size_t N>
+struct SimdFor<double, N> {
+    #if MATH_TEST_USE_AVX_
+    using type = std::conditional_t<N >= AvxDouble::width, AvxDouble, SseDouble>;
+    #else
+    using type = SseDouble;
+    #endif
+};
+#endif
+
+template <typename T, size_t N>
+using simd_for_t = typename SimdFor<T, N>::type;
+
+template <typename T, size_t N>
+constexpr size_t simd_width_v = 0;
 
 template <typename T, size_t N>
-requires (std::signed_integral<T> || std::floating_point<T>)
+requires (!std::is_void_v<simd_for_t<T, N>>)
+constexpr size_t simd_width_v<T, N> = simd_for_t<T, N>::width;
+
+/**
+ * Vectors that don't fill even a single register are left to the scalar code:
+ * shuffling their elements in and out of one costs more than it saves,
+ * and the compiler vectorizes the surrounding loops better without it.
+ */
+template <typename T, size_t N>
+constexpr bool has_simd_v = simd_width_v<T, N> != 0 && N >= simd_width_v<T, N>;
+
+
+template <typename Op, typename Isa, size_t N>
+inline void simd_zip(typename Isa::value_type *dst,
+                     const typename Isa::value_type *a,
+                     const typename Isa::value_type *b) noexcept {
+    constexpr size_t width = Isa::width;
+    constexpr size_t full = N / width;
+    constexpr size_t tail = N % width;
+
+    unroll<full>([&](size_t i) {
+        Isa::store(dst + i * width, Op::template apply_simd<Isa>(Isa::load(a + i * width),
+                                                                 Isa::load(b + i * width)));
+    });
+
+    if constexpr (tail != 0) {
+        constexpr size_t offset = full * width;
+
+        Isa::template store_partial<tail>(dst + offset, Op::template apply_simd<Isa>(
+            Isa::template load_partial<tail>(a + offset), Isa::template load_partial<tail>(b + offset)));
+    }
+}
+
+template <typename Op, typename Isa, size_t N>
+inline void simd_zip_scalar(typename Isa::value_type *dst,
+                            const typename Isa::value_type *a,
+                            typename Isa::value_type b) noexcept {
+    constexpr size_t width = Isa::width;
+    constexpr size_t full = N / width;
+    constexpr size_t tail = N % width;
+
+    const typename Isa::reg splat = Isa::splat(b);
+
+    unroll<full>([&](size_t i) {
+        Isa::store(dst + i * width, Op::template apply_simd<Isa>(Isa::load(a + i * width), splat));
+    });
+
+    if constexpr (tail != 0) {
+        constexpr size_t offset = full * width;
+
+        Isa::template store_partial<tail>(dst + offset, Op::template apply_simd<Isa>(
+            Isa::template load_partial<tail>(a + offset), splat));
+    }
+}
+
+template <typename Isa, size_t N>
+inline typename Isa::value_type simd_dot(const typename Isa::value_type *a,
+                                         const typename Isa::value_type *b) noexcept {
+    constexpr size_t width = Isa::width;
+    constexpr size_t full = N / width;
+    constexpr size_t tail = N % width;
+
+    typename Isa::reg acc = Isa::zero();
+
+    unroll<full>([&](size_t i) {
+        acc = Isa::add(acc, Isa::mul(Isa::load(a + i * width), Isa::load(b + i * width)));
+    });
+
+    // The padding lanes are zero on both sides, so they don't affect the sum
+    if constexpr (tail != 0) {
+        constexpr size_t offset = full * width;
+
+        acc = Isa::add(acc, Isa::mul(Isa::template load_partial<tail>(a + offset),
+                                     Isa::template load_partial<tail>(b + offset)));
+    }
+
+    return Isa::sum(acc);
+}
+#pragma endregion SIMD
+
+
+}
+
+
+#pragma region Kernels
+/**
+ * The original formulation: peel one element off and recurse on the rest.
+ */
+struct RecursiveKernel {
+    template <typename Op, typename T, size_t N>
+    static constexpr void zip(T *dst, const T *a, const T *b) noexcept {
+        if constexpr (N != 0) {
+            *dst = Op::apply(*a, *b);
+            zip<Op, T, N - 1>(dst + 1, a + 1, b + 1);
+        }
+    }
+
+    template <typename Op, typename T, size_t N>
+    static constexpr void zip_scalar(T *dst, const T *a, T b) noexcept {
+        if constexpr (N != 0) {
+            *dst = Op::apply(*a, b);
+            zip_scalar<Op, T, N - 1>(dst + 1, a + 1, b);
+        }
+    }
+
+    template <typename T, size_t N>
+    static constexpr T dot(const T *a, const T *b) noexcept {
+        if constexpr (N == 0) {
+            return T{};
+        } else {
+            return *a * *b + dot<T, N - 1>(a + 1, b + 1);
+        }
+    }
+};
+
+/**
+ * The same thing, expanded over an index sequence with fold expressions.
+ */
+struct FoldKernel {
+    template <typename Op, typename T, size_t N>
+    static constexpr void zip(T *dst, const T *a, const T *b) noexcept {
+        _impl::unroll<N>([&](size_t i) {
+            dst[i] = Op::apply(a[i], b[i]);
+        });
+    }
+
+    template <typename Op, typename T, size_t N>
+    static constexpr void zip_scalar(T *dst, const T *a, T b) noexcept {
+        _impl::unroll<N>([&](size_t i) {
+            dst[i] = Op::apply(a[i], b);
+        });
+    }
+
+    template <typename T, size_t N>
+    static constexpr T dot(const T *a, const T *b) noexcept {
+        return [&]<size_t ... Is>(std::index_sequence<Is...>) {
+            return ((a[Is] * b[Is]) + ... + T{});
+        }(std::make_index_sequence<N>());
+    }
+};
+
+/**
+ * Packs float and double vectors into SSE/AVX registers, with the tail padded
+ * to a whole register. Anything else, including vectors shorter than
+ * a register and constant evaluation, goes through FoldKernel instead.
+ *
+ * @note The lanes are summed up in a different order than by the scalar kernels,
+ *       so floating-point dot products may differ from theirs in the last bits
+ */
+struct SimdKernel {
+    template <typename Op, typename T, size_t N>
+    static constexpr void zip(T *dst, const T *a, const T *b) noexcept {
+        if constexpr (_impl::has_simd_v<T, N>) {
+            if (!std::is_constant_evaluated()) {
+                _impl::simd_zip<Op, _impl::simd_for_t<T, N>, N>(dst, a, b);
+                return;
+            }
+        }
+
+        FoldKernel::zip<Op, T, N>(dst, a, b);
+    }
+
+    template <typename Op, typename T, size_t N>
+    static constexpr void zip_scalar(T *dst, const T *a, T b) noexcept {
+        if constexpr (_impl::has_simd_v<T, N>) {
+            if (!std::is_constant_evaluated()) {
+                _impl::simd_zip_scalar<Op, _impl::simd_for_t<T, N>, N>(dst, a, b);
+                return;
+            }
+        }
+
+        FoldKernel::zip_scalar<Op, T, N>(dst, a, b);
+    }
+
+    template <typename T, size_t N>
+    static constexpr T dot(const T *a, const T *b) noexcept {
+        if constexpr (_impl::has_simd_v<T, N>) {
+            if (!std::is_constant_evaluated()) {
+                return _impl::simd_dot<_impl::simd_for_t<T, N>, N>(a, b);
+            }
+        }
+
+        return FoldKernel::dot<T, N>(a, b);
+    }
+};
+#pragma endregion Kernels
+
+
+#pragma region Vector
+template <typename T, size_t N, typename Kernel = SimdKernel>
+requires scalar<T>
 struct Vector {
+    using value_type = T;
+    using kernel_type = Kernel;
+
     static constexpr size_t size = N;
 
     T data[N];
 
 
-    T operator *(const Vector &other) {
-        static_assert(size == other.size,
-                      "I must have misunderstood how implicit template args work");
+    static constexpr Vector filled(T value) noexcept {
+        Vector result{};
 
-        #ifndef MATH_TEST_COOLER_DOT_PRODUCT
-        return _dot_product<T, N>(data, other.data);
-        #else
-        return [&]<size_t ... Ns>(std::index_sequence<Ns...>) {
-            return ((data[Ns] * other.data[Ns]) + ...);
-        }(std::make_index_sequence<N>());
-        #endif
+        _impl::unroll<N>([&](size_t i) {
+            result.data[i] = value;
+        });
+
+        return result;
+    }
+
+    constexpr T &operator[](size_t idx) noexcept {
+        return data[idx];
     }
 
+    constexpr const T &operator[](size_t idx) const noexcept {
+        return data[idx];
+    }
+
+    constexpr Vector &operator+=(const Vector &other) noexcept {
+        Kernel::template zip<_impl::Add, T, N>(data, data, other.data);
+
+        return *this;
+    }
+
+    constexpr Vector &operator-=(const Vector &other) noexcept {
+        Kernel::template zip<_impl::Sub, T, N>(data, data, other.data);
+
+        return *this;
+    }
+
+    constexpr Vector &operator*=(T factor) noexcept {
+        Kernel::template zip_scalar<_impl::Mul, T, N>(data, data, factor);
+
+        return *this;
+    }
+
+    constexpr Vector &operator/=(T divisor) noexcept {
+        Kernel::template zip_scalar<_impl::Div, T, N>(data, data, divisor);
+
+        return *this;
+    }
+
+    friend constexpr Vector operator+(Vector a, const Vector &b) noexcept {
+        return a += b;
+    }
+
+    friend constexpr Vector operator-(Vector a, const Vector &b) noexcept {
+        return a -= b;
+    }
+
+    friend constexpr Vector operator*(Vector a, T factor) noexcept {
+        return a *= factor;
+    }
+
+    friend constexpr Vector operator*(T factor, Vector a) noexcept {
+        return a *= factor;
+    }
+
+    friend constexpr Vector operator/(Vector a, T divisor) noexcept {
+        return a /= divisor;
+    }
+
+    constexpr Vector operator-() const noexcept {
+        return Vector{} - *this;
+    }
+
+    /// The dot product
+    constexpr T operator*(const Vector &other) const noexcept {
+        return Kernel::template dot<T, N>(data, other.data);
+    }
+
+    constexpr bool operator==(const Vector &other) const noexcept = default;
+
+    constexpr T length_sq() const noexcept {
+        return *this * *this;
+    }
+
+    T length() const noexcept requires std::floating_point<T> {
+        return std::sqrt(length_sq());
+    }
+
+    /// Undefined for the zero vector, just like division by zero
+    Vector normalized() const noexcept requires std::floating_point<T> {
+        return *this * (T{1} / length());
+    }
+
+};
+
+
+/// The element-wise product
+template <typename T, size_t N, typename Kernel>
+constexpr Vector<T, N, Kernel> hadamard(const Vector<T, N, Kernel> &a, const Vector<T, N, Kernel> &b) noexcept {
+    Vector<T, N, Kernel> result{};
+    Kernel::template zip<_impl::Mul, T, N>(result.data, a.data, b.data);
+
+    return result;
+}
+
+template <typename T, typename Kernel>
+constexpr Vector<T, 3, Kernel> cross(const Vector<T, 3, Kernel> &a, const Vector<T, 3, Kernel> &b) noexcept {
+    return {
+        a[1] * b[2] - a[2] * b[1],
+        a[2] * b[0] - a[0] * b[2],
+        a[0] * b[1] - a[1] * b[0],
+    };
+}
+#pragma endregion Vector
+
+
+#pragma region Matrix
+/**
+ * A row-major matrix. Products are expressed through row operations,
+ * so they are vectorized just as well as the rows themselves.
+ */
+template <typename T, size_t R, size_t C, typename Kernel = SimdKernel>
+requires scalar<T>
+struct Matrix {
+    using value_type = T;
+    using kernel_type = Kernel;
+    using row_type = Vector<T, C, Kernel>;
+    using column_type = Vector<T, R, Kernel>;
+
+    static constexpr size_t rows = R;
+    static constexpr size_t cols = C;
+
+    row_type data[R];
+
+
+    static constexpr Matrix identity() noexcept requires (R == C) {
+        Matrix result{};
+
+        _impl::unroll<R>([&](size_t i) {
+            result.data[i][i] = T{1};
+        });
+
+        return result;
+    }
+
+    constexpr row_type &operator[](size_t row) noexcept {
+        return data[row];
+    }
+
+    constexpr const row_type &operator[](size_t row) const noexcept {
+        return data[row];
+    }
+
+    constexpr T &operator()(size_t row, size_t col) noexcept {
+        return data[row][col];
+    }
+
+    constexpr const T &operator()(size_t row, size_t col) const noexcept {
+        return data[row][col];
+    }
+
+    constexpr Matrix<T, C, R, Kernel> transposed() const noexcept {
+        Matrix<T, C, R, Kernel> result{};
+
+        _impl::unroll<R>([&](size_t i) {
+            _impl::unroll<C>([&](size_t j) {
+                result.data[j][i] = data[i][j];
+            });
+        });
+
+        return result;
+    }
+
+    constexpr Matrix &operator+=(const Matrix &other) noexcept {
+        _impl::unroll<R>([&](size_t i) {
+            data[i] += other.data[i];
+        });
+
+        return *this;
+    }
+
+    constexpr Matrix &operator-=(const Matrix &other) noexcept {
+        _impl::unroll<R>([&](size_t i) {
+            data[i] -= other.data[i];
+        });
+
+        return *this;
+    }
+
+    constexpr Matrix &operator*=(T factor) noexcept {
+        _impl::unroll<R>([&](size_t i) {
+            data[i] *= factor;
+        });
+
+        return *this;
+    }
+
+    friend constexpr Matrix operator+(Matrix a, const Matrix &b) noexcept {
+        return a += b;
+    }
+
+    friend constexpr Matrix operator-(Matrix a, const Matrix &b) noexcept {
+        return a -= b;
+    }
+
+    friend constexpr Matrix operator*(Matrix a, T factor) noexcept {
+        return a *= factor;
+    }
+
+    friend constexpr Matrix operator*(T factor, Matrix a) noexcept {
+        return a *= factor;
+    }
+
+    friend constexpr column_type operator*(const Matrix &m, const row_type &v) noexcept {
+        column_type result{};
+
+        _impl::unroll<R>([&](size_t i) {
+            result[i] = m.data[i] * v;
+        });
+
+        return result;
+    }
+
+    /// Each row of the result is a combination of other's rows
+    template <size_t K>
+    friend constexpr Matrix<T, R, K, Kernel> operator*(const Matrix &m, const Matrix<T, C, K, Kernel> &other) noexcept {
+        Matrix<T, R, K, Kernel> result{};
+
+        _impl::unroll<R>([&](size_t i) {
+            _impl::unroll<C>([&](size_t j) {
+                result.data[i] += other.data[j] * m.data[i][j];
+            });
+        });
+
+        return result;
+    }
+
+    constexpr bool operator==(const Matrix &other) const noexcept = default;
+
 };
+#pragma endregion Matrix
 
 
 }
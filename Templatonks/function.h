@@ -12,116 +12,342 @@
 #include <new>
 #include <bit>
 #include <typeinfo>
+#include <cstring>
+#include <utility>
+#include "refcount.h"
 
 
 namespace mylib {
 
 
-template <typename T>
+/// The default inline capacity keeps the whole Function at 8 pointers
+constexpr size_t default_func_inline_size = 6 * sizeof(void *);
+
+/**
+ * With Copyable = false, the targets only have to be movable, and so does the function.
+ * Targets of up to InlineSize bytes, aligned to at most InlineAlign, are stored inline.
+ * Allocator provides the memory for the rest.
+ */
+template <typename T, bool Copyable = true,
+          size_t InlineSize = default_func_inline_size, size_t InlineAlign = alignof(void *),
+          typename Allocator = std::allocator<std::byte>>
 class Function;
 
+template <typename T,
+          size_t InlineSize = default_func_inline_size, size_t InlineAlign = alignof(void *),
+          typename Allocator = std::allocator<std::byte>>
+using MoveFunction = Function<T, false, InlineSize, InlineAlign, Allocator>;
+
+template <typename T>
+class FunctionRef;
 
-// TODO: Maybe also optimize for a shared ICallable
 
+namespace _impl {
 
-template <typename R, typename ... As>
-class Function<R (As...)> {
+/// What a type-erased call is made on: an object, or a plain function
+union CallTarget {
+    const void *obj;
+    void (*func)();
+};
+
+template <typename T, typename Sig>
+constexpr bool is_function_of_v = false;
+
+template <typename Sig, bool Copyable, size_t InlineSize, size_t InlineAlign, typename Allocator>
+constexpr bool is_function_of_v<Function<Sig, Copyable, InlineSize, InlineAlign, Allocator>, Sig> = true;
+
+/// std::invoke, converting the result to R (or discarding it, for R = void)
+template <typename R, typename F, typename ... As>
+constexpr R invoke_r(F &&functor, As &&... args) {
+    if constexpr (std::is_void_v<R>) {
+        std::invoke(std::forward<F>(functor), std::forward<As>(args)...);
+    } else {
+        return std::invoke(std::forward<F>(functor), std::forward<As>(args)...);
+    }
+}
+
+}
+
+
+/**
+ * A type-erased callable, like std::function (or, with Copyable = false,
+ * like std::move_only_function). Targets that fit in
+ * small_func_size bytes (and can be moved without throwing) are stored inline,
+ * the rest are allocated on the heap, through Allocator.
+ * Dispatch goes through a constant table of function pointers, one per target type,
+ * rather than through virtual methods. Moving a heap target, or an inline one that
+ * is trivially copyable, is just a memcpy of the storage.
+ */
+template <typename R, typename ... As, bool Copyable, size_t InlineSize, size_t InlineAlign, typename Allocator>
+class Function<R (As...), Copyable, InlineSize, InlineAlign, Allocator> {
 public:
     #pragma region Aliases & etc.
     using result_type = R;
+    using allocator_type = Allocator;
+
+    /// The storage holds a pointer anyway, so there's always at least that much room
+    static constexpr size_t small_func_size = std::max(InlineSize, sizeof(void *));
     #pragma endregion Aliases & etc.
 
     #pragma region Protected helpers
 protected:
-    static constexpr size_t small_func_size = 63;
+    static_assert(std::has_single_bit(InlineAlign), "Alignment must be a power of two");
+
+    union Storage {
+        void *ptr;
+        alignas(InlineAlign) uint8_t buf[small_func_size];
+    };
+
+    using invoke_type = R (*)(_impl::CallTarget storage, As &&... args);
+
+    /**
+     * The operations on one type of target, except for invoking it: that one
+     * is kept in the object itself, to save calls a dependent load.
+     * A null copy or relocate means a plain memcpy of the storage does the job,
+     * and a null destroy means there's nothing to do. Move-only functions
+     * never copy, so their copy is always null.
+     */
+    struct VTable {
+        void (*copy)(const Storage &from, Storage &to);
+        void (*relocate)(Storage &from, Storage &to) noexcept;
+        void (*destroy)(Storage &storage) noexcept;
+        void *(*target)(const Storage &storage) noexcept;
+        const std::type_info &(*target_type)() noexcept;
+        bool is_small;
+        bool is_shared;
+    };
+
+    template <typename F>
+    static constexpr bool fits_small = sizeof(F) <= small_func_size &&
+                                       alignof(F) <= alignof(Storage) &&
+                                       std::is_nothrow_move_constructible_v<F>;
+
+    #pragma region Handlers
+    /// Lets empty functions be called without checking for them first
+    static R _invoke_empty(_impl::CallTarget, As &&...) {
+        throw std::bad_function_call();
+    }
+
+    template <typename F, bool Small = fits_small<F>>
+    struct Handler;
+
+    /// Only mentions Handler::copy when it's needed, since move-only targets can't have one
+    template <typename Handler_>
+    static constexpr decltype(VTable::copy) _copy_entry() {
+        if constexpr (!Copyable || Handler_::is_trivial) {
+            return nullptr;
+        } else {
+            return &Handler_::copy;
+        }
+    }
+
+    template <typename F>
+    struct Handler<F, true> {
+        static constexpr bool is_trivial = std::is_trivially_copyable_v<F>;
+
 
-    #pragma region Callable classes
-    class ICallable {
-    public:
-        virtual R operator()(As ... args) = 0;
-        virtual void copy_to(Function &new_host) const = 0;
-        virtual void move_to(Function &new_host, Function &old_host) = 0;
-        virtual const std::type_info &target_type() const = 0;
-        virtual void *target() = 0;
+        static inline F *get(const Storage &storage) noexcept {
+            return std::launder(reinterpret_cast<F *>(const_cast<uint8_t *>(storage.buf)));
+        }
+
+        template <typename F_>
+        static void create(Storage &storage, const Allocator &, F_ &&functor) {
+            new (storage.buf) F(std::forward<F_>(functor));
+        }
 
-        virtual ~ICallable() = default;
+        static R invoke(_impl::CallTarget storage, As &&... args) {
+            return _impl::invoke_r<R>(*get(*static_cast<const Storage *>(storage.obj)), std::forward<As>(args)...);
+        }
+
+        static void copy(const Storage &from, Storage &to) {
+            new (to.buf) F(*get(from));
+        }
 
-        inline const void *target() const {
-            return const_cast<ICallable *>(this)->target();
+        static void relocate(Storage &from, Storage &to) noexcept {
+            new (to.buf) F(std::move(*get(from)));
+            get(from)->~F();
         }
+
+        static void destroy(Storage &storage) noexcept {
+            get(storage)->~F();
+        }
+
+        static void *target(const Storage &storage) noexcept {
+            return get(storage);
+        }
+
+        static const std::type_info &target_type() noexcept {
+            return typeid(F);
+        }
+
+        static constexpr VTable vtable{
+            _copy_entry<Handler>(),
+            is_trivial ? nullptr : &relocate,
+            std::is_trivially_destructible_v<F> ? nullptr : &destroy,
+            &target,
+            &target_type,
+            true,
+            false
+        };
     };
 
-    friend ICallable;
+    template <typename F>
+    struct Handler<F, false> {
+        // Copying the pointer wouldn't do, while moving it would
+        static constexpr bool is_trivial = false;
+
+        // The allocator travels with the target, so that copies and destruction can get to it
+        struct Block {
+            [[no_unique_address]] Allocator allocator;
+            F functor;
+        };
 
-    struct Empty {
-        inline explicit Empty(uint8_t = 0) {}
-    } alignas(1);
+        using block_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Block>;
+        using block_traits = std::allocator_traits<block_allocator>;
 
-    template <typename F, bool Small>
-    class FunctorCallable : public ICallable {
-    public:
-        FunctorCallable(F functor) noexcept(std::is_nothrow_move_constructible_v<F>) :
-            functor{std::move(functor)} {}
 
-        virtual R operator()(As ... args) override {
-            return std::move(functor)(std::forward<As>(args)...);
+        static inline Block *get_block(const Storage &storage) noexcept {
+            return static_cast<Block *>(storage.ptr);
         }
 
-        virtual void copy_to(Function &new_host) const override {
-            if (new_host.get_ptr() == this) {
-                return;
-            }
+        static inline F *get(const Storage &storage) noexcept {
+            return &get_block(storage)->functor;
+        }
 
-            new_host = nullptr;
+        template <typename F_>
+        static void create(Storage &storage, const Allocator &allocator, F_ &&functor) {
+            block_allocator block_alloc(allocator);
+            Block *block = block_traits::allocate(block_alloc, 1);
 
-            if constexpr (Small) {
-                // static_assert(sizeof(*this) <= small_func_size,
-                //               "Only small functors should be marked");
+            abel::Defer release_block_on_error([&block_alloc, &block]() {
+                if (block) {
+                    block_traits::deallocate(block_alloc, block, 1);
+                }
+            });
 
-                new (new_host.buf_) FunctorCallable(functor);
-            } else {
-                new_host.ptr_ = new FunctorCallable(functor);
-            }
+            new (block) Block{allocator, F(std::forward<F_>(functor))};
 
-            new_host.is_small(Small);
+            storage.ptr = block;
+            block = nullptr;
         }
 
-        virtual void move_to(Function &new_host, Function &old_host) override {
-            if (new_host.get_ptr() == this) {
-                return;
-            }
+        static R invoke(_impl::CallTarget storage, As &&... args) {
+            return _impl::invoke_r<R>(*get(*static_cast<const Storage *>(storage.obj)), std::forward<As>(args)...);
+        }
 
-            new_host = nullptr;
+        static void copy(const Storage &from, Storage &to) {
+            const Block *block = get_block(from);
 
-            if constexpr (Small) {
-                // static_assert(sizeof(*this) <= small_func_size,
-                //               "Only small functors should be marked");
+            create(to, block->allocator, block->functor);
+        }
 
-                new (new_host.buf_) FunctorCallable(std::move(functor));
-            } else {
-                new_host.ptr_ = this;
-                old_host.ptr_ = nullptr;
-            }
+        static void destroy(Storage &storage) noexcept {
+            Block *block = get_block(storage);
+            block_allocator block_alloc(block->allocator);
 
-            new_host.is_small(Small);
+            block->~Block();
+            block_traits::deallocate(block_alloc, block, 1);
+        }
 
-            old_host = nullptr;
+        static void *target(const Storage &storage) noexcept {
+            return get(storage);
         }
 
-        virtual const std::type_info &target_type() const override {
+        static const std::type_info &target_type() noexcept {
             return typeid(F);
         }
 
-        virtual void *target() override {
-            return &functor;
+        // The pointer is all there is to relocate
+        static constexpr VTable vtable{
+            _copy_entry<Handler>(),
+            nullptr,
+            &destroy,
+            &target,
+            &target_type,
+            false,
+            false
+        };
+    };
+
+    /// A heap target that is never modified, so that copies can share it
+    template <typename F, RefCountPolicy RefCount>
+    struct SharedHandler {
+        struct Block {
+            [[no_unique_address]] Allocator allocator;
+            RefCount ref_cnt;
+            const F functor;
+        };
+
+        using block_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Block>;
+        using block_traits = std::allocator_traits<block_allocator>;
+
+
+        static inline Block *get(const Storage &storage) noexcept {
+            return static_cast<Block *>(storage.ptr);
         }
 
-    protected:
-        [[no_unique_address]] F functor{};
+        template <typename F_>
+        static void create(Storage &storage, const Allocator &allocator, F_ &&functor) {
+            block_allocator block_alloc(allocator);
+            Block *block = block_traits::allocate(block_alloc, 1);
+
+            abel::Defer release_block_on_error([&block_alloc, &block]() {
+                if (block) {
+                    block_traits::deallocate(block_alloc, block, 1);
+                }
+            });
+
+            new (block) Block{allocator, {}, F(std::forward<F_>(functor))};
+            block->ref_cnt.acquire();
+
+            storage.ptr = block;
+            block = nullptr;
+        }
+
+        static R invoke(_impl::CallTarget storage, As &&... args) {
+            return _impl::invoke_r<R>(get(*static_cast<const Storage *>(storage.obj))->functor,
+                                      std::forward<As>(args)...);
+        }
+
+        static void copy(const Storage &from, Storage &to) {
+            get(from)->ref_cnt.acquire();
+            to.ptr = from.ptr;
+        }
+
+        static void destroy(Storage &storage) noexcept {
+            Block *block = get(storage);
+
+            if (block->ref_cnt.release()) {
+                block_allocator block_alloc(block->allocator);
+
+                block->~Block();
+                block_traits::deallocate(block_alloc, block, 1);
+            }
+        }
+
+        static void *target(const Storage &storage) noexcept {
+            return const_cast<F *>(&get(storage)->functor);
+        }
+
+        static const std::type_info &target_type() noexcept {
+            return typeid(F);
+        }
+
+        static constexpr VTable vtable{
+            &copy,
+            nullptr,
+            &destroy,
+            &target,
+            &target_type,
+            false,
+            true
+        };
     };
+    #pragma endregion Handlers
 
-    friend FunctorCallable;
-    #pragma endregion Callable classes
+    // Borrows invoke_ and the storage, to call the target directly
+    template <typename T>
+    friend class FunctionRef;
 
 public:
     #pragma endregion Protected helpers
@@ -131,112 +357,107 @@ public:
 
     Function(std::nullptr_t) noexcept {}
 
-    Function(const Function &other) :
+    Function(const Function &other) requires Copyable :
         Function() {
-        *this = other;
-    }
-
-    Function &operator=(std::nullptr_t) {
-        this->~Function();
-        ptr_ = nullptr;
-        is_small(false);
-
-        return *this;
-    }
 
-    Function &operator=(const Function &other) {
-        if (&other == this) {
-            return *this;
+        if (!other.vtable_) {
+            return;
         }
 
-        ICallable *other_func = other.get_ptr();
-
-        if (!other_func) {
-            return *this = nullptr;
+        if (other.vtable_->copy) {
+            other.vtable_->copy(other.storage_, storage_);
+        } else {
+            std::memcpy(&storage_, &other.storage_, sizeof(Storage));
         }
 
-        other_func->copy_to(*this);
-
-        return *this;
+        vtable_ = other.vtable_;
+        invoke_ = other.invoke_;
     }
 
-    Function(Function &&other) :
+    Function(Function &&other) noexcept :
         Function() {
-        *this = std::move(other);
+
+        _steal(other);
+    }
+
+    Function &operator=(std::nullptr_t) noexcept {
+        _reset();
+
+        return *this;
     }
 
-    Function &operator=(Function &&other) {
+    Function &operator=(const Function &other) requires Copyable {
         if (&other == this) {
             return *this;
         }
 
-        ICallable *other_func = other.get_ptr();
+        // Copying first leaves this intact if the copy throws
+        return *this = Function(other);
+    }
 
-        if (!other_func) {
-            return *this = nullptr;
+    Function &operator=(Function &&other) noexcept {
+        if (&other == this) {
+            return *this;
         }
 
-        other_func->move_to(*this, other);
+        _reset();
+        _steal(other);
 
         return *this;
     }
 
     template <typename F>
+    requires (!std::same_as<std::remove_cvref_t<F>, Function>)
     Function &operator=(F &&functor) {
-        this->~Function();
+        return *this = Function(std::forward<F>(functor));
+    }
 
-        new (this) Function(std::forward<F>(functor));
+    template <typename F>
+    requires (!std::same_as<std::remove_cvref_t<F>, Function> &&
+              (!Copyable || std::copy_constructible<std::decay_t<F>>))
+    Function(F &&functor) :
+        Function(std::allocator_arg, Allocator(), std::forward<F>(functor)) {}
 
-        return *this;
+    /// The allocator is only used if the target doesn't fit inline
+    template <typename F>
+    requires (!std::same_as<std::remove_cvref_t<F>, Function> &&
+              (!Copyable || std::copy_constructible<std::decay_t<F>>))
+    Function(std::allocator_arg_t, const Allocator &allocator, F &&functor) {
+        _create<Handler<std::decay_t<F>>>(allocator, std::forward<F>(functor));
     }
 
-    template <typename F>
-    requires (!std::same_as<std::remove_reference_t<F>, Function>)
-    Function(F &&functor) {
-        if constexpr (sizeof(FunctorCallable<std::remove_reference_t<F>, true>) <= small_func_size) {
-            new (buf_) FunctorCallable<std::remove_reference_t<F>, true >(std::forward<F>(functor));
-            is_small(true);
-        } else {
-            ptr_ = new FunctorCallable<std::remove_reference_t<F>, false>(std::forward<F>(functor));
-            is_small(false);
-        }
+    /**
+     * Puts the target on the heap once, to be shared by every copy of the result,
+     * so that copying it only takes a reference count bump, however big the target.
+     * The target is never modified afterwards, and so must be callable as const.
+     * With AtomicRefCount, the copies may be made and destroyed on different threads.
+     */
+    template <RefCountPolicy RefCount = PlainRefCount, typename F>
+    requires (Copyable && std::copy_constructible<std::decay_t<F>> &&
+              std::is_invocable_r_v<R, const std::decay_t<F> &, As...>)
+    static Function shared(F &&functor, const Allocator &allocator = Allocator()) {
+        Function result{};
+        result._create<SharedHandler<std::decay_t<F>, RefCount>>(allocator, std::forward<F>(functor));
+
+        return result;
     }
     #pragma endregion Constructors
 
     #pragma region Destructor
     ~Function() {
-        ICallable *func = get_ptr();
-
-        if (!func) {
-            return;
-        }
-
-        if (is_small()) {
-            func->~ICallable();
-            return;
-        }
-
-        delete func;
-
-        ptr_ = nullptr;
+        _reset();
     }
     #pragma endregion Destructor
 
     #pragma region Call
     R operator()(As ... args) const {
-        ICallable *func = get_ptr();
-
-        if (!func) {
-            throw std::bad_function_call();
-        }
-
-        return (*func)(std::forward<As>(args)...);
+        return invoke_(_impl::CallTarget{.obj = &storage_}, std::forward<As>(args)...);
     }
     #pragma endregion Call
 
     #pragma region Basic information
     explicit operator bool() const noexcept {
-        return get_ptr() != nullptr;
+        return vtable_ != nullptr;
     }
 
     inline friend bool operator==(const Function &self, nullptr_t) {
@@ -248,34 +469,32 @@ public:
     }
 
     constexpr bool is_small() const {
-        return buf_[small_func_size];
+        return vtable_ && vtable_->is_small;
+    }
+
+    /// Whether the target is shared with the copies, see shared()
+    constexpr bool is_shared() const {
+        return vtable_ && vtable_->is_shared;
     }
     #pragma endregion Basic information
 
     #pragma region Target
     const std::type_info &target_type() const noexcept {
-        ICallable *func = get_ptr();
-
-        if (!func) {
+        if (!vtable_) {
             return typeid(void);
         }
 
-        return func->target_type();
+        return vtable_->target_type();
     }
 
+    /// A shared target must not be modified through the result
     template <typename T>
     T *target() noexcept {
-        ICallable *func = get_ptr();
-
-        if (!func) {
-            return nullptr;
-        }
-
-        if (typeid(T) != func->target_type()) {
+        if (!vtable_ || typeid(T) != vtable_->target_type()) {
             return nullptr;
         }
 
-        return reinterpret_cast<T *>(func->target());
+        return static_cast<T *>(vtable_->target(storage_));
     }
 
     template <typename T>
@@ -286,30 +505,125 @@ public:
 
 protected:
     #pragma region Fields
-    union {
-        alignas(sizeof(void *)) ICallable *ptr_;
-        alignas(sizeof(void *)) mutable uint8_t buf_[small_func_size + 1] = {};
-    };
+    const VTable *vtable_ = nullptr;
+    invoke_type invoke_ = &_invoke_empty;
+    Storage storage_;
     #pragma endregion Fields
 
 
     #pragma region Protected interface
-    ICallable *get_ptr() const {
-        if (is_small()) {
-            return reinterpret_cast<ICallable *>(buf_);
+    /// Must be empty beforehand
+    template <typename Handler_, typename F>
+    void _create(const Allocator &allocator, F &&functor) {
+        assert(!vtable_);
+
+        Handler_::create(storage_, allocator, std::forward<F>(functor));
+        vtable_ = &Handler_::vtable;
+        invoke_ = &Handler_::invoke;
+    }
+
+    void _reset() noexcept {
+        if (!vtable_) {
+            return;
+        }
+
+        if (vtable_->destroy) {
+            vtable_->destroy(storage_);
         }
 
-        return ptr_;
+        vtable_ = nullptr;
+        invoke_ = &_invoke_empty;
     }
 
-    constexpr void is_small(bool value) {
-        buf_[small_func_size] = value;
+    /// Must be empty beforehand
+    void _steal(Function &other) noexcept {
+        assert(!vtable_);
+
+        if (!other.vtable_) {
+            return;
+        }
+
+        if (other.vtable_->relocate) {
+            other.vtable_->relocate(other.storage_, storage_);
+        } else {
+            std::memcpy(&storage_, &other.storage_, sizeof(Storage));
+        }
+
+        vtable_ = std::exchange(other.vtable_, nullptr);
+        invoke_ = std::exchange(other.invoke_, &_invoke_empty);
     }
     #pragma endregion Protected interface
 
 };
 
 
+#pragma region FunctionRef
+/**
+ * A non-owning reference to a callable, for callbacks that are only called
+ * before the function receiving them returns. It's two pointers, trivially
+ * copyable, never allocates, and each call is a single indirect one.
+ * The callable must outlive the reference, so references are best taken
+ * as parameters, rather than stored.
+ */
+template <typename R, typename ... As>
+class FunctionRef<R (As...)> {
+public:
+    using result_type = R;
+
+
+    template <typename F>
+    requires (!std::same_as<std::remove_cvref_t<F>, FunctionRef> &&
+              !_impl::is_function_of_v<std::remove_cvref_t<F>, R (As...)> &&
+              !std::is_function_v<std::remove_pointer_t<std::remove_cvref_t<F>>> &&
+              std::is_invocable_r_v<R, std::remove_reference_t<F> &, As...>)
+    FunctionRef(F &&functor) noexcept :
+        target_{.obj = std::addressof(functor)},
+        invoke_{&_invoke_obj<std::remove_reference_t<F>>} {}
+
+    /// Functions are referred to by their address, so there's nothing to outlive
+    template <typename F>
+    requires std::is_function_v<F> && std::is_invocable_r_v<R, F &, As...>
+    FunctionRef(F *func) noexcept :
+        target_{.func = reinterpret_cast<void (*)()>(func)},
+        invoke_{&_invoke_func<F>} {
+
+        assert(func);
+    }
+
+    /// Calls the Function's target directly, rather than through the Function itself
+    template <bool Copyable, size_t InlineSize, size_t InlineAlign, typename Allocator>
+    FunctionRef(const Function<R (As...), Copyable, InlineSize, InlineAlign, Allocator> &func) noexcept :
+        target_{.obj = &func.storage_},
+        invoke_{func.invoke_} {}
+
+    FunctionRef(const FunctionRef &other) noexcept = default;
+    FunctionRef &operator=(const FunctionRef &other) noexcept = default;
+
+    R operator()(As ... args) const {
+        return invoke_(target_, std::forward<As>(args)...);
+    }
+
+protected:
+    using invoke_type = R (*)(_impl::CallTarget target, As &&... args);
+
+    _impl::CallTarget target_;
+    invoke_type invoke_;
+
+
+    template <typename F>
+    static R _invoke_obj(_impl::CallTarget target, As &&... args) {
+        return _impl::invoke_r<R>(*static_cast<F *>(const_cast<void *>(target.obj)), std::forward<As>(args)...);
+    }
+
+    template <typename F>
+    static R _invoke_func(_impl::CallTarget target, As &&... args) {
+        return _impl::invoke_r<R>(reinterpret_cast<F *>(target.func), std::forward<As>(args)...);
+    }
+
+};
+#pragma endregion FunctionRef
+
+
 #pragma region Deduction guides
 template<typename R, typename ... As>
 Function(Function<R (As...)> &) -> Function<R (As...)>;
@@ -352,6 +666,15 @@ using functor_call_type_t = typename functor_call_type<F>::type;
 template <typename F>
 Function(F f) -> Function<_impl::functor_call_type_t<decltype(&F::operator())>>;
 
+template<typename R, typename ... As, bool Copyable, size_t InlineSize, size_t InlineAlign, typename Allocator>
+FunctionRef(const Function<R (As...), Copyable, InlineSize, InlineAlign, Allocator> &) -> FunctionRef<R (As...)>;
+
+template<typename R, typename ... As>
+FunctionRef(R (*)(As...)) -> FunctionRef<R (As...)>;
+
+template <typename F>
+FunctionRef(F &&f) -> FunctionRef<_impl::functor_call_type_t<decltype(&std::remove_reference_t<F>::operator())>>;
+
 //template<typename ... As>
 //Function(std::invocable<As...> auto f) -> Function<std::invoke_result_t<decltype(f), As...> (As...)>;
 #pragma endregion Deduction guides
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <array>
+#include <concepts>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+
+#if defined(__AVX2__)
+#define HASH_USE_AVX2_ 1
+#else
+#define HASH_USE_AVX2_ 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HASH_USE_SSE2_ 1
+#else
+#define HASH_USE_SSE2_ 0
+#endif
+
+#if HASH_USE_AVX2_ || HASH_USE_SSE2_
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__SIZEOF_INT128__)
+#include <intrin.h>
+#endif
+
+
+/**
+ * A fast non-cryptographic byte hash. Inputs up to long_threshold bytes go
+ * through wyhash; longer ones are split into 64-byte stripes and folded into
+ * eight independent lanes, xxh3-style, which maps well onto SIMD registers.
+ * The result depends only on the bytes and the seed, and is the same on every
+ * code path (words are read in native byte order, though, so it isn't portable
+ * across endianness). Not suitable against adversarial inputs.
+ */
+namespace mylib::_impl::hash {
+
+
+constexpr uint64_t p0 = 0xa0761d6478bd642full;
+constexpr uint64_t p1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t p2 = 0x8ebc6af09c88c6e3ull;
+constexpr uint64_t p3 = 0x589965cc75374cc3ull;
+
+/// Inputs longer than this are hashed in stripes
+constexpr size_t long_threshold = 256;
+
+constexpr size_t lane_count = 8;
+constexpr size_t stripe_size = lane_count * sizeof(uint64_t);
+constexpr size_t stripes_per_block = 16;
+constexpr size_t block_size = stripe_size * stripes_per_block;
+
+/// Each stripe of a block is keyed by the secret shifted by one lane more than the previous
+constexpr size_t secret_lanes = lane_count + stripes_per_block;
+
+constexpr uint64_t scramble_prime = 0x9e3779b1u;
+
+
+#pragma region Primitives
+constexpr std::array<uint64_t, secret_lanes> _make_secret() {
+    std::array<uint64_t, secret_lanes> result{};
+
+    // splitmix64
+    uint64_t state = p0;
+    for (auto &item : result) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        item = z ^ (z >> 31);
+    }
+
+    return result;
+}
+
+alignas(64) inline constexpr std::array<uint64_t, secret_lanes> secret = _make_secret();
+
+/// The full 128-bit product, low half into a and high half into b
+inline void mum(uint64_t &a, uint64_t &b) {
+    #if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    a = (uint64_t)product;
+    b = (uint64_t)(product >> 64);
+    #elif defined(_MSC_VER) && defined(_M_X64)
+    a = _umul128(a, b, &b);
+    #else
+    uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+    #endif
+}
+
+inline uint64_t mix(uint64_t a, uint64_t b) {
+    mum(a, b);
+    return a ^ b;
+}
+
+inline uint64_t read64(const unsigned char *ptr) {
+    uint64_t result;
+    std::memcpy(&result, ptr, sizeof(result));
+
+    return result;
+}
+
+inline uint64_t read32(const unsigned char *ptr) {
+    uint32_t result;
+    std::memcpy(&result, ptr, sizeof(result));
+
+    return result;
+}
+#pragma endregion Primitives
+
+
+#pragma region Short inputs
+/// wyhash, for inputs up to long_threshold bytes
+inline uint64_t hash_short(const unsigned char *ptr, size_t size, uint64_t seed) {
+    seed ^= mix(seed ^ p0, p1);
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+
+    if (size <= 16) {
+        if (size >= 4) {
+            const size_t shift = (size >> 3) << 2;
+
+            a = (read32(ptr) << 32) | read32(ptr + shift);
+            b = (read32(ptr + size - 4) << 32) | read32(ptr + size - 4 - shift);
+        } else if (size > 0) {
+            a = ((uint64_t)ptr[0] << 16) | ((uint64_t)ptr[size >> 1] << 8) | ptr[size - 1];
+        }
+    } else {
+        size_t left = size;
+
+        if (left > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+
+            do {
+                seed = mix(read64(ptr)      ^ p1, read64(ptr + 8)  ^ seed);
+                see1 = mix(read64(ptr + 16) ^ p2, read64(ptr + 24) ^ see1);
+                see2 = mix(read64(ptr + 32) ^ p3, read64(ptr + 40) ^ see2);
+
+                ptr += 48;
+                left -= 48;
+            } while (left > 48);
+
+            seed ^= see1 ^ see2;
+        }
+
+        while (left > 16) {
+            seed = mix(read64(ptr) ^ p1, read64(ptr + 8) ^ seed);
+
+            ptr += 16;
+            left -= 16;
+        }
+
+        a = read64(ptr + left - 16);
+        b = read64(ptr + left - 8);
+    }
+
+    a ^= p1;
+    b ^= seed;
+    mum(a, b);
+
+    return mix(a ^ p0 ^ size, b ^ p1);
+}
+#pragma endregion Short inputs
+
+
+#pragma region Long inputs
+/**
+ * Every lane accumulates its keyed word's 32x32-bit product plus its neighbour's
+ * raw word. The same formula is spelled out for each instruction set below.
+ * The accumulators are plain arrays, since std::array would drop the vector
+ * types' attributes.
+ */
+struct Scalar {
+    using acc_type = uint64_t[lane_count];
+
+    static inline void accumulate(acc_type &acc, const unsigned char *stripe, const uint64_t *key) {
+        for (size_t i = 0; i < lane_count; ++i) {
+            const uint64_t data = read64(stripe + i * 8);
+            const uint64_t keyed = data ^ key[i];
+
+            acc[i ^ 1] += data;
+            acc[i] += (keyed & 0xffffffff) * (keyed >> 32);
+        }
+    }
+
+    static inline void scramble(acc_type &acc, const uint64_t *key) {
+        for (size_t i = 0; i < lane_count; ++i) {
+            acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ key[i]) * scramble_prime;
+        }
+    }
+
+    static inline void store(const acc_type &acc, uint64_t *dest) {
+        std::memcpy(dest, acc, sizeof(acc));
+    }
+
+    static inline void load(acc_type &acc, const uint64_t *src) {
+        std::memcpy(acc, src, sizeof(acc));
+    }
+};
+
+#if HASH_USE_SSE2_
+struct Sse2 {
+    using acc_type = __m128i[lane_count / 2];
+
+    static inline void accumulate(acc_type &acc, const unsigned char *stripe, const uint64_t *key) {
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            const __m128i data = _mm_loadu_si128((const __m128i *)stripe + i);
+            const __m128i keyed = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *)key + i));
+            const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+
+            acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+
+    static inline void scramble(acc_type &acc, const uint64_t *key) {
+        const __m128i prime = _mm_set1_epi32((int)scramble_prime);
+
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            __m128i value = _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47));
+            value = _mm_xor_si128(value, _mm_loadu_si128((const __m128i *)key + i));
+
+            const __m128i lo = _mm_mul_epu32(value, prime);
+            const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+            acc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+        }
+    }
+
+    static inline void store(const acc_type &acc, uint64_t *dest) {
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            _mm_storeu_si128((__m128i *)dest + i, acc[i]);
+        }
+    }
+
+    static inline void load(acc_type &acc, const uint64_t *src) {
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            acc[i] = _mm_loadu_si128((const __m128i *)src + i);
+        }
+    }
+};
+#endif
+
+#if HASH_USE_AVX2_
+struct Avx2 {
+    using acc_type = __m256i[lane_count / 4];
+
+    static inline void accumulate(acc_type &acc, const unsigned char *stripe, const uint64_t *key) {
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            const __m256i data = _mm256_loadu_si256((const __m256i *)stripe + i);
+            const __m256i keyed = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i *)key + i));
+            const __m256i product = _mm256_mul_epu32(keyed, _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+
+            acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+
+    static inline void scramble(acc_type &acc, const uint64_t *key) {
+        const __m256i prime = _mm256_set1_epi32((int)scramble_prime);
+
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            __m256i value = _mm256_xor_si256(acc[i], _mm256_srli_epi64(acc[i], 47));
+            value = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i *)key + i));
+
+            const __m256i lo = _mm256_mul_epu32(value, prime);
+            const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+            acc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+        }
+    }
+
+    static inline void store(const acc_type &acc, uint64_t *dest) {
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            _mm256_storeu_si256((__m256i *)dest + i, acc[i]);
+        }
+    }
+
+    static inline void load(acc_type &acc, const uint64_t *src) {
+        for (size_t i = 0; i < std::size(acc); ++i) {
+            acc[i] = _mm256_loadu_si256((const __m256i *)src + i);
+        }
+    }
+};
+#endif
+
+#if HASH_USE_AVX2_
+using Isa = Avx2;
+#elif HASH_USE_SSE2_
+using Isa = Sse2;
+#else
+using Isa = Scalar;
+#endif
+
+template <typename Isa_ = Isa>
+uint64_t hash_long(const unsigned char *ptr, size_t size, uint64_t seed) {
+    assert(size > stripe_size);
+
+    alignas(64) uint64_t lanes[lane_count] = {
+        p0, p1 ^ seed, p2, p3 ^ seed,
+        secret[0], secret[1] ^ seed, secret[2], secret[3] ^ seed,
+    };
+
+    typename Isa_::acc_type acc{};
+    Isa_::load(acc, lanes);
+
+    const size_t last_stripe = (size - 1) / stripe_size;
+    size_t stripe = 0;
+
+    for (; stripe + stripes_per_block <= last_stripe; stripe += stripes_per_block) {
+        for (size_t i = 0; i < stripes_per_block; ++i) {
+            Isa_::accumulate(acc, ptr + (stripe + i) * stripe_size, secret.data() + i);
+        }
+
+        Isa_::scramble(acc, secret.data() + stripes_per_block);
+    }
+
+    for (size_t i = 0; stripe < last_stripe; ++stripe, ++i) {
+        Isa_::accumulate(acc, ptr + stripe * stripe_size, secret.data() + i);
+    }
+
+    // The last one, possibly overlapping the previous, with a key of its own
+    Isa_::accumulate(acc, ptr + size - stripe_size, secret.data() + stripes_per_block - 1);
+
+    Isa_::store(acc, lanes);
+
+    uint64_t result = size * p0 ^ seed;
+    for (size_t i = 0; i < lane_count; i += 2) {
+        result = mix(lanes[i] ^ secret[i + 8], lanes[i + 1] ^ secret[i + 9] ^ result);
+    }
+
+    return mix(result ^ p2, result ^ p3);
+}
+#pragma endregion Long inputs
+
+
+inline uint64_t hash_bytes(const void *data, size_t size, uint64_t seed = 0) noexcept {
+    const unsigned char *ptr = (const unsigned char *)data;
+
+    if (size <= long_threshold) {
+        return hash_short(ptr, size, seed);
+    }
+
+    return hash_long(ptr, size, seed);
+}
+
+
+}
+
+
+namespace mylib {
+
+
+/// See _impl::hash
+inline size_t hash_bytes(const void *data, size_t size, uint64_t seed = 0) noexcept {
+    return (size_t)_impl::hash::hash_bytes(data, size, seed);
+}
+
+inline size_t hash_bytes(std::string_view str, uint64_t seed = 0) noexcept {
+    return hash_bytes(str.data(), str.size(), seed);
+}
+
+
+/**
+ * A transparent hasher for unordered containers. Anything with a hash() member
+ * (String, Atom, Array) uses it, and anything else string-like is hashed as bytes.
+ * Strings of either kind hash alike, so, paired with std::equal_to<>, String-keyed
+ * containers can be looked up by std::string_view or const char * without a copy.
+ */
+struct Hash {
+    using is_transparent = void;
+
+
+    template <typename T>
+    requires requires (const T &value) { { value.hash() } -> std::convertible_to<size_t>; }
+    inline size_t operator()(const T &value) const noexcept(noexcept(value.hash())) {
+        return value.hash();
+    }
+
+    inline size_t operator()(std::string_view str) const noexcept {
+        return hash_bytes(str);
+    }
+};
+
+
+}
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include "array.h"
+#include "string.h"
+#include "hash.h"
+
+
+namespace mylib {
+
+
+#pragma region Arena
+namespace _impl {
+
+/**
+ * A bump allocator over large blocks. Memory is only released all at once,
+ * when the arena dies, which suits append-only stores.
+ */
+template <typename Allocator = std::allocator<char>>
+class Arena {
+public:
+    static constexpr size_t block_size = 64 * 1024;
+
+
+    Arena() = default;
+
+    Arena(const Arena &other) = delete;
+    Arena &operator=(const Arena &other) = delete;
+
+    ~Arena() {
+        for (const Block &block : blocks_) {
+            allocator_.deallocate(block.data, block.size);
+        }
+    }
+
+    void *allocate(size_t size, size_t align) {
+        assert(std::has_single_bit(align));
+
+        char *result = _align(cur_, align);
+
+        if (!cur_ || result + size > end_) {
+            // Big requests get a block of their own, so that the current one isn't wasted
+            if (size + align > block_size / 4) {
+                return _align(_new_block(size + align), align);
+            }
+
+            cur_ = _new_block(block_size);
+            end_ = cur_ + block_size;
+            result = _align(cur_, align);
+        }
+
+        cur_ = result + size;
+
+        return result;
+    }
+
+    inline size_t bytes_reserved() const {
+        return bytes_reserved_;
+    }
+
+protected:
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    [[no_unique_address]] Allocator allocator_{};
+    Vector<Block> blocks_{};
+    char *cur_ = nullptr;
+    char *end_ = nullptr;
+    size_t bytes_reserved_ = 0;
+
+
+    static inline char *_align(char *ptr, size_t align) {
+        return (char *)(((uintptr_t)ptr + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+    char *_new_block(size_t size) {
+        char *data = allocator_.allocate(size);
+        blocks_.push_back(Block{data, size});
+        bytes_reserved_ += size;
+
+        return data;
+    }
+
+};
+
+
+/// Immediately followed by the characters and a null terminator, all in the arena
+struct InternEntry {
+    size_t hash;
+    size_t size;
+
+    inline const char *data() const {
+        return (const char *)(this + 1);
+    }
+};
+
+}
+#pragma endregion Arena
+
+
+#pragma region Atom
+/**
+ * A handle to an interned string. Atoms from the same pool are equal
+ * if and only if their strings are, so comparing them is a pointer comparison.
+ * Valid for as long as the pool that produced it.
+ */
+class Atom {
+public:
+    constexpr Atom() noexcept = default;
+
+    constexpr bool operator==(const Atom &other) const noexcept = default;
+
+    constexpr explicit operator bool() const noexcept {
+        return entry_;
+    }
+
+    /// hash_bytes of the string, computed once, when it was interned
+    inline size_t hash() const noexcept {
+        return entry_ ? entry_->hash : 0;
+    }
+
+    inline size_t size() const noexcept {
+        return entry_ ? entry_->size : 0;
+    }
+
+    inline std::string_view view() const noexcept {
+        return entry_ ? std::string_view(entry_->data(), entry_->size) : std::string_view{};
+    }
+
+    inline explicit operator std::string_view() const noexcept {
+        return view();
+    }
+
+    /// Always null-terminated
+    inline const char *c_str() const noexcept {
+        return entry_ ? entry_->data() : "";
+    }
+
+    /// A non-owning String view onto the canonical copy
+    template <typename Str = String<>>
+    inline Str str() const {
+        return Str::view(c_str(), size(), true);
+    }
+
+protected:
+    const _impl::InternEntry *entry_ = nullptr;
+
+    template <typename Allocator_>
+    friend class InternPool;
+
+    constexpr explicit Atom(const _impl::InternEntry *entry) noexcept :
+        entry_{entry} {}
+
+};
+#pragma endregion Atom
+
+
+#pragma region InternPool
+/**
+ * A thread-safe table of canonical string copies. The characters live in
+ * per-shard arenas, so interning doesn't fragment the heap, and nothing is
+ * freed before the pool itself dies.
+ * Lookups of already interned strings take no locks at all: tables are only
+ * ever published whole, and superseded ones stay in the arena, so a reader
+ * can never observe one half-built or freed. Inserts take their shard's mutex.
+ */
+template <typename Allocator = std::allocator<char>>
+class InternPool {
+public:
+    using size_type = size_t;
+
+    static constexpr unsigned shard_bits = 4;
+    static constexpr size_type shard_count = (size_type)1 << shard_bits;
+
+
+    InternPool() = default;
+
+    InternPool(const InternPool &other) = delete;
+    InternPool &operator=(const InternPool &other) = delete;
+
+    Atom intern(std::string_view str) {
+        const size_t hash = _hash(str);
+        Shard &shard = _shard(hash);
+
+        if (const _impl::InternEntry *entry = shard.lookup(str, hash)) {
+            return Atom(entry);
+        }
+
+        std::lock_guard lock{shard.mutex};
+
+        // Someone might have beaten us to it
+        if (const _impl::InternEntry *entry = shard.lookup(str, hash)) {
+            return Atom(entry);
+        }
+
+        return Atom(shard.insert(str, hash));
+    }
+
+    template <typename Allocator_, RefCountPolicy RefCount>
+    inline Atom intern(const String<Allocator_, RefCount> &str) {
+        return intern((std::string_view)str);
+    }
+
+    /// A null atom if the string hasn't been interned
+    Atom find(std::string_view str) const {
+        const size_t hash = _hash(str);
+
+        return Atom(_shard(hash).lookup(str, hash));
+    }
+
+    size_type size() const {
+        size_type result = 0;
+
+        for (const Shard &shard : shards_) {
+            std::lock_guard lock{shard.mutex};
+            result += shard.count;
+        }
+
+        return result;
+    }
+
+    /// Arena memory, including the unused parts of blocks and old tables
+    size_type bytes_reserved() const {
+        size_type result = 0;
+
+        for (const Shard &shard : shards_) {
+            std::lock_guard lock{shard.mutex};
+            result += shard.arena.bytes_reserved();
+        }
+
+        return result;
+    }
+
+protected:
+    struct Slot {
+        // Only written before the entry is published
+        size_t hash;
+        std::atomic<const _impl::InternEntry *> entry;
+    };
+
+    // Open addressing with linear probing; the size is a power of two
+    struct Table {
+        size_type mask;
+        Slot *slots;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex{};
+        std::atomic<const Table *> table{nullptr};
+        size_type count = 0;
+        _impl::Arena<Allocator> arena{};
+
+
+        const _impl::InternEntry *lookup(std::string_view str, size_t hash) const {
+            const Table *cur_table = table.load(std::memory_order_acquire);
+
+            if (!cur_table) {
+                return nullptr;
+            }
+
+            const Slot *slots = cur_table->slots;
+            const size_type mask = cur_table->mask;
+
+            for (size_type idx = hash & mask; ; idx = (idx + 1) & mask) {
+                const _impl::InternEntry *entry = slots[idx].entry.load(std::memory_order_acquire);
+
+                if (!entry) {
+                    return nullptr;
+                }
+
+                if (slots[idx].hash == hash && entry->size == str.size() &&
+                    std::memcmp(entry->data(), str.data(), str.size()) == 0) {
+                    return entry;
+                }
+            }
+        }
+
+        /// Must be called with the mutex held
+        const _impl::InternEntry *insert(std::string_view str, size_t hash) {
+            const Table *cur_table = table.load(std::memory_order_relaxed);
+
+            // Keeps the load factor under 3/4
+            if (!cur_table || (count + 1) * 4 > (cur_table->mask + 1) * 3) {
+                cur_table = _grow(cur_table);
+            }
+
+            auto *entry = (_impl::InternEntry *)arena.allocate(sizeof(_impl::InternEntry) + str.size() + 1,
+                                                               alignof(_impl::InternEntry));
+            entry->hash = hash;
+            entry->size = str.size();
+
+            char *chars = (char *)(entry + 1);
+            std::memcpy(chars, str.data(), str.size());
+            chars[str.size()] = '\0';
+
+            _place(cur_table, entry, std::memory_order_release);
+            ++count;
+
+            return entry;
+        }
+
+        static void _place(const Table *dest, const _impl::InternEntry *entry, std::memory_order order) {
+            size_type idx = entry->hash & dest->mask;
+
+            while (dest->slots[idx].entry.load(std::memory_order_relaxed)) {
+                idx = (idx + 1) & dest->mask;
+            }
+
+            dest->slots[idx].hash = entry->hash;
+            dest->slots[idx].entry.store(entry, order);
+        }
+
+        const Table *_grow(const Table *old_table) {
+            const size_type new_size = old_table ? (old_table->mask + 1) * 2 : 64;
+
+            auto *new_slots = (Slot *)arena.allocate(new_size * sizeof(Slot), alignof(Slot));
+            for (size_type i = 0; i < new_size; ++i) {
+                new (&new_slots[i]) Slot{0, nullptr};
+            }
+
+            auto *new_table = new (arena.allocate(sizeof(Table), alignof(Table))) Table{new_size - 1, new_slots};
+
+            if (old_table) {
+                for (size_type i = 0; i <= old_table->mask; ++i) {
+                    if (auto *entry = old_table->slots[i].entry.load(std::memory_order_relaxed)) {
+                        // Nobody sees the new table yet
+                        _place(new_table, entry, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            // Readers still walking the old table are fine: it stays alive, and
+            // whatever they miss there they'll find under the mutex
+            table.store(new_table, std::memory_order_release);
+
+            return new_table;
+        }
+    };
+
+    Shard shards_[shard_count];
+
+
+    static inline size_t _hash(std::string_view str) {
+        return hash_bytes(str);
+    }
+
+    // The top bits pick the shard, while the bottom ones index its table
+    inline Shard &_shard(size_t hash) {
+        return shards_[hash >> (sizeof(size_t) * 8 - shard_bits)];
+    }
+
+    inline const Shard &_shard(size_t hash) const {
+        return shards_[hash >> (sizeof(size_t) * 8 - shard_bits)];
+    }
+
+};
+#pragma endregion InternPool
+
+
+}
+
+
+namespace std {
+
+template <>
+struct hash<mylib::Atom> {
+    inline size_t operator()(const mylib::Atom &atom) const noexcept {
+        return atom.hash();
+    }
+};
+
+}
@@ -2,8 +2,23 @@
 #include <iostream>
 #include <iomanip>
 #include <string_view>
+#include <chrono>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <array>
+#include <unordered_set>
+#include <fstream>
+#include <filesystem>
 #include "array.h"
+#include "packed_array.h"
+#include "mdarray.h"
+#include "priority_queue.h"
+#include "ranges.h"
 #include "string.h"
+#include "mapped_file.h"
+#include "rope.h"
+#include "intern.h"
 #include "function.h"
 #include "dot.h"
 #include "test.h"
@@ -177,6 +192,45 @@ protected:
             compare(items, arr);
         };
 
+        if constexpr (utest::counts_allocations) {
+            "allocations"_test << [=]() {
+                constexpr size_t test_size = 1000;
+
+                utest::AllocCounter allocs{};
+
+                {
+                    array_type arr{};
+
+                    arr.reserve(test_size);
+                    for (unsigned i = 0; i < test_size; ++i) {
+                        arr.push_back(random_val());
+                    }
+
+                    const size_t before_move = allocs.allocations();
+                    array_type moved = std::move(arr);
+                    TEST_REQUIRE(moved.size() == test_size);
+                    TEST_REQUIRE(arr.size() == 0);
+
+                    // Moving just hands the storage over, whatever kind it is
+                    TEST_REQUIRE(allocs.allocations() == before_move);
+
+                    if constexpr (array_type::is_contiguous) {
+                        // The reservation is the only one
+                        TEST_REQUIRE(before_move == 1);
+                    }
+
+                    // The moved-from one is still usable
+                    arr.push_back(moved[0]);
+                    TEST_REQUIRE(arr.size() == 1);
+                    TEST_REQUIRE(arr[0] == moved[0]);
+                }
+
+                // Everything is given back
+                TEST_REQUIRE(allocs.stats().live_bytes == 0);
+                TEST_REQUIRE(allocs.stats().deallocations == allocs.allocations());
+            };
+        }
+
         "swap"_test << [=]() {
             const size_t test_size = 17;
             std::vector<value_type> items;
@@ -199,290 +253,3695 @@ protected:
             array_type arr;
             populate(test_size, items, arr);
 
-            #if 1
-            std::sort(items.begin(), items.end());
-            std::sort(arr.begin(), arr.end());
-            #else
-            std::copy(arr.begin(), arr.end(), items.begin());
-            #endif
+            #if 1
+            std::sort(items.begin(), items.end());
+            std::sort(arr.begin(), arr.end());
+            #else
+            std::copy(arr.begin(), arr.end(), items.begin());
+            #endif
+
+            compare(items, arr);
+        };
+
+        "copy"_test << [=]() {
+            const size_t test_size = 17;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            items.clear();
+
+            std::copy(arr.begin(), arr.end(), std::back_inserter(items));
+
+            compare(items, arr);
+        };
+
+        "copy_ctor"_test << [=]() {
+            const size_t test_size = 17;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            array_type copy = arr;
+            compare(items, copy);
+
+            if constexpr (requires { copy == arr; }) {
+                TEST_REQUIRE(copy == arr);
+                TEST_REQUIRE(copy.hash() == arr.hash());
+
+                copy.fill(random_val());
+                TEST_REQUIRE(std::all_of(copy.begin(), copy.end(),
+                                         [&](const value_type &item) { return item == copy[0]; }));
+            }
+        };
+
+        "find"_test << [=]() {
+            const size_t test_size = 17;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            for (unsigned i = 0; i < 500; ++i) {
+                value_type item = random_val();
+                TEST_REQUIRE(std::find(arr.begin(), arr.end(), item) - arr.begin() ==
+                             std::find(items.begin(), items.end(), item) - items.begin());
+            }
+        };
+
+        // TODO: Also perhaps std::transform?
+    }
+
+    void test_static() {
+        using namespace utest::literals;
+
+        constexpr size_t static_size = Storage<T>::size();
+
+        //
+    }
+
+};
+#pragma endregion ArrayTester
+
+
+#pragma region PackedIntArrayTester
+template <typename Arr>
+class PackedIntArrayTester {
+public:
+    using array_type = Arr;
+    using value_type = array_type::value_type;
+
+
+    static value_type random_val() {
+        return (value_type)(abel::randLL() % ((uint64_t)array_type::max_value + 1));
+    }
+
+
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing %s\n", typeid(array_type).name());
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+
+        constexpr auto populate = [](const size_t test_size,
+                                     std::vector<value_type> &items,
+                                     array_type &arr) {
+            items.clear();
+            arr.clear();
+
+            for (unsigned i = 0; i < test_size; ++i) {
+                value_type val = random_val();
+
+                items.push_back(val);
+                arr.push_back(val);
+            }
+        };
+
+        constexpr auto compare = [](const std::vector<value_type> &items,
+                                    const array_type &arr) {
+            TEST_REQUIRE(arr.size() == items.size());
+
+            for (size_t i = 0; i < arr.size(); ++i) {
+                TEST_REQUIRE(arr[i] == items[i]);
+            }
+        };
+
+        "push_pop"_test << [=]() {
+            const size_t test_size = 1001;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            compare(items, arr);
+
+            for (unsigned i = 0; i < test_size; ++i) {
+                TEST_REQUIRE(arr.back() == items.back());
+
+                items.pop_back();
+                arr.pop_back();
+            }
+
+            compare(items, arr);
+            TEST_REQUIRE(arr.words() == 0);
+        };
+
+        "fill"_test << [=]() {
+            for (unsigned sz : {0, 1, 63, 64, 65, 1000}) {
+                array_type arr(sz, array_type::max_value);
+
+                compare(std::vector<value_type>(sz, array_type::max_value), arr);
+            }
+        };
+
+        "proxy"_test << [=]() {
+            const size_t test_size = 17;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            arr[3] = arr[-1];
+            items[3] = items.back();
+
+            arr[0] = 0;
+            items[0] = 0;
+
+            compare(items, arr);
+        };
+
+        "iteration"_test << [=]() {
+            const size_t test_size = 100;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            unsigned i = 0;
+            for (value_type elem : std::as_const(arr)) {
+                TEST_REQUIRE(elem == items[i]);
+                ++i;
+            }
+
+            TEST_REQUIRE(i == test_size);
+        };
+
+        "decode"_test << [=]() {
+            const size_t test_size = 1000;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            for (size_t from : {0, 1, 63, 64, 200}) {
+                std::vector<value_type> decoded(test_size - from);
+                arr.decode(from, decoded.size(), decoded.data());
+
+                TEST_REQUIRE(std::equal(decoded.begin(), decoded.end(), items.begin() + from));
+            }
+        };
+
+        "encode"_test << [=]() {
+            const size_t test_size = 1000;
+            std::vector<value_type> items;
+            array_type arr;
+            populate(test_size, items, arr);
+
+            std::vector<value_type> update(900);
+            for (auto &item : update) {
+                item = random_val();
+            }
+
+            arr.encode(7, update.size(), update.data());
+            std::copy(update.begin(), update.end(), items.begin() + 7);
+
+            compare(items, arr);
+        };
+
+        "truncation"_test << [=]() {
+            // Every entry point keeps just the low bits, and leaves the neighbours alone
+            if constexpr (array_type::max_value < std::numeric_limits<value_type>::max()) {
+                const value_type wide = std::numeric_limits<value_type>::max();
+                const size_t test_size = 200;
+                std::vector<value_type> items(test_size, 0);
+                array_type arr(test_size, 0);
+
+                arr[5] = wide;
+                items[5] = array_type::max_value;
+                compare(items, arr);
+
+                std::vector<value_type> update(150, (value_type)(array_type::max_value + 1));
+                arr.encode(20, update.size(), update.data());
+                compare(items, arr);
+
+                arr.fill(wide);
+                compare(std::vector<value_type>(test_size, array_type::max_value), arr);
+            }
+        };
+    }
+};
+#pragma endregion PackedIntArrayTester
+
+
+#pragma region MdArrayTester
+template <typename Arr>
+class MdArrayTester {
+public:
+    using array_type = Arr;
+    using index_type = array_type::index_type;
+    static_assert(array_type::rank == 2, "Tester only suitable for 2D arrays");
+
+
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing %s\n", typeid(array_type).name());
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+
+        // None of these share anything, so they may as well run in parallel
+        utest::Runner runner{};
+
+        constexpr auto expected = [](size_t i, size_t j) {
+            return (int)(i * 1000 + j);
+        };
+
+        constexpr auto populate = [=](array_type &arr) {
+            for (size_t i = 0; i < arr.extent(0); ++i) {
+                for (size_t j = 0; j < arr.extent(1); ++j) {
+                    arr(i, j) = expected(i, j);
+                }
+            }
+        };
+
+        runner.add("access"_test = [=]() {
+            array_type arr(13, 7);
+            populate(arr);
+
+            for (size_t i = 0; i < 13; ++i) {
+                for (size_t j = 0; j < 7; ++j) {
+                    TEST_REQUIRE(arr(i, j) == expected(i, j));
+                    TEST_REQUIRE(arr.at({i, j}) == expected(i, j));
+                }
+            }
+
+            bool thrown = false;
+            try {
+                arr.at({13, 0});
+            } catch (const std::out_of_range &) {
+                thrown = true;
+            }
+            TEST_REQUIRE(thrown);
+        });
+
+        runner.add("for_each"_test = [=]() {
+            array_type arr(13, 7);
+            populate(arr);
+
+            size_t cnt = 0;
+            arr.for_each([&](const index_type &idx, int &item) {
+                TEST_REQUIRE(item == expected(idx[0], idx[1]));
+                ++cnt;
+            });
+
+            TEST_REQUIRE(cnt == arr.size());
+        });
+
+        runner.add("subview"_test = [=]() {
+            array_type arr(13, 7);
+            populate(arr);
+
+            auto view = arr.subview({1, 2}, {12, 7}, {3, 2});
+            TEST_REQUIRE(view.extent(0) == 4);
+            TEST_REQUIRE(view.extent(1) == 3);
+
+            view.for_each([&](const index_type &idx, int &item) {
+                TEST_REQUIRE(item == expected(1 + idx[0] * 3, 2 + idx[1] * 2));
+            });
+
+            auto nested = view.subview({1, 0}, {4, 3}, {2, 1});
+            TEST_REQUIRE(nested(1, 2) == expected(10, 6));
+
+            nested(1, 2) = -1;
+            TEST_REQUIRE(arr(10, 6) == -1);
+        });
+
+        runner.add("tiles"_test = [=]() {
+            array_type arr(13, 7);
+            populate(arr);
+
+            size_t tiles = 0;
+            size_t cnt = 0;
+            arr.for_each_tile([&](auto tile) {
+                ++tiles;
+
+                tile.for_each([&](const index_type &idx, int &item) {
+                    index_type parent = tile.parent_index(idx);
+                    TEST_REQUIRE(item == expected(parent[0], parent[1]));
+                    ++cnt;
+                });
+            }, 4);
+
+            TEST_REQUIRE(tiles == 4 * 2);
+            TEST_REQUIRE(cnt == arr.size());
+        });
+
+        runner.run();
+    }
+};
+#pragma endregion MdArrayTester
+
+
+#pragma region PriorityQueueTester
+class PriorityQueueTester {
+public:
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing mylib::PriorityQueue\n");
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+
+        // Without handles, there's nothing but the heap itself
+        static_assert(sizeof(mylib::PriorityQueue<int>) == sizeof(mylib::Vector<int>));
+
+        "push_pop"_test << [=]() {
+            mylib::PriorityQueue<int> queue{};
+            std::priority_queue<int> reference{};
+
+            for (unsigned i = 0; i < 1000; ++i) {
+                int val = (int)abel::randLL(100);
+
+                queue.push(val);
+                reference.push(val);
+            }
+
+            while (!reference.empty()) {
+                TEST_REQUIRE(queue.top() == reference.top());
+
+                queue.pop();
+                reference.pop();
+            }
+
+            TEST_REQUIRE(queue.empty());
+        };
+
+        "fused"_test << [=]() {
+            mylib::PriorityQueue<int, std::greater<int>, 3> queue{};
+            std::priority_queue<int, std::vector<int>, std::greater<int>> reference{};
+
+            for (unsigned i = 0; i < 100; ++i) {
+                int val = (int)abel::randLL(1000);
+
+                queue.push(val);
+                reference.push(val);
+            }
+
+            for (unsigned i = 0; i < 1000; ++i) {
+                int val = (int)abel::randLL(1000);
+
+                reference.push(val);
+                TEST_REQUIRE(queue.push_pop(val) == reference.top());
+                reference.pop();
+
+                val = (int)abel::randLL(1000);
+
+                TEST_REQUIRE(queue.replace_top(val) == reference.top());
+                reference.pop();
+                reference.push(val);
+            }
+        };
+
+        "heapify"_test << [=]() {
+            mylib::Vector<int> values{};
+            std::vector<int> sorted{};
+
+            for (unsigned i = 0; i < 1000; ++i) {
+                int val = (int)abel::randLL(10000);
+
+                values.push_back(val);
+                sorted.push_back(val);
+            }
+
+            std::sort(sorted.begin(), sorted.end());
+
+            mylib::PriorityQueue<int, std::greater<int>> copied(values, std::greater<int>{});
+            mylib::PriorityQueue<int, std::greater<int>> adopted(std::move(values), std::greater<int>{});
+
+            for (int val : sorted) {
+                TEST_REQUIRE(copied.top() == val);
+                TEST_REQUIRE(adopted.top() == val);
+
+                copied.pop();
+                adopted.pop();
+            }
+        };
+
+        "handles"_test << [=]() {
+            mylib::HandlePriorityQueue<int, std::greater<int>> queue{};
+            std::vector<size_t> handles{};
+            std::vector<int> values{};
+
+            for (unsigned i = 0; i < 500; ++i) {
+                int val = (int)abel::randLL(100000);
+
+                handles.push_back(queue.push(val));
+                values.push_back(val);
+            }
+
+            for (unsigned i = 0; i < 500; i += 3) {
+                values[i] -= 50000;
+                queue.update(handles[i], values[i]);
+            }
+
+            for (unsigned i = 1; i < 500; i += 5) {
+                queue.erase(handles[i]);
+                TEST_REQUIRE(!queue.contains(handles[i]));
+                values[i] = -1;
+            }
+
+            std::vector<int> remaining{};
+            for (unsigned i = 0; i < 500; ++i) {
+                if (values[i] != -1) {
+                    TEST_REQUIRE(queue.get(handles[i]) == values[i]);
+                    remaining.push_back(values[i]);
+                }
+            }
+
+            std::sort(remaining.begin(), remaining.end());
+
+            for (int val : remaining) {
+                TEST_REQUIRE(queue.top() == val);
+                queue.pop();
+            }
+
+            TEST_REQUIRE(queue.empty());
+        };
+    }
+};
+#pragma endregion PriorityQueueTester
+
+
+#pragma region RangesTester
+class RangesTester {
+public:
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing mylib views\n");
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+        using namespace mylib;
+
+        constexpr auto iota = [](size_t count) {
+            Vector<int> result{};
+
+            for (size_t i = 0; i < count; ++i) {
+                result.push_back((int)i);
+            }
+
+            return result;
+        };
+
+        "map_take"_test << [=]() {
+            Vector<int> arr = iota(100);
+
+            auto result = arr | views::map([](int x) { return (long)x * x; })
+                              | views::take(10)
+                              | collect<Vector<long>>();
+
+            TEST_REQUIRE(result.size() == 10);
+
+            for (size_t i = 0; i < result.size(); ++i) {
+                TEST_REQUIRE(result[i] == (long)(i * i));
+            }
+        };
+
+        "filter"_test << [=]() {
+            Vector<int> arr = iota(100);
+
+            auto result = collect<Vector<int>>(arr | views::filter([](int x) { return x % 3 == 0; }));
+
+            TEST_REQUIRE(result.size() == 34);
+
+            for (int item : result) {
+                TEST_REQUIRE(item % 3 == 0);
+            }
+        };
+
+        "enumerate"_test << [=]() {
+            Vector<int> arr = iota(17);
+
+            for (auto [idx, item] : arr | views::enumerate()) {
+                TEST_REQUIRE(item == (int)idx);
+                item = -item;
+            }
+
+            TEST_REQUIRE(arr[5] == -5);
+        };
+
+        "zip"_test << [=]() {
+            ChunkedArray<int, 7> chunked{};
+            for (int i = 0; i < 20; ++i) {
+                chunked.push_back(i);
+            }
+
+            Vector<int> arr = iota(30);
+
+            size_t cnt = 0;
+            for (auto [a, b] : chunked | views::zip(arr)) {
+                TEST_REQUIRE(a == b);
+                ++cnt;
+            }
+
+            TEST_REQUIRE(cnt == 20);
+        };
+
+        "zip_temporary"_test << [=]() {
+            Vector<int> arr = iota(10);
+
+            // The temporary has to move into the adaptor, which may outlive the full expression
+            auto zipper = views::zip(iota(5) | views::map([](int x) { return x * 2; }));
+
+            size_t cnt = 0;
+            for (auto [a, b] : arr | zipper) {
+                TEST_REQUIRE(b == a * 2);
+                ++cnt;
+            }
+
+            TEST_REQUIRE(cnt == 5);
+        };
+
+        "chunk"_test << [=]() {
+            Vector<int> arr = iota(100);
+
+            auto sums = arr | views::chunk(30)
+                            | views::map([](auto chunk) {
+                                  int sum = 0;
+                                  for (int item : chunk) {
+                                      sum += item;
+                                  }
+                                  return sum;
+                              })
+                            | collect<Vector<int>>();
+
+            TEST_REQUIRE(sums.size() == 4);
+            TEST_REQUIRE(sums[3] == 90 + 91 + 92 + 93 + 94 + 95 + 96 + 97 + 98 + 99);
+        };
+
+        "chunk_views"_test << [=]() {
+            Vector<int> arr = iota(100);
+
+            constexpr auto sum_chunks = [](auto &&range) {
+                Vector<int> sums{};
+
+                for (auto chunk : range | views::chunk(4)) {
+                    int sum = 0;
+                    for (int item : chunk) {
+                        sum += item;
+                    }
+
+                    sums.push_back(sum);
+                }
+
+                return sums;
+            };
+
+            // Iterators of these only compare with their own sentinels
+            Vector<int> mapped = sum_chunks(arr | views::map([](int x) { return x * 10; }));
+            TEST_REQUIRE(mapped.size() == 25);
+            TEST_REQUIRE(mapped[1] == 40 + 50 + 60 + 70);
+
+            Vector<int> filtered = sum_chunks(arr | views::filter([](int x) { return x % 2 == 1; }));
+            TEST_REQUIRE(filtered.size() == 13);
+            TEST_REQUIRE(filtered[0] == 1 + 3 + 5 + 7);
+            TEST_REQUIRE(filtered[12] == 97 + 99);
+
+            Vector<int> taken = sum_chunks(arr | views::take(10));
+            TEST_REQUIRE(taken.size() == 3);
+            TEST_REQUIRE(taken[2] == 8 + 9);
+        };
+
+        "collect_static"_test << [=]() {
+            Vector<int> arr = iota(10);
+
+            auto result = arr | views::map([](int x) { return -x; })
+                              | views::take(4)
+                              | collect<CArray<int, 4>>();
+
+            TEST_REQUIRE(result[3] == -3);
+        };
+    }
+};
+#pragma endregion RangesTester
+
+
+#pragma region StringTester
+template <typename Str = mylib::String<>>
+class StringTester {
+public:
+    using string_type = Str;
+    using char_type = string_type::value_type;
+    static_assert(std::is_same_v<char_type, char>, "Tester not suitable for non-char strings");
+
+
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing %s\n", typeid(string_type).name());
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+
+        "basic"_test << [=]() {
+            string_type str{"abc"};
+            TEST_REQUIRE(str.size() == 3);
+            TEST_REQUIRE(str.size_with_null() == 4);
+            TEST_REQUIRE(str.is_owning());
+            TEST_REQUIRE(str[0] == 'a');
+            TEST_REQUIRE(str[1] == 'b');
+            TEST_REQUIRE(str[2] == 'c');
+            TEST_REQUIRE(str[3] == 0);
+        };
+
+        "constexpr_flags"_test << [=]() {
+            #if STRING_CONSTEXPR_FLAGS_
+            // Views are never small, so these read the flags through the long representation
+            static_assert([] {
+                string_type str = string_type::view("longer than the small buffer could hold");
+                return !str.is_owning() && str.is_null_terminated() && str.size() == 39;
+            }());
+
+            static_assert([] {
+                string_type str = string_type::view("longer than the small buffer could hold", (size_t)6);
+                return !str.is_owning() && !str.is_null_terminated() && str.size() == 6;
+            }());
+            #endif
+
+            static_assert([] {
+                string_type str{};
+                return str.is_owning() && str.is_null_terminated() && str.empty();
+            }());
+        };
+
+        "access"_test << [=]() {
+            constexpr std::string_view data = "Hello, dear world!";
+
+            string_type mystr = data.data();
+            TEST_REQUIRE(mystr.is_owning());
+
+            TEST_REQUIRE(data.size() == mystr.size());
+
+            for (size_t i = 0; i < data.size(); ++i) {
+                TEST_REQUIRE(mystr[i] == data[i]);
+            }
+
+            for (int i = 1; i <= (int)data.size(); ++i) {
+                TEST_REQUIRE(mystr[-i] == data[data.size() - i]);
+            }
+
+            TEST_REQUIRE(mystr[data.size()] == '\0');
+        };
+
+        constexpr auto compare = [](const std::string_view &data,
+                                    const string_type &mystr, bool dump = false) {
+            TEST_REQUIRE(data.size() == mystr.size());
+
+            for (size_t i = 0; i < data.size(); ++i) {
+                if (dump && data[i] != mystr[i]) {
+                    utest::log("[%zu/%zu]: %c != %c\n",
+                               i, data.size(),
+                               data[i], mystr[i]);
+                }
+                TEST_REQUIRE(data[i] == mystr[i]);
+            }
+        };
+
+        "iteration"_test << [=]() {
+            constexpr std::string_view data = "Hello, dear world!";
+
+            string_type mystr = data.data();
+            TEST_REQUIRE(mystr.is_owning());
+
+            TEST_REQUIRE(mystr.size() == (size_t)(mystr.cend() - mystr.cbegin()));
+
+            size_t i = 0;
+            for (const auto &elem : mystr) {
+                TEST_REQUIRE(elem == data[i]);
+                ++i;
+            }
+        };
+
+        "copy_on_write"_test << [=]() {
+            constexpr std::string_view data =
+                "I'm soooo long, I sure hope nobody copies me...";
+            string_type str1{data};
+            TEST_REQUIRE(str1.is_owning());
+
+            string_type str2 = str1;
+            TEST_REQUIRE(!str1.is_owning());
+            TEST_REQUIRE(!str2.is_owning());
+
+            compare(data, str1);
+            compare(data, str2);
+
+            constexpr std::string_view extra =
+                ", but most of all, Samy is my hero.";
+
+            str1.append(extra);
+            TEST_REQUIRE(str1.is_owning());
+            TEST_REQUIRE(!str2.is_owning());
+            compare(data, str2);
+        };
+
+        "no_copy_on_write"_test << [=]() {
+            string_type str1{"I'm soooo long, I sure hope nobody copies me..."};
+            TEST_REQUIRE(str1.is_owning());
+
+            string_type str2 = str1.as_const();
+            TEST_REQUIRE(str1.is_owning());
+            TEST_REQUIRE(str2.is_owning());
+        };
+
+        "small_cow"_test << [=]() {
+            constexpr std::string_view data =
+                "smolcow, a bit longer";
+            static_assert(data.size() + 1 <= string_type::small_string_size);
+
+            string_type str1{data};
+            TEST_REQUIRE(str1.is_owning());
+
+            // Small strings are copied eagerly, rather than shared
+            string_type str2 = str1;
+            TEST_REQUIRE(str1.is_owning());
+            TEST_REQUIRE(str2.is_owning());
+            TEST_REQUIRE(str1.data() != str2.data());
+
+            compare(data, str1);
+            compare(data, str2);
+
+            str1.erase(-3);
+            compare(data.substr(0, data.size() - 3), str1);
+            compare(data, str2);
+        };
+
+        "small_boundary"_test << [=]() {
+            constexpr size_t inline_chars = string_type::small_string_size - 1;
+
+            std::string data(inline_chars, 'x');
+
+            string_type str{std::string_view(data)};
+            TEST_REQUIRE(str.capacity() == string_type::small_string_size);
+            compare(data, str);
+
+            // Spills over to the heap...
+            str.push_back('y');
+            data.push_back('y');
+            TEST_REQUIRE(str.capacity() > string_type::small_string_size);
+            TEST_REQUIRE(str.is_null_terminated());
+            compare(data, str);
+
+            // ... and comes back
+            str.pop_back();
+            data.pop_back();
+            str.shrink_to_fit();
+            TEST_REQUIRE(str.capacity() == string_type::small_string_size);
+            compare(data, str);
+
+            string_type moved = std::move(str);
+            compare(data, moved);
+            compare("", str);
+
+            string_type window = string_type::view(data.data(), inline_chars);
+            window.push_back('z');
+            TEST_REQUIRE(window.is_owning());
+            compare(data + "z", window);
+        };
+
+        "push_pop"_test << [=]() {
+            constexpr std::string_view data = "Abacado or whatever, I'm not into algorithms";
+
+            string_type str{};
+            for (size_t i = 0; i < data.size(); ++i) {
+                str.push_back(data[i]);
+            }
+
+            compare(data, str);
+
+
+            for (size_t i = 0; i < data.size(); ++i) {
+                char_type chr = data[data.size() - 1 - i];
+                char_type my_chr = str.back();
+
+                TEST_REQUIRE(chr == my_chr);
+
+                str.pop_back();
+            }
+
+            compare("", str);
+        };
+
+        test_compare_eq("Hello, dear world");
+        test_compare_eq("");
+        test_compare_eq(std::string_view("Hi there, pal!"));
+
+        "sort"_test << [=]() {
+            constexpr std::string_view data = "Hello, dear world!";
+
+            std::string str = data.data();
+            string_type mystr = data.data();
+            TEST_REQUIRE(mystr.is_owning());
+
+            std::sort(str.begin(), str.end());
+            std::sort(mystr.begin(), mystr.end());
+
+            compare(str, mystr);
+        };
+
+        "copy"_test << [=]() {
+            constexpr std::string_view data = "Hello, dear world!";
+
+            std::string str{};
+            string_type mystr = data.data();
+            TEST_REQUIRE(mystr.is_owning());
+
+            std::copy(mystr.begin(), mystr.end(), std::back_inserter(str));
+
+            compare(str, mystr);
+        };
+
+        "find"_test << [=]() {
+            constexpr std::string_view data = "Hello, dear world!";
+
+            string_type mystr = data.data();
+            TEST_REQUIRE(mystr.is_owning());
+
+            using namespace std::string_view_literals;
+
+            for (char_type chr : "ABCabcHh0\0!1,"sv) {
+                TEST_REQUIRE(std::find(mystr.begin(), mystr.end(), chr) - mystr.begin() ==
+                             std::find(data.begin(), data.end(), chr) - data.begin());
+            }
+        };
+
+        "search"_test << [=]() {
+            using namespace std::string_view_literals;
+
+            // Long enough to go through the vectorized loops
+            std::string data = "Mississippi, all the way from Minnesota to the Gulf of Mexico; ";
+            for (unsigned i = 0; i < 4; ++i) {
+                data += data;
+            }
+            data += "...and then the sea";
+
+            std::string long_needle(data.data() + 100, 100);
+            std::string_view view = data;
+
+            string_type owned{view};
+            string_type viewing = string_type::view(data.data(), data.size());
+            string_type source{view};
+            string_type shared = source;
+
+            for (const string_type *str : {&owned, &viewing, &shared}) {
+                for (std::string_view needle : {"ss"sv, "issi"sv, "sea"sv, "Gulf of Mexico"sv,
+                                                "absent"sv, ""sv, (std::string_view)long_needle}) {
+                    for (size_t pos : {(size_t)0, (size_t)5, data.size() / 2, string_type::npos}) {
+                        TEST_REQUIRE(str->find (needle, pos) == view.find (needle, pos));
+                        TEST_REQUIRE(str->rfind(needle, pos) == view.rfind(needle, pos));
+                        TEST_REQUIRE(str->find_first_of    (needle, pos) == view.find_first_of    (needle, pos));
+                        TEST_REQUIRE(str->find_first_not_of(needle, pos) == view.find_first_not_of(needle, pos));
+                        TEST_REQUIRE(str->find_last_of     (needle, pos) == view.find_last_of     (needle, pos));
+                        TEST_REQUIRE(str->find_last_not_of (needle, pos) == view.find_last_not_of (needle, pos));
+                    }
+
+                    TEST_REQUIRE(str->contains(needle) == (view.find(needle) != view.npos));
+                    TEST_REQUIRE(str->starts_with(needle) == view.starts_with(needle));
+                    TEST_REQUIRE(str->ends_with(needle) == view.ends_with(needle));
+                }
+
+                TEST_REQUIRE(str->find('.') == view.find('.'));
+                TEST_REQUIRE(str->rfind('M') == view.rfind('M'));
+            }
+
+            // Searching must not have made private copies
+            TEST_REQUIRE(!viewing.is_owning());
+            TEST_REQUIRE(!shared.is_owning());
+        };
+
+        "affixes"_test << [=]() {
+            string_type str{"Hello, world!"};
+
+            // Literals, std::strings and Strings must all pick an overload unambiguously
+            TEST_REQUIRE(str.starts_with("Hello"));
+            TEST_REQUIRE(!str.starts_with("world"));
+            TEST_REQUIRE(str.ends_with("world!"));
+            TEST_REQUIRE(!str.ends_with("Hello"));
+            TEST_REQUIRE(str.starts_with(""));
+            TEST_REQUIRE(str.ends_with(""));
+            TEST_REQUIRE(!str.starts_with("Hello, world! And more"));
+
+            TEST_REQUIRE(str.starts_with(std::string("Hell")));
+            TEST_REQUIRE(str.ends_with(string_type("!")));
+            TEST_REQUIRE(str.starts_with('H'));
+            TEST_REQUIRE(str.ends_with('!'));
+            TEST_REQUIRE(!string_type().starts_with('H'));
+            TEST_REQUIRE(!string_type().ends_with('!'));
+        };
+
+        "substr"_test << [=]() {
+            constexpr std::string_view data = "The quick brown fox jumps over the lazy dog";
+
+            string_type viewing = string_type::view(data.data(), data.size());
+            string_type part = viewing.substr(4, 11);
+            TEST_REQUIRE(!part.is_owning());
+            TEST_REQUIRE(!part.is_null_terminated());
+            compare(data.substr(4, 11), part);
+
+            // Reading a substring doesn't change how the source is held
+            string_type owned{data};
+            string_type copied = owned.substr(4, 11);
+            TEST_REQUIRE(owned.is_owning());
+            TEST_REQUIRE(copied.is_owning());
+            compare(data.substr(4, 11), copied);
+
+            // Sharing does, turning owned into a shared source
+            string_type window = owned.share(10, 25);
+            TEST_REQUIRE(!owned.is_owning());
+            TEST_REQUIRE(!window.is_owning());
+            compare(data, owned);
+            compare(data.substr(10, 25), window);
+
+            string_type nested = window.substr(6);
+            TEST_REQUIRE(!nested.is_owning());
+            compare(data.substr(16, 19), nested);
+
+            string_type suffix = owned.slice(-8);
+            TEST_REQUIRE(suffix.is_null_terminated());
+            TEST_REQUIRE(std::string_view(suffix.c_str()) == "lazy dog");
+            compare(data.substr(4, data.size() - 8), owned.slice(4, -4));
+            TEST_REQUIRE(owned.slice(10, 3).empty());
+
+            // Copy-on-write only affects the window being modified
+            window.push_back('!');
+            TEST_REQUIRE(window.is_owning());
+            compare("brown fox jumps over the !", window);
+            compare(data, owned);
+            compare(data.substr(16, 19), nested);
+
+            // The last window standing takes over the source's buffer
+            owned.clear();
+            suffix.clear();
+            nested.mutable_front() = 'J';
+            TEST_REQUIRE(nested.is_owning());
+            compare("Jox jumps over the ", nested);
+        };
+
+        "from_file"_test << [=]() {
+            const std::filesystem::path path = std::filesystem::temp_directory_path() / "templatonks_from_file.txt";
+
+            auto write_file = [&path](size_t size) {
+                std::string contents(size, ' ');
+                for (size_t i = 0; i < size; ++i) {
+                    contents[i] = (char)('a' + i % 26);
+                }
+
+                std::ofstream(path, std::ios::binary) << contents;
+
+                return contents;
+            };
+
+            {
+                const std::string data = write_file(5000);
+
+                string_type mapped = mylib::string_from_file<string_type>(path);
+                TEST_REQUIRE(!mapped.is_owning());
+                TEST_REQUIRE(mapped.is_null_terminated());
+                TEST_REQUIRE(std::string_view(mapped.c_str()) == data);
+                compare(data, mapped);
+
+                string_type shared = mapped;
+                string_type window = mapped.substr(100, 50);
+                TEST_REQUIRE(!shared.is_owning());
+                TEST_REQUIRE(!window.is_owning());
+
+                shared.push_back('!');
+                TEST_REQUIRE(shared.is_owning());
+                compare(data + "!", shared);
+                compare(data, mapped);
+
+                // The window keeps the mapping alive, and has to copy out of it, rather than steal it
+                mapped.clear();
+                compare(std::string_view(data).substr(100, 50), window);
+                window.mutable_front() = 'A';
+                TEST_REQUIRE(window.is_owning());
+                compare("A" + data.substr(101, 49), window);
+            }
+
+            {
+                // Nothing past a whole page is mapped, so there's no null terminator to rely on
+                const std::string data = write_file(4096);
+
+                string_type mapped = mylib::string_from_file<string_type>(path);
+                TEST_REQUIRE(!mapped.is_owning());
+                compare(data, mapped);
+            }
+
+            {
+                const std::string data = write_file(5);
+
+                string_type mapped = mylib::string_from_file<string_type>(path);
+                TEST_REQUIRE(mapped.is_owning());
+                compare(data, mapped);
+
+            }
+
+            {
+                // Nothing gets mapped at all
+                write_file(0);
+
+                string_type empty = mylib::string_from_file<string_type>(path);
+                TEST_REQUIRE(empty.empty());
+                TEST_REQUIRE(empty.is_owning());
+                TEST_REQUIRE(*empty.c_str() == '\0');
+            }
+
+            std::filesystem::remove(path);
+
+            bool thrown = false;
+            try {
+                mylib::string_from_file<string_type>(path);
+            } catch (const std::system_error &) {
+                thrown = true;
+            }
+            TEST_REQUIRE(thrown);
+        };
+
+        "split"_test << [=]() {
+            using fields = std::vector<std::string>;
+
+            constexpr auto collect = [](auto &&range) {
+                fields result{};
+
+                for (const auto &field : range) {
+                    TEST_REQUIRE(!field.is_owning());
+                    result.emplace_back((std::string_view)field);
+                }
+
+                return result;
+            };
+
+            string_type csv{"a,,bc,"};
+            TEST_REQUIRE(collect(csv.split(',')) == fields({"a", "", "bc", ""}));
+            TEST_REQUIRE(collect(csv.split("bc")) == fields({"a,,", ","}));
+            TEST_REQUIRE(collect(string_type{}.split(',')) == fields({""}));
+            TEST_REQUIRE(collect(string_type("key = value").split(" = ")) == fields({"key", "value"}));
+            TEST_REQUIRE(collect(string_type("a b\tc  d").split_any(" \t")) == fields({"a", "b", "c", "", "d"}));
+
+            TEST_REQUIRE(collect(string_type("one\r\ntwo\n\nthree\n").lines()) == fields({"one", "two", "", "three"}));
+            TEST_REQUIRE(collect(string_type("\n").lines()) == fields({""}));
+            TEST_REQUIRE(collect(string_type{}.lines()).empty());
+
+            // Iterators keep their own copy of the delimiter, so the views may be temporaries
+            const std::string long_delim(40, '-');
+            string_type text{std::string_view("a" + long_delim + "b;c;d;e;f;g;h;i;j;k;l;m;n;o;p;q" + long_delim)};
+
+            auto substr_it = text.split(std::string(long_delim)).begin();
+            TEST_REQUIRE(*substr_it == "a");
+            TEST_REQUIRE(*++substr_it == "b;c;d;e;f;g;h;i;j;k;l;m;n;o;p;q");
+            TEST_REQUIRE(*++substr_it == "");
+            TEST_REQUIRE(++substr_it == text.split(long_delim).end());
+
+            string_type letters{"b;c;d;e;f;g;h;i;j;k;l;m;n;o;p;q"};
+            auto any_it = letters.split_any(std::string(";-")).begin();
+            for (char chr = 'b'; chr <= 'q'; ++chr, ++any_it) {
+                TEST_REQUIRE(*any_it == std::string(1, chr));
+            }
+
+            bool thrown = false;
+            try {
+                csv.split("");
+            } catch (const std::invalid_argument &) {
+                thrown = true;
+            }
+            TEST_REQUIRE(thrown);
+
+            // Long enough to go through whole SIMD blocks, and through the scalar fallback for big sets
+            for (unsigned iter = 0; iter < 100; ++iter) {
+                std::string data(abel::randLL() % 500, ' ');
+                for (auto &chr : data) {
+                    chr = "abcd,;|"[abel::randLL() % 7];
+                }
+
+                string_type str{std::string_view(data)};
+
+                for (std::string_view delims : {",", ",;", ",;|efghijk"}) {
+                    fields expected{};
+
+                    for (size_t i = 0, start = 0; i <= data.size(); ++i) {
+                        if (i == data.size() || delims.find(data[i]) != std::string_view::npos) {
+                            expected.push_back(data.substr(start, i - start));
+                            start = i + 1;
+                        }
+                    }
+
+                    TEST_REQUIRE(collect(str.split_any(delims)) == expected);
+                }
+            }
+        };
+
+        "numbers"_test << [=]() {
+            string_type str{};
+            str.append_int(0).append(1, ' ').append_int(-123).append(1, ' ')
+               .append_int(std::numeric_limits<int64_t>::min()).append(1, ' ')
+               .append_int(std::numeric_limits<uint64_t>::max()).append(1, ' ')
+               .append_int(255u, 16).append(1, ' ').append_int((int8_t)-5, 2);
+            compare("0 -123 -9223372036854775808 18446744073709551615 ff -101", str);
+
+            str.clear();
+            str.append_float(0.1).append(1, ' ').append_float(-1e300).append(1, ' ').append_float(0.25f)
+               .append(1, ' ').append_float(3.14159, std::chars_format::fixed, 2);
+            compare("0.1 -1e+300 0.25 3.14", str);
+
+            // Too long for the initial guess
+            str.clear();
+            str.append_float(1e300, std::chars_format::fixed, 3);
+            TEST_REQUIRE(str.size() == 305);
+            compare(std::format("{:.3f}", 1e300), str);
+
+            // Copies out of a view first, leaving the source alone
+            constexpr std::string_view prefix = "A prefix long enough not to be small: ";
+            string_type formatted = string_type::view(prefix.data(), prefix.size());
+            mylib::format_to(formatted, "{} + {:.1f} = {:>5}", 2, 0.5, "x");
+            TEST_REQUIRE(formatted.is_owning());
+            compare(std::string(prefix) + std::format("{} + {:.1f} = {:>5}", 2, 0.5, "x"), formatted);
+            compare(prefix, string_type::view(prefix.data(), prefix.size()));
+
+            formatted.clear();
+            formatted.append_format("{}", "");
+            TEST_REQUIRE(formatted.empty());
+            TEST_REQUIRE(formatted.is_null_terminated());
+        };
+
+        if constexpr (utest::counts_allocations) {
+            "allocations"_test << [=]() {
+                constexpr std::string_view small = "tiny";
+                constexpr std::string_view large = "Long enough to need a buffer of its very own, for sure";
+                utest::AllocCounter allocs{};
+
+                // Small strings live inline, copies and numbers included
+                {
+                    string_type str{small};
+                    string_type copy = str;
+                    copy.append_int(12345);
+                    compare("tiny12345", copy);
+                }
+                TEST_REQUIRE(allocs.allocations() == 0);
+
+                // Views don't own anything
+                string_type view = string_type::view(large.data(), large.size());
+                string_type sub = view.substr(5, 20);
+                TEST_REQUIRE(allocs.allocations() == 0);
+
+                string_type str{large};
+                TEST_REQUIRE(allocs.allocations() == 1);
+
+                // Neither do splits
+                size_t fields = 0;
+                for (const auto &field : str.split(' ')) {
+                    fields += !field.empty();
+                }
+                TEST_REQUIRE(fields == 12);
+                TEST_REQUIRE(allocs.allocations() == 1);
+
+                // Appending into reserved room doesn't reallocate
+                string_type built{};
+                built.reserve(64);
+                const size_t reserved = allocs.allocations();
+                built.append(small).append_int(-42).append(1, ' ').append_float(0.5);
+                mylib::format_to(built, " {}", 7);
+                compare("tiny-42 0.5 7", built);
+                TEST_REQUIRE(allocs.allocations() == reserved);
+            };
+        }
+
+        "hash"_test << [=]() {
+            constexpr std::string_view data = "A string long enough to be shared rather than copied";
+            const size_t expected = mylib::hash_bytes(data);
+
+            string_type owned{data};
+            string_type viewing = string_type::view(data.data(), data.size());
+            TEST_REQUIRE(owned.hash() == expected);
+            TEST_REQUIRE(viewing.hash() == expected);
+            TEST_REQUIRE(std::hash<string_type>{}(owned) == expected);
+            TEST_REQUIRE(mylib::Hash{}(data) == expected);
+
+            // Both go through the cache in the shared source now
+            string_type shared = owned;
+            TEST_REQUIRE(!shared.is_owning());
+            TEST_REQUIRE(shared.hash() == expected);
+            TEST_REQUIRE(owned.hash() == expected);
+
+            string_type window = owned.substr(2, 30);
+            TEST_REQUIRE(!window.is_owning());
+            TEST_REQUIRE(window.hash() == mylib::hash_bytes(data.substr(2, 30)));
+
+            string_type small{"short"};
+            TEST_REQUIRE(small.hash() == mylib::hash_bytes("short"));
+
+            std::unordered_set<string_type, mylib::Hash, std::equal_to<>> set{};
+            set.insert(owned);
+            set.insert(small);
+            TEST_REQUIRE(set.contains(data));
+            TEST_REQUIRE(set.contains("short"));
+            TEST_REQUIRE(!set.contains("shorts"));
+        };
+
+        if constexpr (std::is_same_v<string_type, mylib::String<>>) {
+            "hash_bytes"_test << [=]() {
+                namespace impl = mylib::_impl::hash;
+
+                std::string data(4096, ' ');
+                for (auto &chr : data) {
+                    chr = (char)abel::randLL();
+                }
+
+                std::unordered_set<uint64_t> seen{};
+
+                for (size_t size = 0; size <= data.size(); ++size) {
+                    const uint64_t result = impl::hash_bytes(data.data(), size);
+                    TEST_REQUIRE(seen.insert(result).second);
+
+                    if (size > impl::long_threshold) {
+                        const unsigned char *ptr = (const unsigned char *)data.data();
+
+                        TEST_REQUIRE(result == impl::hash_long<impl::Scalar>(ptr, size, 0));
+                        #if HASH_USE_SSE2_
+                        TEST_REQUIRE(result == impl::hash_long<impl::Sse2>(ptr, size, 0));
+                        #endif
+                    }
+                }
+
+                // Flipping any bit of the input or changing the seed changes the result
+                for (size_t size : {3, 8, 13, 40, 100, 1000, 3000}) {
+                    const uint64_t original = impl::hash_bytes(data.data(), size);
+                    TEST_REQUIRE(impl::hash_bytes(data.data(), size, 1) != original);
+
+                    for (size_t bit = 0; bit < size * 8; bit += 7) {
+                        data[bit / 8] ^= (char)(1 << (bit % 8));
+                        TEST_REQUIRE(impl::hash_bytes(data.data(), size) != original);
+                        data[bit / 8] ^= (char)(1 << (bit % 8));
+                    }
+                }
+            };
+
+            "literals"_test << [=]() {
+                using namespace mylib::string_literals;
+                using namespace std::string_view_literals;
+
+                constexpr std::string_view data = "Hell\0o!"sv;
+
+                auto str = "Hell\0o!"_s;
+                static_assert(std::is_same_v<decltype(str), string_type>);
+                TEST_REQUIRE(str.is_owning());
+
+                compare(data, str);
+
+                auto str_view = "Hell\0o!"_sv;
+                static_assert(std::is_same_v<decltype(str_view), string_type>);
+                TEST_REQUIRE(!str_view.is_owning());
+
+                compare(data, str_view);
+            };
+        }
+
+        if constexpr (string_type::refcount_type::is_thread_safe) {
+            "shared_across_threads"_test << [=]() {
+                constexpr unsigned threads = 4;
+                constexpr unsigned iterations = 10000;
+
+                std::string_view data = "Long enough not to fit into the small buffer";
+                string_type str{data};
+
+                std::atomic<bool> ok = true;
+                std::vector<std::thread> workers{};
+
+                for (unsigned i = 0; i < threads; ++i) {
+                    // Shares the source, like any non-const copy
+                    workers.emplace_back([&ok, data, local = string_type(str)]() mutable {
+                        for (unsigned j = 0; j < iterations; ++j) {
+                            string_type copy = local;
+
+                            if (j % 16 == 0) {
+                                copy.ensure_ownership();
+                            }
+
+                            if ((std::string_view)copy != data) {
+                                ok = false;
+                            }
+                        }
+                    });
+                }
+
+                for (auto &worker : workers) {
+                    worker.join();
+                }
+
+                TEST_REQUIRE(ok);
+                compare(data, str);
+            };
+        }
+
+        // TODO: Tests for views, ordered-comparison
+    }
+
+    void test_compare_eq(const auto &source) {
+        using namespace utest::literals;
+
+        "compare_eq"_test << [=]() {
+            string_type str{source};
+
+            TEST_REQUIRE(source == str);
+            TEST_REQUIRE(str == source);
+        };
+    }
+};
+#pragma endregion StringTester
+
+
+#pragma region RopeTester
+class RopeTester {
+public:
+    using rope_type = mylib::Rope<>;
+    using string_type = rope_type::string_type;
+
+
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing %s\n", typeid(rope_type).name());
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+
+        constexpr auto compare = [](std::string_view data, const rope_type &rope) {
+            TEST_REQUIRE(rope.size() == data.size());
+
+            std::string contents{};
+            rope.for_each_chunk([&](std::string_view chunk) {
+                contents += chunk;
+            });
+
+            TEST_REQUIRE(contents == data);
+        };
+
+        constexpr auto random_text = [](size_t size) {
+            std::string result(size, ' ');
+
+            for (auto &chr : result) {
+                chr = (char)('a' + abel::randLL() % 26);
+            }
+
+            return result;
+        };
+
+        "append_index"_test << [=]() {
+            std::string data{};
+            rope_type rope{};
+
+            for (unsigned i = 0; i < 200; ++i) {
+                std::string piece = random_text(abel::randLL() % (i % 2 ? 20 : 10000));
+
+                data += piece;
+                rope += piece;
+            }
+
+            compare(data, rope);
+
+            for (unsigned i = 0; i < 1000; ++i) {
+                size_t idx = abel::randLL() % data.size();
+                TEST_REQUIRE(rope[idx] == data[idx]);
+            }
+        };
+
+        "shares_chunks"_test << [=]() {
+            string_type chunk{std::string_view(random_text(10000))};
+            rope_type rope{};
+
+            rope += chunk;
+            rope += chunk;
+
+            // Neither append copied the characters
+            TEST_REQUIRE(!chunk.is_owning());
+            compare((std::string_view)chunk, rope.substr(0, chunk.size()));
+        };
+
+        "early_seal"_test << [=]() {
+            constexpr unsigned leaves = 32;
+
+            const std::string piece = random_text(30);
+            const std::string long_piece = random_text(rope_type::leaf_size);
+
+            utest::AllocCounter counter{};
+            rope_type rope{};
+
+            // Every long append seals the short tail before it
+            for (unsigned i = 0; i < leaves; ++i) {
+                rope += piece;
+                rope += long_piece;
+            }
+
+            compare([&]() {
+                std::string data{};
+                for (unsigned i = 0; i < leaves; ++i) {
+                    data += piece;
+                    data += long_piece;
+                }
+
+                return data;
+            }(), rope);
+
+            // Keeping a whole leaf's room for every short one would take twice the long ones' size
+            if constexpr (utest::counts_allocations) {
+                TEST_REQUIRE(counter.stats().live_bytes < (ptrdiff_t)(leaves * rope_type::leaf_size * 7 / 4));
+            }
+        };
+
+        "concat_balance"_test << [=]() {
+            std::string data{};
+            rope_type rope{};
+
+            for (unsigned i = 0; i < 1000; ++i) {
+                std::string piece = random_text(rope_type::leaf_size + abel::randLL() % 100);
+
+                data += piece;
+                rope = rope + rope_type(piece);
+            }
+
+            compare(data, rope);
+
+            // 1000 leaves in an AVL tree
+            TEST_REQUIRE(rope.height() <= 15);
+
+            rope_type doubled = rope + rope;
+            compare(data + data, doubled);
+            TEST_REQUIRE(doubled.height() <= rope.height() + 1);
+        };
+
+        "substr"_test << [=]() {
+            std::string data{};
+            rope_type rope{};
+
+            for (unsigned i = 0; i < 50; ++i) {
+                std::string piece = random_text(abel::randLL() % 10000);
+
+                data += piece;
+                rope += piece;
+            }
+
+            for (unsigned i = 0; i < 100; ++i) {
+                size_t pos = abel::randLL() % data.size();
+                size_t count = abel::randLL() % (data.size() - pos + 1);
+
+                compare(std::string_view(data).substr(pos, count), rope.substr(pos, count));
+            }
+
+            TEST_REQUIRE(rope.substr(data.size()).empty());
+        };
+
+        "flatten"_test << [=]() {
+            std::string data{};
+            rope_type rope{};
+
+            for (unsigned i = 0; i < 100; ++i) {
+                std::string piece = random_text(abel::randLL() % 5000);
+
+                data += piece;
+                rope += piece;
+            }
+
+            string_type flat = rope.flatten();
+            TEST_REQUIRE((std::string_view)flat == data);
+            TEST_REQUIRE(flat.is_owning());
+            TEST_REQUIRE(flat.is_null_terminated());
+        };
+    }
+};
+#pragma endregion RopeTester
+
+
+#pragma region InternTester
+class InternTester {
+public:
+    using pool_type = mylib::InternPool<>;
+
+
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing %s\n", typeid(pool_type).name());
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+
+        "identity"_test << [=]() {
+            pool_type pool{};
+
+            std::string first = "identifier";
+            std::string second = "identifier";
+
+            mylib::Atom a = pool.intern(first);
+            mylib::Atom b = pool.intern(second);
+            mylib::Atom c = pool.intern("identifiers");
+
+            TEST_REQUIRE(a == b);
+            TEST_REQUIRE(a != c);
+            TEST_REQUIRE(a.view() == "identifier");
+            TEST_REQUIRE(a.view().data() != first.data());
+            TEST_REQUIRE(a.hash() == mylib::hash_bytes("identifier"));
+            TEST_REQUIRE(std::hash<mylib::Atom>{}(a) == a.hash());
+            TEST_REQUIRE(mylib::Hash{}(a) == mylib::Hash{}("identifier"));
+            TEST_REQUIRE(pool.size() == 2);
+
+            TEST_REQUIRE(pool.find("identifier") == a);
+            TEST_REQUIRE(!pool.find("missing"));
+            TEST_REQUIRE(!mylib::Atom{});
+        };
+
+        "views"_test << [=]() {
+            pool_type pool{};
+
+            mylib::Atom atom = pool.intern(mylib::String<>("some string"));
+            mylib::String<> str = atom.str();
+
+            TEST_REQUIRE(!str.is_owning());
+            TEST_REQUIRE(str.is_null_terminated());
+            TEST_REQUIRE(str.c_str() == atom.c_str());
+            TEST_REQUIRE(str == "some string");
+
+            mylib::Atom empty = pool.intern("");
+            TEST_REQUIRE(empty);
+            TEST_REQUIRE(empty.size() == 0);
+            TEST_REQUIRE(*empty.c_str() == '\0');
+        };
+
+        "many"_test << [=]() {
+            pool_type pool{};
+            std::vector<mylib::Atom> atoms{};
+
+            for (unsigned i = 0; i < 100000; ++i) {
+                atoms.push_back(pool.intern(abel::sprintfxx("name_%u", i)));
+            }
+
+            // A few that don't fit into a regular arena block
+            for (unsigned i = 0; i < 10; ++i) {
+                atoms.push_back(pool.intern(std::string(100000 + i, 'x')));
+            }
+
+            TEST_REQUIRE(pool.size() == atoms.size());
+
+            for (unsigned i = 0; i < 100000; ++i) {
+                TEST_REQUIRE(pool.intern(abel::sprintfxx("name_%u", i)) == atoms[i]);
+                TEST_REQUIRE(atoms[i].view() == abel::sprintfxx("name_%u", i));
+            }
+
+            TEST_REQUIRE(atoms.back().size() == 100009);
+        };
+
+        "threads"_test << [=]() {
+            constexpr unsigned thread_count = 8;
+            // Prime, so that every stride below is a permutation
+            constexpr unsigned name_count = 20011;
+
+            pool_type pool{};
+            std::vector<std::vector<mylib::Atom>> results(thread_count);
+            std::vector<std::thread> threads{};
+
+            for (unsigned t = 0; t < thread_count; ++t) {
+                threads.emplace_back([&, t]() {
+                    auto &atoms = results[t];
+                    atoms.resize(name_count);
+
+                    // Different threads walk the names in different orders
+                    for (unsigned i = 0; i < name_count; ++i) {
+                        unsigned idx = (i * (2 * t + 1)) % name_count;
+                        atoms[idx] = pool.intern(abel::sprintfxx("name_%u", idx));
+                    }
+                });
+            }
+
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            TEST_REQUIRE(pool.size() == name_count);
+
+            for (unsigned t = 1; t < thread_count; ++t) {
+                TEST_REQUIRE(results[t] == results[0]);
+            }
+        };
+    }
+};
+#pragma endregion InternTester
+
+
+#pragma region FunctionTester
+class FunctionTester {
+public:
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing mylib::Function\n");
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    /// Tracks how many of it are alive, to catch leaks and double destruction
+    template <size_t Size>
+    struct Counted {
+        static inline int alive = 0;
+
+        std::array<int, Size> data{};
+
+
+        Counted(int value) noexcept {
+            data[0] = value;
+            ++alive;
+        }
+
+        Counted(const Counted &other) noexcept : data{other.data} {
+            ++alive;
+        }
+
+        Counted(Counted &&other) noexcept : data{other.data} {
+            ++alive;
+        }
+
+        ~Counted() {
+            --alive;
+        }
+
+        int operator()(int x) const {
+            return x + data[0];
+        }
+    };
+
+    /// Shared by all the rebinds of TrackingAllocator
+    struct AllocationStats {
+        static inline int allocated = 0;
+        static inline int deallocated = 0;
+    };
+
+    /// Counts what goes through it, to see which targets end up on the heap
+    template <typename T>
+    struct TrackingAllocator : std::allocator<T>, AllocationStats {
+        TrackingAllocator() = default;
+
+        template <typename U>
+        TrackingAllocator(const TrackingAllocator<U> &) {}
+
+        T *allocate(size_t n) {
+            ++allocated;
+
+            return std::allocator<T>::allocate(n);
+        }
+
+        void deallocate(T *ptr, size_t n) {
+            ++deallocated;
+
+            std::allocator<T>::deallocate(ptr, n);
+        }
+    };
+
+    void test_all() {
+        using namespace utest::literals;
+        using func_type = mylib::Function<int (int)>;
+
+        "call"_test << [=]() {
+            func_type small = [](int x) { return x * 2; };
+            TEST_REQUIRE(small.is_small());
+            TEST_REQUIRE(small(21) == 42);
+
+            std::array<int, 64> table{};
+            table[5] = 7;
+            func_type large = [table](int x) { return table[x]; };
+            TEST_REQUIRE(!large.is_small());
+            TEST_REQUIRE(large(5) == 7);
+
+            func_type pointer = +[](int x) { return -x; };
+            TEST_REQUIRE(pointer(3) == -3);
+
+            // Results convertible to R, and R = void discarding them
+            mylib::Function<long (short)> widening = [](int x) { return x + 1; };
+            TEST_REQUIRE(widening(1) == 2);
+
+            int calls = 0;
+            mylib::Function<void ()> discarding = [&calls]() { return ++calls; };
+            discarding();
+            TEST_REQUIRE(calls == 1);
+
+            // Move-only arguments are forwarded all the way through
+            mylib::Function<int (std::unique_ptr<int>)> sink = [](std::unique_ptr<int> ptr) { return *ptr; };
+            TEST_REQUIRE(sink(std::make_unique<int>(9)) == 9);
+        };
+
+        "empty"_test << [=]() {
+            func_type func{};
+            TEST_REQUIRE(!func);
+            TEST_REQUIRE(func == nullptr);
+            TEST_REQUIRE(!func.is_small());
+            TEST_REQUIRE(func.target_type() == typeid(void));
+
+            bool thrown = false;
+            try {
+                func(1);
+            } catch (const std::bad_function_call &) {
+                thrown = true;
+            }
+            TEST_REQUIRE(thrown);
+
+            func_type copy = func;
+            func_type moved = std::move(func);
+            TEST_REQUIRE(!copy && !moved);
+        };
+
+        "copy_move"_test << [=]() {
+            auto check = [](auto counted) {
+                using counted_type = decltype(counted);
+
+                {
+                    func_type func = counted;
+                    TEST_REQUIRE(counted_type::alive == 2);
+
+                    func_type copy = func;
+                    TEST_REQUIRE(counted_type::alive == 3);
+                    TEST_REQUIRE(copy(1) == func(1));
+
+                    func_type moved = std::move(func);
+                    TEST_REQUIRE(!func);
+                    TEST_REQUIRE(counted_type::alive == 3);
+                    TEST_REQUIRE(moved(1) == copy(1));
+
+                    copy = moved;
+                    TEST_REQUIRE(counted_type::alive == 3);
+
+                    copy = std::move(moved);
+                    TEST_REQUIRE(!moved);
+                    TEST_REQUIRE(counted_type::alive == 2);
+
+                    copy = copy;
+                    copy = std::move(copy);
+                    TEST_REQUIRE(copy(1) == counted(1));
+
+                    copy = [](int x) { return x; };
+                    TEST_REQUIRE(counted_type::alive == 1);
+                    TEST_REQUIRE(copy(1) == 1);
+
+                    copy = counted;
+                    copy = nullptr;
+                    TEST_REQUIRE(!copy);
+                }
+
+                TEST_REQUIRE(counted_type::alive == 1);
+            };
+
+            check(Counted<1>(10));
+            check(Counted<64>(20));
+            TEST_REQUIRE(func_type(Counted<1>(0)).is_small());
+            TEST_REQUIRE(!func_type(Counted<64>(0)).is_small());
+
+            // Trivially copyable targets are moved by memcpy
+            func_type trivial = [value = 5](int x) { return x + value; };
+            func_type relocated = std::move(trivial);
+            TEST_REQUIRE(relocated(1) == 6);
+        };
+
+        "target"_test << [=]() {
+            auto lambda = [value = 3](int x) { return x * value; };
+            func_type func = lambda;
+
+            TEST_REQUIRE(func.target_type() == typeid(lambda));
+            TEST_REQUIRE(func.target<decltype(lambda)>() != nullptr);
+            TEST_REQUIRE(func.target<int (*)(int)>() == nullptr);
+            TEST_REQUIRE((*func.target<decltype(lambda)>())(2) == 6);
+
+            func_type large = Counted<64>(4);
+            TEST_REQUIRE(large.target<Counted<64>>()->data[0] == 4);
+        };
+
+        "function_ref"_test << [=]() {
+            using ref_type = mylib::FunctionRef<int (int)>;
+
+            TEST_REQUIRE(std::is_trivially_copyable_v<ref_type>);
+            TEST_REQUIRE(sizeof(ref_type) == 2 * sizeof(void *));
+
+            constexpr auto apply = [](ref_type func, int x) {
+                return func(x);
+            };
+
+            // Refers to the lambda, rather than copying it
+            int calls = 0;
+            auto counting = [&calls](int x) { ++calls; return x + 1; };
+            ref_type ref = counting;
+            TEST_REQUIRE(apply(ref, 1) == 2);
+            TEST_REQUIRE(apply(ref, 2) == 3);
+            TEST_REQUIRE(calls == 2);
+
+            std::array<int, 64> table{};
+            table[3] = 30;
+            TEST_REQUIRE(apply([table](int x) { return table[x]; }, 3) == 30);
+
+            const auto constant = [](int x) { return -x; };
+            TEST_REQUIRE(apply(constant, 4) == -4);
+
+            int (*pointer)(int) = [](int x) { return x * 3; };
+            ref_type from_pointer = pointer;
+            pointer = nullptr;
+            TEST_REQUIRE(from_pointer(2) == 6);
+
+            // Goes straight to the Function's target, which may change in place
+            Counted<64>::alive = 0;
+            func_type func = Counted<64>(7);
+            ref_type from_func = func;
+            TEST_REQUIRE(from_func(1) == 8);
+            func.target<Counted<64>>()->data[0] = 9;
+            TEST_REQUIRE(from_func(1) == 10);
+            TEST_REQUIRE(Counted<64>::alive == 1);
+
+            ref_type copy = from_func;
+            copy = ref;
+            TEST_REQUIRE(copy(0) == 1);
+            TEST_REQUIRE(calls == 3);
+
+            mylib::FunctionRef deduced = counting;
+            TEST_REQUIRE(deduced(5) == 6);
+
+            auto consume = [&calls](std::unique_ptr<int> &&ptr) {
+                calls += *ptr;
+            };
+            mylib::FunctionRef<void (std::unique_ptr<int> &&)> sink = consume;
+            sink(std::make_unique<int>(10));
+            TEST_REQUIRE(calls == 14);
+        };
+
+        "move_only"_test << [=]() {
+            using move_type = mylib::MoveFunction<int (int)>;
+
+            TEST_REQUIRE(std::is_copy_constructible_v<func_type>);
+            TEST_REQUIRE(!std::is_copy_constructible_v<move_type>);
+            TEST_REQUIRE(!std::is_copy_assignable_v<move_type>);
+            TEST_REQUIRE(std::is_nothrow_move_constructible_v<move_type>);
+            TEST_REQUIRE(sizeof(move_type) == sizeof(func_type));
+
+            // Inline, despite not being copyable
+            move_type small = [ptr = std::make_unique<int>(5)](int x) { return x + *ptr; };
+            TEST_REQUIRE(small.is_small());
+            TEST_REQUIRE(small(1) == 6);
+
+            std::array<int, 64> table{};
+            table[1] = 3;
+            move_type large = [ptr = std::make_unique<int>(7), table](int x) { return *ptr + table[x]; };
+            TEST_REQUIRE(!large.is_small());
+            TEST_REQUIRE(large(1) == 10);
+
+            move_type moved = std::move(small);
+            TEST_REQUIRE(!small);
+            TEST_REQUIRE(moved(1) == 6);
+
+            moved = std::move(large);
+            TEST_REQUIRE(!large);
+            TEST_REQUIRE(moved(1) == 10);
+
+            mylib::FunctionRef<int (int)> ref = moved;
+            TEST_REQUIRE(ref(1) == 10);
+
+            // Copyable targets and whole Functions are welcome too
+            moved = [](int x) { return x; };
+            TEST_REQUIRE(moved(4) == 4);
+
+            func_type copyable = [](int x) { return -x; };
+            moved = std::move(copyable);
+            TEST_REQUIRE(moved(4) == -4);
+
+            // Destroys what it holds exactly once, wherever it's moved
+            Counted<1>::alive = 0;
+            Counted<64>::alive = 0;
+            {
+                std::vector<mylib::MoveFunction<int ()>> jobs{};
+
+                for (int i = 0; i < 100; ++i) {
+                    jobs.emplace_back([counted = Counted<1>(i), ptr = std::make_unique<int>(i)]() {
+                        return counted(0) + *ptr;
+                    });
+                    jobs.emplace_back([counted = Counted<64>(i)]() mutable {
+                        return counted(0);
+                    });
+                }
+
+                TEST_REQUIRE(Counted<1>::alive == 100);
+                TEST_REQUIRE(Counted<64>::alive == 100);
+
+                int sum = 0;
+                for (auto &job : jobs) {
+                    sum += job();
+                }
+                TEST_REQUIRE(sum == 3 * 99 * 100 / 2);
+            }
+            TEST_REQUIRE(Counted<1>::alive == 0);
+            TEST_REQUIRE(Counted<64>::alive == 0);
+        };
+
+        "shared"_test << [=]() {
+            Counted<64>::alive = 0;
+
+            {
+                func_type shared = func_type::shared(Counted<64>(5));
+                TEST_REQUIRE(shared.is_shared());
+                TEST_REQUIRE(!shared.is_small());
+                TEST_REQUIRE(Counted<64>::alive == 1);
+                TEST_REQUIRE(shared(1) == 6);
+
+                // Copies only bump the reference count
+                std::vector<func_type> copies(100, shared);
+                TEST_REQUIRE(Counted<64>::alive == 1);
+                TEST_REQUIRE(copies[99].is_shared());
+                TEST_REQUIRE(copies[99](2) == 7);
+                TEST_REQUIRE(copies[99].target<Counted<64>>() == shared.target<Counted<64>>());
+
+                func_type moved = std::move(shared);
+                TEST_REQUIRE(!shared);
+                TEST_REQUIRE(moved(1) == 6);
+
+                copies.clear();
+                moved = nullptr;
+                TEST_REQUIRE(Counted<64>::alive == 0);
+
+                // Small targets can be shared too, and plain copies of non-shared ones stay deep
+                func_type small = func_type::shared([](int x) { return x; });
+                TEST_REQUIRE(small.is_shared());
+                TEST_REQUIRE(small(3) == 3);
+
+                func_type deep = Counted<64>(1);
+                func_type deep_copy = deep;
+                TEST_REQUIRE(!deep_copy.is_shared());
+                TEST_REQUIRE(Counted<64>::alive == 2);
+            }
+
+            TEST_REQUIRE(Counted<64>::alive == 0);
+
+            // Copied and dropped from several threads at once
+            {
+                func_type shared = func_type::shared<mylib::AtomicRefCount>(Counted<64>(1));
+                std::vector<std::thread> threads{};
+                std::atomic<int> sum = 0;
+
+                for (unsigned t = 0; t < 4; ++t) {
+                    threads.emplace_back([&shared, &sum]() {
+                        for (unsigned i = 0; i < 1000; ++i) {
+                            func_type copy = shared;
+                            sum += copy(0);
+                        }
+                    });
+                }
+
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+
+                TEST_REQUIRE(sum == 4000);
+                TEST_REQUIRE(Counted<64>::alive == 1);
+            }
+
+            TEST_REQUIRE(Counted<64>::alive == 0);
+        };
+
+        if constexpr (utest::counts_allocations) {
+            "allocations"_test << [=]() {
+                utest::AllocCounter allocs{};
+
+                {
+                    func_type small = [](int x) { return x; };
+                    func_type copy = small;
+                    func_type moved = std::move(copy);
+
+                    mylib::FunctionRef<int (int)> ref = moved;
+                    TEST_REQUIRE(ref(1) == 1);
+                }
+                TEST_REQUIRE(allocs.allocations() == 0);
+
+                std::array<int, 64> table{};
+                table[1] = 5;
+
+                func_type large = [table](int x) { return table[x]; };
+                TEST_REQUIRE(allocs.allocations() == 1);
+
+                func_type moved = std::move(large);
+                TEST_REQUIRE(allocs.allocations() == 1);
+
+                func_type copy = moved;
+                TEST_REQUIRE(allocs.allocations() == 2);
+                TEST_REQUIRE(copy(1) == 5);
+
+                // Shared targets are allocated once, however many copies there are
+                std::array<func_type, 8> subscribers{};
+                subscribers.fill(func_type::shared([table](int x) { return table[x]; }));
+                TEST_REQUIRE(allocs.allocations() == 3);
+                TEST_REQUIRE(subscribers[7](1) == 5);
+            };
+        }
+
+        "inline_size"_test << [=]() {
+            using tiny_type = mylib::Function<int (int), true, 8>;
+            using roomy_type = mylib::Function<int (int), true, 256>;
+
+            TEST_REQUIRE(sizeof(tiny_type) == 3 * sizeof(void *));
+            TEST_REQUIRE(sizeof(roomy_type) == 256 + 2 * sizeof(void *));
+            TEST_REQUIRE(sizeof(mylib::MoveFunction<int (int), 8>) == sizeof(tiny_type));
+
+            TEST_REQUIRE(tiny_type(Counted<2>(0)).is_small());
+            TEST_REQUIRE(!tiny_type(Counted<4>(0)).is_small());
+            TEST_REQUIRE(!func_type(Counted<64>(0)).is_small());
+            TEST_REQUIRE(roomy_type(Counted<64>(0)).is_small());
+
+            Counted<64>::alive = 0;
+            {
+                roomy_type roomy = Counted<64>(3);
+                roomy_type copy = roomy;
+                roomy_type moved = std::move(roomy);
+                TEST_REQUIRE(!roomy);
+                TEST_REQUIRE(copy(1) == 4);
+                TEST_REQUIRE(moved(1) == 4);
+                TEST_REQUIRE(Counted<64>::alive == 2);
+
+                // Any configuration can be borrowed
+                mylib::FunctionRef ref = moved;
+                TEST_REQUIRE(ref(2) == 5);
+            }
+            TEST_REQUIRE(Counted<64>::alive == 0);
+
+            // Overaligned targets need an overaligned buffer to stay inline
+            struct alignas(32) Aligned {
+                int value;
+
+                int operator()(int x) const {
+                    TEST_REQUIRE((uintptr_t)this % 32 == 0);
+
+                    return x + value;
+                }
+            };
+
+            func_type plain = Aligned{1};
+            TEST_REQUIRE(!plain.is_small());
+            TEST_REQUIRE(plain(1) == 2);
+
+            mylib::Function<int (int), true, 32, 32> aligned = Aligned{2};
+            TEST_REQUIRE(aligned.is_small());
+            TEST_REQUIRE(aligned(1) == 3);
+
+            auto aligned_copy = aligned;
+            TEST_REQUIRE(aligned_copy(2) == 4);
+        };
+
+        "allocator"_test << [=]() {
+            using alloc_type = TrackingAllocator<std::byte>;
+            using tracked_type = mylib::Function<int (int), true, mylib::default_func_inline_size,
+                                                 alignof(void *), alloc_type>;
+
+            alloc_type::allocated = 0;
+            alloc_type::deallocated = 0;
+            Counted<64>::alive = 0;
+
+            {
+                tracked_type small = [](int x) { return x; };
+                TEST_REQUIRE(small.is_small());
+                TEST_REQUIRE(alloc_type::allocated == 0);
+
+                tracked_type large(std::allocator_arg, alloc_type(), Counted<64>(2));
+                TEST_REQUIRE(alloc_type::allocated == 1);
+                TEST_REQUIRE(large(1) == 3);
+
+                tracked_type copy = large;
+                TEST_REQUIRE(alloc_type::allocated == 2);
+                TEST_REQUIRE(copy(1) == 3);
+
+                // Moves just hand the block over
+                tracked_type moved = std::move(copy);
+                TEST_REQUIRE(alloc_type::allocated == 2);
+
+                tracked_type shared = tracked_type::shared(Counted<64>(4));
+                tracked_type shared_copy = shared;
+                TEST_REQUIRE(alloc_type::allocated == 3);
+                TEST_REQUIRE(shared_copy(1) == 5);
+
+                mylib::MoveFunction<int (), mylib::default_func_inline_size, alignof(void *), alloc_type> owner =
+                    [ptr = std::make_unique<int>(5), pad = Counted<64>(0)]() { return *ptr; };
+                TEST_REQUIRE(alloc_type::allocated == 4);
+                TEST_REQUIRE(owner() == 5);
+
+                TEST_REQUIRE(Counted<64>::alive == 4);
+            }
+
+            TEST_REQUIRE(alloc_type::deallocated == alloc_type::allocated);
+            TEST_REQUIRE(Counted<64>::alive == 0);
+
+            // A target that throws while being copied onto the heap doesn't leak the block
+            struct Throwing {
+                std::array<int, 64> data{};
+
+                Throwing() = default;
+
+                Throwing(const Throwing &) {
+                    throw std::runtime_error("No copies");
+                }
+
+                int operator()(int x) const {
+                    return x;
+                }
+            };
+
+            Throwing throwing{};
+            alloc_type::allocated = 0;
+            alloc_type::deallocated = 0;
+
+            bool thrown = false;
+            try {
+                tracked_type func = throwing;
+            } catch (const std::runtime_error &) {
+                thrown = true;
+            }
+
+            TEST_REQUIRE(thrown);
+            TEST_REQUIRE(alloc_type::allocated == 1);
+            TEST_REQUIRE(alloc_type::deallocated == 1);
+        };
+    }
+};
+#pragma endregion FunctionTester
+
+
+#pragma region VectorTester
+class VectorTester {
+public:
+    void test() {
+        utest::Test::reset();
+
+        utest::log("Testing math_test::Vector\n");
+
+        test_all();
+
+        utest::Test::sum_up();
+    }
+
+    void test_all() {
+        using namespace utest::literals;
+        using namespace math_test;
+
+        // Constant evaluation has to get around the intrinsics
+        static_assert(Vector<float, 4>{1, 2, 3, 4} * Vector<float, 4>{4, 3, 2, 1} == 20);
+        static_assert(Vector<int, 3, RecursiveKernel>{1, 2, 3} * Vector<int, 3, RecursiveKernel>{4, 5, 6} == 32);
+        static_assert(Vector<double, 3>{1, 2, 3} + Vector<double, 3>{3, 2, 1} == Vector<double, 3>::filled(4));
+        static_assert(Matrix<int, 2, 2>::identity() * Vector<int, 2>{3, 4} == Vector<int, 2>{3, 4});
+
+        "dot"_test << []() {
+            check_kernels<float, 2>();
+            check_kernels<float, 3>();
+            check_kernels<float, 4>();
+            check_kernels<float, 8>();
+            check_kernels<float, 16>();
+            check_kernels<double, 2>();
+            check_kernels<double, 3>();
+            check_kernels<double, 4>();
+            check_kernels<double, 8>();
+            check_kernels<double, 16>();
+            check_kernels<long, 7>();
+        };
+
+        "arithmetic"_test << []() {
+            check_arithmetic<float, 3>();
+            check_arithmetic<float, 8>();
+            check_arithmetic<float, 13>();
+            check_arithmetic<double, 3>();
+            check_arithmetic<double, 16>();
+            check_arithmetic<int, 5>();
+        };
+
+        "geometry"_test << []() {
+            using vec3 = Vector<double, 3>;
+
+            vec3 x{1, 0, 0};
+            vec3 y{0, 1, 0};
+
+            TEST_REQUIRE(cross(x, y) == (vec3{0, 0, 1}));
+            TEST_REQUIRE(cross(y, x) == -cross(x, y));
+            TEST_REQUIRE(cross(x, x) == vec3{});
+
+            vec3 v{3, 0, 4};
+            TEST_REQUIRE(v.length() == 5);
+            TEST_REQUIRE(std::abs(v.normalized().length() - 1) < 1e-12);
+            TEST_REQUIRE(std::abs(v.normalized()[2] - 0.8) < 1e-12);
+
+            Vector<float, 16> wide = Vector<float, 16>::filled(2);
+            TEST_REQUIRE(wide.length() == 8);
+        };
+
+        "matrix"_test << []() {
+            using mat = Matrix<float, 2, 3>;
+
+            mat m{{{1, 2, 3}, {4, 5, 6}}};
+
+            TEST_REQUIRE(m(1, 2) == 6);
+            TEST_REQUIRE((m * Vector<float, 3>{1, 1, 1} == Vector<float, 2>{6, 15}));
+            TEST_REQUIRE(m.transposed().transposed() == m);
+            TEST_REQUIRE(m.transposed()(2, 0) == 3);
+
+            Matrix<float, 2, 2> gram = m * m.transposed();
+            TEST_REQUIRE((gram == Matrix<float, 2, 2>{{{14, 32}, {32, 77}}}));
+            TEST_REQUIRE((Matrix<float, 2, 2>::identity() * m == m));
+            TEST_REQUIRE(m + m == m * 2.f);
+            TEST_REQUIRE(m - m == mat{});
+
+            // Rotating by a quarter turn four times over brings everything back
+            Matrix<double, 3, 3> rot{{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}};
+            Matrix<double, 3, 3> full = rot * rot * rot * rot;
+            TEST_REQUIRE((full == Matrix<double, 3, 3>::identity()));
+        };
+    }
+
+protected:
+    template <typename T, size_t N, typename Kernel>
+    static math_test::Vector<T, N, Kernel> make(int seed) {
+        math_test::Vector<T, N, Kernel> result{};
+
+        // Small integers, so that the order of summation doesn't matter
+        for (size_t i = 0; i < N; ++i) {
+            result[i] = (T)((int)(i * 7 + seed) % 11 - 5);
+        }
+
+        return result;
+    }
+
+    template <typename T, size_t N>
+    static void check_kernels() {
+        using namespace math_test;
+
+        T expected = 0;
+        for (size_t i = 0; i < N; ++i) {
+            expected += make<T, N, FoldKernel>(1)[i] * make<T, N, FoldKernel>(2)[i];
+        }
+
+        TEST_REQUIRE((make<T, N, RecursiveKernel>(1) * make<T, N, RecursiveKernel>(2) == expected));
+        TEST_REQUIRE((make<T, N, FoldKernel>(1) * make<T, N, FoldKernel>(2) == expected));
+        TEST_REQUIRE((make<T, N, SimdKernel>(1) * make<T, N, SimdKernel>(2) == expected));
+    }
+
+    template <typename T, size_t N>
+    static void check_arithmetic() {
+        using namespace math_test;
+        using vec = Vector<T, N>;
+
+        const vec a = make<T, N, SimdKernel>(3);
+        const vec b = make<T, N, SimdKernel>(8);
+
+        vec sum = a + b;
+        vec diff = a - b;
+        vec scaled = a * (T)3;
+        vec halved = (a * (T)4) / (T)2;
+        vec negated = -a;
+        vec product = hadamard(a, b);
+
+        for (size_t i = 0; i < N; ++i) {
+            TEST_REQUIRE(sum[i] == a[i] + b[i]);
+            TEST_REQUIRE(diff[i] == a[i] - b[i]);
+            TEST_REQUIRE(scaled[i] == a[i] * 3);
+            TEST_REQUIRE(halved[i] == a[i] * 2);
+            TEST_REQUIRE(negated[i] == -a[i]);
+            TEST_REQUIRE(product[i] == a[i] * b[i]);
+        }
+
+        vec acc = a;
+        acc += acc;
+        acc -= a;
+        TEST_REQUIRE(acc == a);
+    }
+};
+#pragma endregion VectorTester
+
+
+#pragma region Benchmarks
+#pragma region MdArrayBench
+template <typename Layout>
+class MdArrayBench {
+public:
+    using array_type = mylib::MdArray<int, 2, mylib::DynamicLinearStorage, Layout>;
+    using index_type = array_type::index_type;
+
+    static constexpr size_t side = 2048;
+
+
+    void run() {
+        utest::log("MdArray benchmarks for %s:\n", typeid(Layout).name());
+        utest::LogBlock block{};
+
+        array_type src(side, side);
+        array_type dst(side, side);
+
+        src.for_each([](const index_type &idx, int &item) {
+            item = (int)(idx[0] ^ idx[1]);
+        });
+
+        utest::bench("transpose (naive, row by row)", [&]() {
+            for (size_t i = 0; i < side; ++i) {
+                for (size_t j = 0; j < side; ++j) {
+                    dst(j, i) = src(i, j);
+                }
+            }
+        });
+
+        utest::bench("transpose (tile-wise)", [&]() {
+            src.for_each_tile([&](auto tile) {
+                tile.for_each([&](const index_type &idx, const int &item) {
+                    index_type parent = tile.parent_index(idx);
+                    dst(parent[1], parent[0]) = item;
+                });
+            });
+        });
+
+        utest::bench("stencil (5-point, layout order)", [&]() {
+            src.for_each([&](const index_type &idx, const int &item) {
+                size_t i = idx[0];
+                size_t j = idx[1];
+
+                if (i == 0 || j == 0 || i == side - 1 || j == side - 1) {
+                    dst(i, j) = item;
+                    return;
+                }
+
+                dst(i, j) = (item + src(i - 1, j) + src(i + 1, j) +
+                             src(i, j - 1) + src(i, j + 1)) / 5;
+            });
+        });
+
+        utest::bench("column sums", [&]() {
+            int sum = 0;
+
+            for (size_t j = 0; j < side; ++j) {
+                for (size_t i = 0; i < side; ++i) {
+                    sum += src(i, j);
+                }
+            }
+
+            dst(0, 0) = sum;
+        });
+
+        utest::log("\n");
+    }
+};
+#pragma endregion MdArrayBench
+
+
+#pragma region PriorityQueueBench
+class PriorityQueueBench {
+public:
+    static constexpr size_t count = 1'000'000;
+
+
+    void run() {
+        utest::log("PriorityQueue benchmarks (%zu elements):\n", count);
+        utest::LogBlock block{};
+
+        std::vector<unsigned> values(count);
+        for (auto &val : values) {
+            val = (unsigned)abel::randLL();
+        }
+
+        run_one<std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>>>(
+            "std::priority_queue", values);
+        run_one<mylib::PriorityQueue<unsigned, std::greater<unsigned>, 2>>("PriorityQueue<2>", values);
+        run_one<mylib::PriorityQueue<unsigned, std::greater<unsigned>, 4>>("PriorityQueue<4>", values);
+        run_one<mylib::PriorityQueue<unsigned, std::greater<unsigned>, 8>>("PriorityQueue<8>", values);
+
+        utest::log("\n");
+    }
+
+protected:
+    template <typename Queue>
+    void run_one(const char *name, const std::vector<unsigned> &values) {
+        utest::bench(abel::sprintfxx("%s: push all, pop all", name), [&]() {
+            Queue queue{};
+
+            for (unsigned val : values) {
+                queue.push(val);
+            }
+
+            while (!queue.empty()) {
+                queue.pop();
+            }
+        });
+
+        // Emulates a timer wheel: a steady-state queue with one insertion per expiry
+        utest::bench(abel::sprintfxx("%s: steady state pop + push", name), [&]() {
+            Queue queue{};
+
+            for (size_t i = 0; i < values.size() / 4; ++i) {
+                queue.push(values[i]);
+            }
+
+            for (size_t i = values.size() / 4; i < values.size(); ++i) {
+                if constexpr (requires { queue.replace_top(values[i]); }) {
+                    queue.replace_top(queue.top() + values[i] % 1024);
+                } else {
+                    unsigned next = queue.top() + values[i] % 1024;
+                    queue.pop();
+                    queue.push(next);
+                }
+            }
+        });
+    }
+};
+#pragma endregion PriorityQueueBench
+
+
+#pragma region StringShareBench
+class StringShareBench {
+public:
+    static constexpr unsigned copies = 1'000'000;
+
+
+    void run() {
+        utest::log("Shared String copy + destroy benchmarks (%u copies per thread):\n", copies);
+        utest::LogBlock block{};
+
+        run_one<mylib::String<std::allocator<char>, mylib::PlainRefCount >>("PlainRefCount",  1);
+        run_one<mylib::String<std::allocator<char>, mylib::AtomicRefCount>>("AtomicRefCount", 1);
+        run_one<mylib::String<std::allocator<char>, mylib::AtomicRefCount>>("AtomicRefCount", 2);
+        run_one<mylib::String<std::allocator<char>, mylib::AtomicRefCount>>("AtomicRefCount", 4);
+        run_one<mylib::String<std::allocator<char>, mylib::AtomicRefCount>>("AtomicRefCount", 8);
+
+        utest::log("\n");
+    }
+
+protected:
+    template <typename Str>
+    void run_one(const char *name, unsigned threads) {
+        Str source{"Long enough not to fit into the small buffer"};
+
+        // All threads hammer the same counter, which is the worst case
+        utest::bench(abel::sprintfxx("%s, %u thread(s)", name, threads), [&]() {
+            std::vector<std::thread> workers{};
+
+            for (unsigned i = 0; i < threads; ++i) {
+                workers.emplace_back([local = Str(source)]() mutable {
+                    for (unsigned j = 0; j < copies; ++j) {
+                        Str copy = local;
+                        (void)copy;
+                    }
+                });
+            }
+
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        });
+    }
+};
+#pragma endregion StringShareBench
+
+
+#pragma region StringSearchBench
+class StringSearchBench {
+public:
+    static constexpr size_t size = 1 << 22;
+
+
+    void run() {
+        utest::log("String search benchmarks (%zu byte haystack):\n", size);
+        utest::LogBlock block{};
+
+        // Lowercase text with the needles only at the very end
+        std::string data(size, ' ');
+        for (auto &chr : data) {
+            chr = (char)('a' + abel::randLL() % 26);
+        }
+
+        std::string long_needle(200, 'x');
+        long_needle.back() = 'y';
+        data.replace(data.size() - 512, long_needle.size(), long_needle);
+        data.replace(data.size() - 16, 7, "needle!");
+
+        mylib::String<> str{std::string_view(data)};
+        std::string_view view = data;
+
+        run_one("find(char)",          str, view, [](const auto &hay) { return hay.find('!'); });
+        run_one("find(short)",         str, view, [](const auto &hay) { return hay.find("needle"); });
+        run_one("find(long)",          str, view, [&](const auto &hay) { return hay.find(long_needle); });
+        run_one("rfind(short)",        str, view, [](const auto &hay) { return hay.rfind("abcd"); });
+        run_one("find_first_of(3)",    str, view, [](const auto &hay) { return hay.find_first_of("!?."); });
+        run_one("find_last_not_of(26)", str, view, [](const auto &hay) {
+            return hay.find_last_not_of("abcdefghijklmnopqrstuvwxyz", hay.size() - 32);
+        });
+
+        utest::log("\n");
+    }
+
+protected:
+    template <typename F>
+    void run_one(const char *name, const mylib::String<> &str, std::string_view view, F &&func) {
+        size_t result = 0;
+
+        utest::bench(abel::sprintfxx("%s: String", name), [&]() {
+            result += func(str);
+        });
+
+        utest::bench(abel::sprintfxx("%s: std::string_view", name), [&]() {
+            result += func(view);
+        });
+
+        // Keeps the searches from being optimized out
+        utest::log("%-48s %zu\n", "(checksum)", result);
+    }
+};
+#pragma endregion StringSearchBench
+
+
+#pragma region StringSliceBench
+class StringSliceBench {
+public:
+    static constexpr size_t words = 1 << 20;
+
+
+    void run() {
+        utest::log("String tokenizing benchmarks (%zu words):\n", words);
+        utest::LogBlock block{};
+
+        std::string data{};
+        for (size_t i = 0; i < words; ++i) {
+            // Long enough for std::string to allocate, too
+            data.append(16 + abel::randLL() % 16, (char)('a' + i % 26));
+            data.push_back(' ');
+        }
+
+        mylib::String<> owned{std::string_view(data)};
+        mylib::String<> viewing = mylib::String<>::view(std::string_view(data));
+        size_t total = 0;
+
+        utest::bench("std::string::substr", [&]() {
+            total += tokenize(data);
+        });
+
+        // Owned strings are copied, unless they are explicitly shared first
+        utest::bench("String::substr (copies)", [&]() {
+            total += tokenize(owned);
+        });
+
+        mylib::String<> shared = owned.share();
+
+        utest::bench("String::substr (windows)", [&]() {
+            total += tokenize(shared);
+        });
+
+        utest::bench("String::substr (views)", [&]() {
+            total += tokenize(viewing);
+        });
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+        utest::log("\n");
+    }
+
+protected:
+    template <typename Str>
+    static size_t tokenize(Str &text) {
+        size_t total = 0;
+
+        for (size_t pos = 0; pos < text.size();) {
+            size_t end = text.find(' ', pos);
+            if (end == text.npos) {
+                end = text.size();
+            }
+
+            auto token = text.substr(pos, end - pos);
+            total += token.size();
+
+            pos = end + 1;
+        }
+
+        return total;
+    }
+};
+#pragma endregion StringSliceBench
+
+
+/// Mostly identifiers and map keys of 10-22 chars, with some shorter and longer ones
+std::vector<std::string> make_keys(unsigned count) {
+    std::vector<std::string> result{};
+    result.reserve(count);
+
+    for (unsigned i = 0; i < count; ++i) {
+        unsigned bucket = abel::randLL() % 10;
+        size_t length = bucket < 2 ? 4 + abel::randLL() % 6 :
+                        bucket < 9 ? 10 + abel::randLL() % 13 :
+                                     23 + abel::randLL() % 40;
+
+        std::string key(length, ' ');
+        for (auto &chr : key) {
+            chr = "abcdefghijklmnopqrstuvwxyz_._"[abel::randLL() % 29];
+        }
+
+        result.push_back(std::move(key));
+    }
+
+    return result;
+}
+
+
+#pragma region StringSsoBench
+class StringSsoBench {
+public:
+    static constexpr unsigned key_count = 1 << 20;
+
+
+    void run() {
+        utest::log("Key-like strings (%u keys, %zu chars inline):\n",
+                   key_count, mylib::String<>::small_string_size - 1);
+        utest::LogBlock block{};
+
+        std::vector<std::string> keys = make_keys(key_count);
+
+        size_t total_length = 0;
+        for (const auto &key : keys) {
+            total_length += key.size();
+        }
+        utest::log("%-48s %10.3f\n", "(mean length)", (double)total_length / key_count);
+
+        run_one<std::string>("std::string", keys);
+        run_one<mylib::String<>>("String", keys);
+
+        utest::log("\n");
+    }
+
+protected:
+    template <typename Str>
+    static std::vector<Str> construct(const std::vector<std::string> &keys) {
+        std::vector<Str> result{};
+        result.reserve(keys.size());
+
+        for (const auto &key : keys) {
+            result.emplace_back(key.data(), key.size());
+        }
+
+        return result;
+    }
+
+    template <typename Str>
+    void run_one(const char *name, const std::vector<std::string> &keys) {
+        size_t total = 0;
+
+        // Per key rather than per call, so counted outside of utest::bench()
+        size_t construct_allocs = 0;
+        size_t copy_allocs = 0;
+
+        std::vector<Str> strings{};
+        {
+            utest::AllocCounter allocs{};
+            strings = construct<Str>(keys);
+            construct_allocs = allocs.allocations();
+        }
+        {
+            utest::AllocCounter allocs{};
+            std::vector<Str> copies = strings;
+            copy_allocs = allocs.allocations();
+        }
+
+        if constexpr (utest::counts_allocations) {
+            utest::log("%-48s %10.3f\n", abel::sprintfxx("%s: allocations per key", name).c_str(),
+                       (double)construct_allocs / key_count);
+            utest::log("%-48s %10.3f\n", abel::sprintfxx("%s: allocations per copy", name).c_str(),
+                       (double)copy_allocs / key_count);
+        }
+
+        utest::bench(abel::sprintfxx("%s: construct + destroy", name), [&]() {
+            total += construct<Str>(keys).back().size();
+        });
+
+        utest::bench(abel::sprintfxx("%s: copy + destroy", name), [&]() {
+            std::vector<Str> copies = strings;
+
+            total += copies.back().size();
+        });
+
+        utest::bench(abel::sprintfxx("%s: copy + sort", name), [&]() {
+            std::vector<Str> copies = strings;
+            std::sort(copies.begin(), copies.end());
+
+            total += copies.front().size();
+        });
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+    }
+};
+#pragma endregion StringSsoBench
+
+
+#pragma region StringHashBench
+class StringHashBench {
+public:
+    static constexpr unsigned key_count = 1 << 20;
+
+
+    void run() {
+        utest::log("Hashing benchmarks:\n");
+        utest::LogBlock block{};
+
+        run_keys();
+        run_long(4 * 1024, 1024);
+        run_long(1024 * 1024, 8);
+        run_cached();
+
+        utest::log("\n");
+    }
+
+protected:
+    void run_keys() {
+        std::vector<std::string> keys = make_keys(key_count);
+        size_t total = 0;
+
+        utest::bench("keys: std::hash<std::string_view>", [&]() {
+            for (const auto &key : keys) {
+                total += std::hash<std::string_view>{}(key);
+            }
+        });
+
+        utest::bench("keys: mylib::hash_bytes", [&]() {
+            for (const auto &key : keys) {
+                total += mylib::hash_bytes(key);
+            }
+        });
+
+        std::vector<mylib::String<>> strings{};
+        std::unordered_set<std::string> std_set{};
+        std::unordered_set<mylib::String<>, mylib::Hash, std::equal_to<>> my_set{};
+
+        for (unsigned i = 0; i < key_count; i += 2) {
+            std_set.insert(keys[i]);
+            my_set.emplace(std::string_view(keys[i]));
+        }
+
+        utest::bench("keys: unordered_set<std::string>::find", [&]() {
+            for (const auto &key : keys) {
+                total += std_set.find(key) != std_set.end();
+            }
+        });
+
+        utest::bench("keys: unordered_set<String, Hash>::find", [&]() {
+            for (const auto &key : keys) {
+                total += my_set.find(std::string_view(key)) != my_set.end();
+            }
+        });
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+    }
+
+    void run_long(size_t size, unsigned reps) {
+        namespace impl = mylib::_impl::hash;
+
+        std::string data(size, ' ');
+        for (auto &chr : data) {
+            chr = (char)abel::randLL();
+        }
+
+        const unsigned char *ptr = (const unsigned char *)data.data();
+        size_t total = 0;
+
+        utest::bench(abel::sprintfxx("%zu bytes x%u: std::hash<std::string_view>", size, reps), [&]() {
+            for (unsigned i = 0; i < reps; ++i) {
+                total += std::hash<std::string_view>{}(data);
+            }
+        });
+
+        utest::bench(abel::sprintfxx("%zu bytes x%u: hash_bytes, scalar", size, reps), [&]() {
+            for (unsigned i = 0; i < reps; ++i) {
+                total += impl::hash_long<impl::Scalar>(ptr, size, 0);
+            }
+        });
+
+        utest::bench(abel::sprintfxx("%zu bytes x%u: hash_bytes", size, reps), [&]() {
+            for (unsigned i = 0; i < reps; ++i) {
+                total += mylib::hash_bytes(data);
+            }
+        });
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+    }
+
+    /// Many copies of a few long strings, as in a map keyed by file contents or URLs
+    void run_cached() {
+        constexpr unsigned source_count = 64;
+        constexpr unsigned copy_count = 1 << 14;
+
+        std::vector<mylib::String<>> sources{};
+        for (unsigned i = 0; i < source_count; ++i) {
+            std::string data(1024, ' ');
+            for (auto &chr : data) {
+                chr = (char)('a' + abel::randLL() % 26);
+            }
+
+            sources.emplace_back(std::string_view(data));
+        }
+
+        std::vector<mylib::String<>> copies{};
+        copies.reserve(copy_count);
+        for (unsigned i = 0; i < copy_count; ++i) {
+            // Non-const copies share the source
+            copies.emplace_back(sources[i % source_count]);
+        }
+
+        size_t total = 0;
+
+        utest::bench("1 KiB shared copies: std::hash<std::string_view>", [&]() {
+            for (const auto &copy : copies) {
+                total += std::hash<std::string_view>{}((std::string_view)copy);
+            }
+        });
+
+        utest::bench("1 KiB shared copies: String::hash (cached)", [&]() {
+            for (const auto &copy : copies) {
+                total += copy.hash();
+            }
+        });
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+    }
+};
+#pragma endregion StringHashBench
+
+
+#pragma region StringSplitBench
+class StringSplitBench {
+public:
+    static constexpr size_t total_size = 1 << 26;
+
+
+    void run() {
+        std::string doc = make_document();
+        size_t total = 0;
+
+        utest::log("Splitting a %zu byte CSV-like document:\n", doc.size());
+        utest::LogBlock block{};
+
+        auto per_field = utest::bench("std::string per field", [&]() {
+            size_t line_start = 0;
+
+            while (line_start < doc.size()) {
+                size_t line_end = doc.find('\n', line_start);
+                std::string line(doc.data() + line_start, doc.data() + line_end);
+
+                size_t start = 0;
+                for (size_t end = line.find(','); ; end = line.find(',', start)) {
+                    std::string field = line.substr(start, end == std::string::npos ? end : end - start);
+                    total += field.size();
+
+                    if (end == std::string::npos) {
+                        break;
+                    }
+
+                    start = end + 1;
+                }
+
+                line_start = line_end + 1;
+            }
+        });
+        if constexpr (utest::counts_allocations) {
+            utest::log("%-48s %10.3f\n", "std::string per field: allocations per pass", per_field.allocations);
+        }
+
+        utest::bench("std::string_view, find", [&]() {
+            std::string_view rest = doc;
+
+            while (!rest.empty()) {
+                size_t line_end = rest.find('\n');
+                std::string_view line = rest.substr(0, line_end);
+                rest.remove_prefix(line_end + 1);
+
+                for (size_t start = 0; ; ) {
+                    size_t end = line.find(',', start);
+                    total += line.substr(start, end - start).size();
+
+                    if (end == std::string_view::npos) {
+                        break;
+                    }
+
+                    start = end + 1;
+                }
+            }
+        });
+
+        mylib::String<> str{std::string_view(doc)};
+
+        auto lazy_split = utest::bench("String::lines + String::split", [&]() {
+            for (const auto &line : str.lines()) {
+                for (const auto &field : line.split(',')) {
+                    total += field.size();
+                }
+            }
+        });
+        if constexpr (utest::counts_allocations) {
+            utest::log("%-48s %10.3f\n", "String::lines + split: allocations per pass", lazy_split.allocations);
+        }
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+        utest::log("\n");
+    }
+
+protected:
+    /// Log-like records: a timestamp, a level, some ids and short words
+    static std::string make_document() {
+        static constexpr const char *levels[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+        std::string result{};
+        result.reserve(total_size + 256);
+
+        while (result.size() < total_size) {
+            result += abel::sprintfxx("2024-01-%02u %02u:%02u:%02u,%s,%llu,%llu",
+                                      1 + (unsigned)(abel::randLL() % 28), (unsigned)(abel::randLL() % 24),
+                                      (unsigned)(abel::randLL() % 60), (unsigned)(abel::randLL() % 60),
+                                      levels[abel::randLL() % 4],
+                                      abel::randLL() % 100000, abel::randLL() % 1000000000);
+
+            for (unsigned i = abel::randLL() % 8; i > 0; --i) {
+                result += ',';
+
+                for (unsigned j = abel::randLL() % 12; j > 0; --j) {
+                    result += (char)('a' + abel::randLL() % 26);
+                }
+            }
+
+            result += '\n';
+        }
+
+        return result;
+    }
+};
+#pragma endregion StringSplitBench
+
+
+#pragma region StringFileBench
+class StringFileBench {
+public:
+    static constexpr size_t file_size = 1 << 25;
+
+
+    void run() {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "templatonks_file_bench.txt";
+        write_file(path);
+
+        size_t total = 0;
+
+        utest::log("Loading a %zu byte file:\n", file_size);
+        utest::LogBlock block{};
+
+        utest::bench("std::ifstream into std::string", [&]() {
+            total += read_file(path).size();
+        });
+
+        utest::bench("string_from_file", [&]() {
+            total += mylib::string_from_file(path).size();
+        });
+
+        // Actually touching the contents, which is where the mapping pays its page faults
+        utest::bench("std::ifstream into std::string, then hash", [&]() {
+            total += mylib::hash_bytes(read_file(path));
+        });
+
+        utest::bench("string_from_file, then hash", [&]() {
+            total += mylib::string_from_file(path).hash();
+        });
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+        utest::log("\n");
+
+        std::filesystem::remove(path);
+    }
+
+protected:
+    static void write_file(const std::filesystem::path &path) {
+        static constexpr std::string_view words[] = {
+            "{{ name }}", "lorem", "ipsum", "dolor", "sit", "amet", "{% if enabled %}", "{% endif %}", "\n"
+        };
+
+        std::string contents{};
+        contents.reserve(file_size + 32);
+
+        while (contents.size() < file_size) {
+            contents += words[abel::randLL() % std::size(words)];
+            contents += ' ';
+        }
+        contents.resize(file_size);
+
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    static std::string read_file(const std::filesystem::path &path) {
+        std::ifstream file(path, std::ios::binary);
+        std::string result(std::filesystem::file_size(path), '\0');
+        file.read(result.data(), (std::streamsize)result.size());
+
+        return result;
+    }
+};
+#pragma endregion StringFileBench
+
+
+#pragma region StringFormatBench
+class StringFormatBench {
+public:
+    static constexpr unsigned record_count = 1000000;
+
+
+    void run() {
+        std::vector<Record> records = make_records();
+        size_t total = 0;
+
+        utest::log("Serializing %u records:\n", record_count);
+        utest::LogBlock block{};
+
+        utest::bench("std::string, std::to_string + append", [&]() {
+            std::string out{};
+
+            for (const Record &record : records) {
+                out += "id=";
+                out += std::to_string(record.id);
+                out += " ts=";
+                out += std::to_string(record.timestamp);
+                out += " value=";
+                out += std::to_string(record.value);
+                out += '\n';
+            }
+
+            total += out.size();
+        });
+
+        utest::bench("std::string, std::format_to", [&]() {
+            std::string out{};
+
+            for (const Record &record : records) {
+                std::format_to(std::back_inserter(out), "id={} ts={} value={}\n",
+                               record.id, record.timestamp, record.value);
+            }
+
+            total += out.size();
+        });
+
+        using string_type = mylib::String<>;
+
+        auto appends = utest::bench("String::append_int/append_float", [&]() {
+            string_type out{};
+
+            for (const Record &record : records) {
+                out.append("id=").append_int(record.id)
+                   .append(" ts=").append_int(record.timestamp)
+                   .append(" value=").append_float(record.value).append(1, '\n');
+            }
+
+            total += out.size();
+        });
+
+        auto formats = utest::bench("mylib::format_to(String &)", [&]() {
+            string_type out{};
+
+            for (const Record &record : records) {
+                mylib::format_to(out, "id={} ts={} value={}\n", record.id, record.timestamp, record.value);
+            }
+
+            total += out.size();
+        });
+
+        if constexpr (utest::counts_allocations) {
+            utest::log("%-48s %10.3f\n", "String::append_int/append_float: allocations", appends.allocations);
+            utest::log("%-48s %10.3f\n", "mylib::format_to(String &): allocations", formats.allocations);
+        }
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+        utest::log("\n");
+    }
+
+protected:
+    struct Record {
+        unsigned id;
+        int64_t timestamp;
+        double value;
+    };
+
+
+    static std::vector<Record> make_records() {
+        std::vector<Record> result{};
+        result.reserve(record_count);
+
+        for (unsigned i = 0; i < record_count; ++i) {
+            result.push_back(Record{(unsigned)(abel::randLL() % 1000000),
+                                    1700000000000LL + (int64_t)(abel::randLL() % 100000000),
+                                    (double)(abel::randLL() % 1000000) / 1000});
+        }
+
+        return result;
+    }
+};
+#pragma endregion StringFormatBench
+
+
+#pragma region RopeBench
+class RopeBench {
+public:
+    static constexpr size_t total_size = 1 << 25;
+
+
+    void run() {
+        utest::log("Building a %zu byte document:\n", total_size);
+        utest::LogBlock block{};
+
+        for (size_t piece_size : {16, 256, 64 * 1024}) {
+            run_one(piece_size);
+        }
+
+        utest::log("\n");
+    }
+
+protected:
+    void run_one(size_t piece_size) {
+        std::string piece(piece_size, 'x');
+        std::string_view piece_view = piece;
+        const size_t count = total_size / piece_size;
+
+        size_t total = 0;
+
+        utest::bench(abel::sprintfxx("String::append, %zu byte pieces", piece_size), [&]() {
+            mylib::String<> doc{};
+
+            for (size_t i = 0; i < count; ++i) {
+                doc.append(piece_view);
+            }
+
+            total += doc.size();
+        });
+
+        utest::bench(abel::sprintfxx("Rope::append, %zu byte pieces", piece_size), [&]() {
+            mylib::Rope<> doc{};
+
+            for (size_t i = 0; i < count; ++i) {
+                doc.append(piece_view);
+            }
+
+            total += doc.size();
+        });
+
+        utest::bench(abel::sprintfxx("Rope::append + flatten, %zu byte pieces", piece_size), [&]() {
+            mylib::Rope<> doc{};
+
+            for (size_t i = 0; i < count; ++i) {
+                doc.append(piece_view);
+            }
+
+            total += doc.flatten().size();
+        });
+
+        utest::log("%-48s %zu\n", "(checksum)", total);
+    }
+};
+#pragma endregion RopeBench
+
+
+#pragma region InternBench
+class InternBench {
+public:
+    static constexpr unsigned name_count = 4096;
+    static constexpr unsigned lookup_count = 1 << 22;
+
+
+    void run() {
+        utest::log("Comparing %u identifiers %u times:\n", name_count, lookup_count);
+        utest::LogBlock block{};
+
+        std::vector<std::string> names{};
+        for (unsigned i = 0; i < name_count; ++i) {
+            // Long shared prefixes are what make real identifiers slow to compare
+            names.push_back(abel::sprintfxx("some_module::some_namespace::identifier_%u", i));
+        }
+
+        std::vector<unsigned> order(lookup_count);
+        for (auto &idx : order) {
+            idx = abel::randLL() % name_count;
+        }
+
+        mylib::InternPool<> pool{};
+        std::vector<mylib::Atom> atoms{};
+        std::vector<mylib::String<>> strings{};
+        for (const auto &name : names) {
+            atoms.push_back(pool.intern(name));
+            strings.emplace_back(std::string_view(name));
+        }
+
+        size_t total = 0;
 
-            compare(items, arr);
-        };
+        utest::bench("std::string ==", [&]() {
+            for (unsigned i = 1; i < lookup_count; ++i) {
+                total += names[order[i]] == names[order[i - 1]];
+            }
+        });
 
-        "copy"_test << [=]() {
-            const size_t test_size = 17;
-            std::vector<value_type> items;
-            array_type arr;
-            populate(test_size, items, arr);
+        utest::bench("String ==", [&]() {
+            for (unsigned i = 1; i < lookup_count; ++i) {
+                total += strings[order[i]] == strings[order[i - 1]];
+            }
+        });
 
-            items.clear();
+        utest::bench("Atom ==", [&]() {
+            for (unsigned i = 1; i < lookup_count; ++i) {
+                total += atoms[order[i]] == atoms[order[i - 1]];
+            }
+        });
 
-            std::copy(arr.begin(), arr.end(), std::back_inserter(items));
+        utest::bench("InternPool::intern, existing", [&]() {
+            for (unsigned i = 0; i < lookup_count; ++i) {
+                total += pool.intern(names[order[i]]).size();
+            }
+        });
 
-            compare(items, arr);
-        };
+        utest::bench("InternPool::intern, existing, 4 threads", [&]() {
+            std::atomic<size_t> shared_total = 0;
+            std::vector<std::thread> threads{};
 
-        "find"_test << [=]() {
-            const size_t test_size = 17;
-            std::vector<value_type> items;
-            array_type arr;
-            populate(test_size, items, arr);
+            for (unsigned t = 0; t < 4; ++t) {
+                threads.emplace_back([&, t]() {
+                    size_t local = 0;
 
-            for (unsigned i = 0; i < 500; ++i) {
-                value_type item = random_val();
-                TEST_REQUIRE(std::find(arr.begin(), arr.end(), item) - arr.begin() ==
-                             std::find(items.begin(), items.end(), item) - items.begin());
+                    for (unsigned i = t; i < lookup_count; i += 4) {
+                        local += pool.intern(names[order[i]]).size();
+                    }
+
+                    shared_total += local;
+                });
             }
-        };
 
-        // TODO: Also perhaps std::transform?
-    }
+            for (auto &thread : threads) {
+                thread.join();
+            }
 
-    void test_static() {
-        using namespace utest::literals;
+            total += shared_total;
+        });
 
-        constexpr size_t static_size = Storage<T>::size();
+        utest::bench("InternPool::intern, fresh pool", [&]() {
+            mylib::InternPool<> fresh{};
 
-        //
-    }
+            for (const auto &name : names) {
+                total += fresh.intern(name).size();
+            }
+        });
 
+        utest::log("%-48s %zu\n", "(checksum)", total);
+        utest::log("\n");
+    }
 };
-#pragma endregion ArrayTester
+#pragma endregion InternBench
 
 
-#pragma region StringTester
-class StringTester {
+#pragma region FunctionBench
+class FunctionBench {
 public:
-    using string_type = mylib::String<>;
-    using char_type = string_type::value_type;
-    static_assert(std::is_same_v<char_type, char>, "Tester not suitable for non-char strings");
-
+    static constexpr unsigned func_count = 1 << 16;
+    static constexpr unsigned call_rounds = 64;
+    static constexpr unsigned hot_count = 1 << 10;
+
+
+    void run() {
+        utest::log("Function benchmarks (%u targets):\n", func_count);
+        utest::LogBlock block{};
+
+        run_one<std::function<int (int)>>("std::function");
+        run_one<mylib::Function<int (int)>>("Function");
+
+        run_callbacks<std::function<int (int)>>("std::function");
+        run_callbacks<mylib::Function<int (int)>>("Function");
+        run_callbacks<mylib::FunctionRef<int (int)>>("FunctionRef");
+
+        run_subscribers("std::function", [](auto functor) { return std::function<int (int)>(functor); });
+        run_subscribers("Function", [](auto functor) { return mylib::Function<int (int)>(functor); });
+        run_subscribers("Function::shared", [](auto functor) {
+            return mylib::Function<int (int)>::shared(functor);
+        });
+        run_subscribers("Function::shared<Atomic>", [](auto functor) {
+            return mylib::Function<int (int)>::shared<mylib::AtomicRefCount>(functor);
+        });
+
+        // A copyable function needs the move-only payload shared, which means another allocation
+        run_queue<std::function<int ()>>("std::function + shared_ptr", [](unsigned i) {
+            return [payload = std::make_shared<Payload>(Payload{i})]() { return payload->value; };
+        });
+        run_queue<mylib::Function<int ()>>("Function + shared_ptr", [](unsigned i) {
+            return [payload = std::make_shared<Payload>(Payload{i})]() { return payload->value; };
+        });
+        run_queue<mylib::MoveFunction<int ()>>("MoveFunction + unique_ptr", [](unsigned i) {
+            return [payload = std::make_unique<Payload>(Payload{i})]() { return payload->value; };
+        });
+
+        run_capture_sweep<8, 16, 32, 48, 64, 96, 128>();
+
+        utest::log("%-48s %zu\n", "(checksum)", total_);
+        utest::log("\n");
+    }
 
-    void test() {
-        utest::Test::reset();
+protected:
+    size_t total_ = 0;
 
-        utest::log("Testing %s\n", typeid(string_type).name());
 
-        test_all();
+    template <typename Func>
+    void run_one(const char *name) {
+        std::vector<Func> small{};
+        std::vector<Func> large{};
 
-        utest::Test::sum_up();
-    }
+        for (unsigned i = 0; i < func_count; ++i) {
+            int offset = (int)(abel::randLL() % 100);
+            small.emplace_back([offset](int x) { return x + offset; });
 
-    void test_all() {
-        using namespace utest::literals;
+            std::array<int, 32> table{};
+            table[i % 32] = offset;
+            large.emplace_back([table](int x) { return x + table[x % 32]; });
+        }
 
-        "basic"_test << [=]() {
-            mylib::String str{"abc"};
-            TEST_REQUIRE(str.size() == 3);
-            TEST_REQUIRE(str.size_with_null() == 4);
-            TEST_REQUIRE(str.is_owning());
-            TEST_REQUIRE(str[0] == 'a');
-            TEST_REQUIRE(str[1] == 'b');
-            TEST_REQUIRE(str[2] == 'c');
-            TEST_REQUIRE(str[3] == 0);
-        };
+        utest::bench(abel::sprintfxx("%s: call, small target", name), [&]() {
+            for (unsigned round = 0; round < call_rounds; ++round) {
+                for (const Func &func : small) {
+                    total_ += func((int)round);
+                }
+            }
+        });
 
-        "access"_test << [=]() {
-            constexpr std::string_view data = "Hello, dear world!";
+        // Few enough to stay in cache, so that only the call itself is measured
+        utest::bench(abel::sprintfxx("%s: call, small target, %u hot ones", name, hot_count), [&]() {
+            for (unsigned round = 0; round < call_rounds * func_count / hot_count; ++round) {
+                for (unsigned i = 0; i < hot_count; ++i) {
+                    total_ += small[i]((int)round);
+                }
+            }
+        });
 
-            string_type mystr = data.data();
-            TEST_REQUIRE(mystr.is_owning());
+        utest::bench(abel::sprintfxx("%s: call, large target", name), [&]() {
+            for (unsigned round = 0; round < call_rounds; ++round) {
+                for (const Func &func : large) {
+                    total_ += func((int)round);
+                }
+            }
+        });
 
-            TEST_REQUIRE(data.size() == mystr.size());
+        // There and back again, so that every pass starts from the same state
+        std::vector<Func> moved{};
+        moved.reserve(func_count);
 
-            for (size_t i = 0; i < data.size(); ++i) {
-                TEST_REQUIRE(mystr[i] == data[i]);
+        utest::bench(abel::sprintfxx("%s: move, small target", name), [&]() {
+            for (Func &func : small) {
+                moved.push_back(std::move(func));
             }
 
-            for (int i = 1; i <= (int)data.size(); ++i) {
-                TEST_REQUIRE(mystr[-i] == data[data.size() - i]);
+            for (unsigned i = 0; i < func_count; ++i) {
+                small[i] = std::move(moved[i]);
             }
 
-            TEST_REQUIRE(mystr[data.size()] == '\0');
-        };
+            moved.clear();
+        });
 
-        constexpr auto compare = [](const std::string_view &data,
-                                    const string_type &mystr, bool dump = false) {
-            TEST_REQUIRE(data.size() == mystr.size());
+        utest::bench(abel::sprintfxx("%s: move, small target, %u hot ones", name, hot_count), [&]() {
+            for (unsigned round = 0; round < func_count / hot_count; ++round) {
+                for (unsigned i = 0; i < hot_count; ++i) {
+                    moved.push_back(std::move(small[i]));
+                }
 
-            for (size_t i = 0; i < data.size(); ++i) {
-                if (dump && data[i] != mystr[i]) {
-                    utest::log("[%zu/%zu]: %c != %c\n",
-                               i, data.size(),
-                               data[i], mystr[i]);
+                for (unsigned i = 0; i < hot_count; ++i) {
+                    small[i] = std::move(moved[i]);
                 }
-                TEST_REQUIRE(data[i] == mystr[i]);
+
+                moved.clear();
             }
-        };
+        });
 
-        "iteration"_test << [=]() {
-            constexpr std::string_view data = "Hello, dear world!";
+        utest::bench(abel::sprintfxx("%s: move, large target", name), [&]() {
+            for (Func &func : large) {
+                moved.push_back(std::move(func));
+            }
 
-            string_type mystr = data.data();
-            TEST_REQUIRE(mystr.is_owning());
+            for (unsigned i = 0; i < func_count; ++i) {
+                large[i] = std::move(moved[i]);
+            }
 
-            TEST_REQUIRE(mystr.size() == (size_t)(mystr.cend() - mystr.cbegin()));
+            moved.clear();
+        });
 
-            size_t i = 0;
-            for (const auto &elem : mystr) {
-                TEST_REQUIRE(elem == data[i]);
-                ++i;
-            }
-        };
+        utest::bench(abel::sprintfxx("%s: copy, small target", name), [&]() {
+            std::vector<Func> copy = small;
 
-        "copy_on_write"_test << [=]() {
-            constexpr std::string_view data =
-                "I'm soooo long, I sure hope nobody copies me...";
-            string_type str1{data};
-            TEST_REQUIRE(str1.is_owning());
+            total_ += copy.size();
+        });
 
-            string_type str2 = str1;
-            TEST_REQUIRE(!str1.is_owning());
-            TEST_REQUIRE(!str2.is_owning());
+        utest::bench(abel::sprintfxx("%s: copy, large target", name), [&]() {
+            std::vector<Func> copy = large;
 
-            compare(data, str1);
-            compare(data, str2);
+            total_ += copy.size();
+        });
+    }
 
-            constexpr std::string_view extra =
-                ", but most of all, Samy is my hero.";
+    struct Payload {
+        unsigned value;
+        std::array<char, 60> data{};
+    };
 
-            str1.append(extra);
-            TEST_REQUIRE(str1.is_owning());
-            TEST_REQUIRE(!str2.is_owning());
-            compare(data, str2);
-        };
 
-        "no_copy_on_write"_test << [=]() {
-            string_type str1{"I'm soooo long, I sure hope nobody copies me..."};
-            TEST_REQUIRE(str1.is_owning());
+    /// The same big handler, copied into many subscriber lists
+    template <typename Wrap>
+    void run_subscribers(const char *name, Wrap wrap) {
+        std::array<int, 64> table{};
+        for (auto &item : table) {
+            item = (int)(abel::randLL() % 100);
+        }
 
-            string_type str2 = str1.as_const();
-            TEST_REQUIRE(str1.is_owning());
-            TEST_REQUIRE(str2.is_owning());
-        };
+        auto handler = wrap([table](int x) { return table[x % 64]; });
+        std::vector<decltype(handler)> subscribers{};
+        subscribers.reserve(func_count);
 
-        "small_cow"_test << [=]() {
-            constexpr std::string_view data =
-                "smolcow";
-            static_assert((data.size() + 1) * sizeof(char) <= sizeof(void *));
+        utest::bench(abel::sprintfxx("%s: copy 256B target", name), [&]() {
+            for (unsigned i = 0; i < func_count; ++i) {
+                subscribers.push_back(handler);
+            }
 
-            string_type str1{data};
-            TEST_REQUIRE(str1.is_owning());
+            total_ += subscribers.back()(1);
+            subscribers.clear();
+        });
+    }
 
-            string_type str2 = str1;
-            TEST_REQUIRE(!str1.is_owning());
-            TEST_REQUIRE(!str2.is_owning());
+    /// Jobs are queued up, and then all run in order
+    template <typename Func, typename MakeJob>
+    void run_queue(const char *name, MakeJob make_job) {
+        std::queue<Func> queue{};
 
-            compare(data, str1);
-            compare(data, str2);
+        utest::bench(abel::sprintfxx("%s: queue, run", name), [&]() {
+            for (unsigned i = 0; i < func_count; ++i) {
+                queue.push(make_job(i));
+            }
 
-            str1.erase(-3);
-            TEST_REQUIRE(str1.is_owning());
-            TEST_REQUIRE(!str2.is_owning());
-            compare(data.substr(0, data.size() - 3), str1);
-            compare(data, str2);
-        };
+            while (!queue.empty()) {
+                total_ += queue.front()();
+                queue.pop();
+            }
+        });
+    }
 
-        "push_pop"_test << [=]() {
-            constexpr std::string_view data = "Abacado or whatever, I'm not into algorithms";
+    /// Where the inline capacity starts to pay off, and where it stops to
+    template <size_t ... CaptureSizes>
+    void run_capture_sweep() {
+        (run_capture<std::function<int (int)>, CaptureSizes>("std::function"), ...);
+        (run_capture<mylib::Function<int (int), true, 16>, CaptureSizes>("Function<16>"), ...);
+        (run_capture<mylib::Function<int (int)>, CaptureSizes>("Function<48>"), ...);
+        (run_capture<mylib::Function<int (int), true, 112>, CaptureSizes>("Function<112>"), ...);
+    }
 
-            string_type str{};
-            for (size_t i = 0; i < data.size(); ++i) {
-                str.push_back(data[i]);
+    template <typename Func, size_t CaptureSize>
+    void run_capture(const char *name) {
+        static constexpr unsigned count = 1 << 14;
+
+        std::vector<Func> funcs{};
+        funcs.reserve(count);
+
+        utest::bench(abel::sprintfxx("%s: %zuB capture, create, call", name, CaptureSize), [&]() {
+            for (unsigned i = 0; i < count; ++i) {
+                std::array<uint64_t, CaptureSize / sizeof(uint64_t)> capture{};
+                capture[0] = i;
+
+                funcs.emplace_back([capture](int x) { return x + (int)capture[0]; });
             }
 
-            compare(data, str);
+            for (const Func &func : funcs) {
+                total_ += func(1);
+            }
 
+            funcs.clear();
+        });
+    }
 
-            for (size_t i = 0; i < data.size(); ++i) {
-                char_type chr = data[data.size() - 1 - i];
-                char_type my_chr = str.back();
+    /// A callback that only lives through the call that receives it
+    template <typename Func>
+    static size_t visit(const std::vector<int> &values, Func callback) {
+        size_t result = 0;
 
-                TEST_REQUIRE(chr == my_chr);
+        for (int value : values) {
+            result += callback(value);
+        }
 
-                str.pop_back();
+        return result;
+    }
+
+    template <typename Func>
+    void run_callbacks(const char *name) {
+        std::vector<int> values(16);
+        for (auto &value : values) {
+            value = (int)(abel::randLL() % 32);
+        }
+
+        utest::bench(abel::sprintfxx("%s: callback, small capture", name), [&]() {
+            for (unsigned i = 0; i < func_count * 4; ++i) {
+                total_ += visit<Func>(values, [i](int x) { return x + (int)i; });
             }
+        });
 
-            compare("", str);
-        };
+        std::array<int, 32> table{};
+        for (auto &item : table) {
+            item = (int)(abel::randLL() % 100);
+        }
 
-        test_compare_eq("Hello, dear world");
-        test_compare_eq("");
-        test_compare_eq(std::string_view("Hi there, pal!"));
+        utest::bench(abel::sprintfxx("%s: callback, large capture", name), [&]() {
+            for (unsigned i = 0; i < func_count * 4; ++i) {
+                total_ += visit<Func>(values, [table](int x) { return table[x]; });
+            }
+        });
+    }
+};
+#pragma endregion FunctionBench
 
-        "sort"_test << [=]() {
-            constexpr std::string_view data = "Hello, dear world!";
 
-            std::string str = data.data();
-            string_type mystr = data.data();
-            TEST_REQUIRE(mystr.is_owning());
+#pragma region GeometryBench
+class GeometryBench {
+public:
+    static constexpr size_t count = 1 << 12;
 
-            std::sort(str.begin(), str.end());
-            std::sort(mystr.begin(), mystr.end());
 
-            compare(str, mystr);
-        };
+    void run() {
+        utest::log("Vector benchmarks (%zu vectors):\n", count);
+        utest::LogBlock block{};
 
-        "copy"_test << [=]() {
-            constexpr std::string_view data = "Hello, dear world!";
+        run_size<float, 2>();
+        run_size<float, 3>();
+        run_size<float, 4>();
+        run_size<float, 8>();
+        run_size<float, 16>();
+        run_size<double, 3>();
+        run_size<double, 4>();
 
-            std::string str{};
-            string_type mystr = data.data();
-            TEST_REQUIRE(mystr.is_owning());
+        utest::log("%-48s %g\n", "(checksum)", total_);
+        utest::log("\n");
+    }
 
-            std::copy(mystr.begin(), mystr.end(), std::back_inserter(str));
+protected:
+    double total_ = 0;
 
-            compare(str, mystr);
-        };
 
-        "find"_test << [=]() {
-            constexpr std::string_view data = "Hello, dear world!";
+    template <typename T, size_t N>
+    void run_size() {
+        run_kernel<T, N, math_test::RecursiveKernel>("recursive");
+        run_kernel<T, N, math_test::FoldKernel>("fold");
+        run_kernel<T, N, math_test::SimdKernel>("simd");
+    }
 
-            string_type mystr = data.data();
-            TEST_REQUIRE(mystr.is_owning());
+    template <typename T, size_t N, typename Kernel>
+    void run_kernel(const char *kernel) {
+        using vector_type = math_test::Vector<T, N, Kernel>;
+        using matrix_type = math_test::Matrix<T, N, N, Kernel>;
 
-            using namespace std::string_view_literals;
+        const char *type_name = std::is_same_v<T, float> ? "float" : "double";
 
-            for (char_type chr : "ABCabcHh0\0!1,"sv) {
-                TEST_REQUIRE(std::find(mystr.begin(), mystr.end(), chr) - mystr.begin() ==
-                             std::find(data.begin(), data.end(), chr) - data.begin());
+        // The same data for every kernel, and never a zero vector
+        std::vector<vector_type> as(count);
+        std::vector<vector_type> bs(count);
+        std::vector<vector_type> out(count);
+        matrix_type transform{};
+
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t j = 0; j < N; ++j) {
+                as[i][j] = (T)((i * 31 + j * 7) % 17 + 1) / 8;
+                bs[i][j] = (T)((i * 13 + j * 5) % 19) / 8;
+            }
+        }
+
+        for (size_t i = 0; i < N; ++i) {
+            for (size_t j = 0; j < N; ++j) {
+                transform(i, j) = (T)((i + 1) * (j + 3) % 7) / 4;
             }
+        }
+
+        const auto label = [&](const char *workload) {
+            return abel::sprintfxx("Vector<%s, %zu> %s: %s", type_name, N, kernel, workload);
         };
 
-        "literals"_test << [=]() {
-            using namespace mylib::string_literals;
-            using namespace std::string_view_literals;
+        utest::bench(label("dot"), [&]() {
+            T sum = 0;
 
-            constexpr std::string_view data = "Hell\0o!"sv;
+            for (size_t i = 0; i < count; ++i) {
+                sum += as[i] * bs[i];
+            }
 
-            auto str = "Hell\0o!"_s;
-            static_assert(std::is_same_v<decltype(str), string_type>);
-            TEST_REQUIRE(str.is_owning());
+            return sum;
+        });
 
-            compare(data, str);
+        utest::bench(label("normalize"), [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = as[i].normalized();
+            }
 
-            auto str_view = "Hell\0o!"_sv;
-            static_assert(std::is_same_v<decltype(str_view), string_type>);
-            TEST_REQUIRE(!str_view.is_owning());
+            utest::clobber_memory();
+        });
 
-            compare(data, str_view);
-        };
+        utest::bench(label("lerp"), [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = as[i] + (bs[i] - as[i]) * (T)0.25;
+            }
 
-        // TODO: Tests for views, ordered-comparison
-    }
+            utest::clobber_memory();
+        });
 
-    void test_compare_eq(const auto &source) {
-        using namespace utest::literals;
+        utest::bench(label("transform"), [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = transform * as[i];
+            }
 
-        "compare_eq"_test << [=]() {
-            string_type str{source};
+            utest::clobber_memory();
+        });
 
-            TEST_REQUIRE(source == str);
-            TEST_REQUIRE(str == source);
-        };
+        for (const vector_type &item : out) {
+            total_ += (double)item[0];
+        }
     }
 };
-#pragma endregion StringTester
+#pragma endregion GeometryBench
+#pragma endregion Benchmarks
 
 
 int main() {
@@ -510,7 +3969,43 @@ int main() {
     assert(func2);
     assert(func3);
     #elif 0
+    FunctionTester().test();
+
+    FunctionBench().run();
+    #elif 0
+    VectorTester().test();
+
+    GeometryBench().run();
+    #elif 0
+    MdArrayTester<mylib::MdArray<int, 2>>().test();
+    MdArrayTester<mylib::MdArray<int, 2, mylib::DynamicLinearStorage, mylib::ColumnMajorLayout>>().test();
+    MdArrayTester<mylib::TiledArray<int, 2, 4>>().test();
+
+    MdArrayBench<mylib::RowMajorLayout>().run();
+    MdArrayBench<mylib::ColumnMajorLayout>().run();
+    MdArrayBench<mylib::BlockedLayout<16>>().run();
+    #elif 0
+    PriorityQueueTester().test();
+
+    PriorityQueueBench().run();
+    #elif 0
+    RangesTester().test();
+    #elif 0
     StringTester().test();
+    StringTester<mylib::String<std::allocator<char>, mylib::AtomicRefCount>>().test();
+    RopeTester().test();
+    InternTester().test();
+
+    StringShareBench().run();
+    StringSearchBench().run();
+    StringSliceBench().run();
+    StringSsoBench().run();
+    StringHashBench().run();
+    StringSplitBench().run();
+    StringFileBench().run();
+    StringFormatBench().run();
+    RopeBench().run();
+    InternBench().run();
     #elif 0
     mylib::String str{"abc"};
     assert(str[0] == 'a');
@@ -555,6 +4050,11 @@ int main() {
     ArrayTester<mylib::Vector<bool>>().test();
     ArrayTester<mylib::ChunkedArray<int, 32 / sizeof(int)>>().test();
 
+    PackedIntArrayTester<mylib::PackedVector<3>>().test();
+    PackedIntArrayTester<mylib::PackedVector<17>>().test();
+    PackedIntArrayTester<mylib::PackedVector<32>>().test();
+    PackedIntArrayTester<mylib::PackedChunkedArray<20, 7>>().test();
+
     {
         math_test::Vector<long, 7>
             a{1, 2, 3, 4, 5, 6, 7},
@@ -565,5 +4065,14 @@ int main() {
     }
     #endif
 
-    return 0;
+    bool regressed = false;
+
+    if (!utest::Bench::results().empty()) {
+        utest::Bench::save_json("bench_results.json");
+
+        // The first run becomes the baseline; delete it to take a new one
+        regressed = !utest::Bench::check_baseline("bench_baseline.json");
+    }
+
+    return regressed ? 1 : 0;
 }
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <ACL/defer.h>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include "string.h"
+
+#if defined(_WIN32)
+#define MAPPED_FILE_WIN32_ 1
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#define MAPPED_FILE_WIN32_ 0
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace mylib {
+
+
+#pragma region MappedFile
+/**
+ * A read-only mapping of a whole file, released on destruction.
+ * Empty files aren't mapped at all, since neither platform allows that,
+ * and simply have no data.
+ */
+class MappedFile {
+public:
+    MappedFile() noexcept = default;
+
+    explicit MappedFile(const std::filesystem::path &path) {
+        #if MAPPED_FILE_WIN32_
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            _throw_last_error("Failed to open the file");
+        }
+        abel::Defer close_file([file]() { CloseHandle(file); });
+
+        LARGE_INTEGER file_size{};
+        if (!GetFileSizeEx(file, &file_size)) {
+            _throw_last_error("Failed to get the file's size");
+        }
+
+        size_ = (size_t)file_size.QuadPart;
+        if (size_ == 0) {
+            return;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            _throw_last_error("Failed to map the file");
+        }
+        // The view keeps the mapping alive by itself
+        abel::Defer close_mapping([mapping]() { CloseHandle(mapping); });
+
+        data_ = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data_) {
+            _throw_last_error("Failed to map the file");
+        }
+        #else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            _throw_last_error("Failed to open the file");
+        }
+        // The mapping keeps the file alive by itself
+        abel::Defer close_file([fd]() { ::close(fd); });
+
+        struct stat info{};
+        if (::fstat(fd, &info) != 0) {
+            _throw_last_error("Failed to get the file's size");
+        }
+
+        size_ = (size_t)info.st_size;
+        if (size_ == 0) {
+            return;
+        }
+
+        void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            _throw_last_error("Failed to map the file");
+        }
+
+        data_ = (const char *)addr;
+        #endif
+    }
+
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    MappedFile(MappedFile &&other) noexcept :
+        data_{std::exchange(other.data_, nullptr)},
+        size_{std::exchange(other.size_, 0)} {}
+
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+
+        return *this;
+    }
+
+    ~MappedFile() {
+        if (!data_) {
+            return;
+        }
+
+        #if MAPPED_FILE_WIN32_
+        UnmapViewOfFile(data_);
+        #else
+        ::munmap((void *)data_, size_);
+        #endif
+
+        data_ = nullptr;
+    }
+
+    inline const char *data() const noexcept {
+        return data_;
+    }
+
+    inline size_t size() const noexcept {
+        return size_;
+    }
+
+    inline bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    /**
+     * Whether the byte right past the end is readable and zero. Both platforms
+     * zero-fill the rest of the last page, so this holds unless the size
+     * is a multiple of the page size.
+     */
+    inline bool is_null_padded() const noexcept {
+        return data_ && size_ % _page_size() != 0;
+    }
+
+protected:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+
+
+    [[noreturn]] static void _throw_last_error(const char *what) {
+        #if MAPPED_FILE_WIN32_
+        throw std::system_error((int)GetLastError(), std::system_category(), what);
+        #else
+        throw std::system_error(errno, std::generic_category(), what);
+        #endif
+    }
+
+    static size_t _page_size() noexcept {
+        static const size_t page_size = []() {
+            #if MAPPED_FILE_WIN32_
+            SYSTEM_INFO info{};
+            GetSystemInfo(&info);
+
+            return (size_t)info.dwPageSize;
+            #else
+            return (size_t)::sysconf(_SC_PAGESIZE);
+            #endif
+        }();
+
+        return page_size;
+    }
+
+};
+#pragma endregion MappedFile
+
+
+#pragma region MappedLazySource
+namespace _impl {
+
+/// Keeps the file mapped for as long as any string shares it
+template <typename Allocator, RefCountPolicy RefCount>
+class MappedLazySource : public ExternalLazySource<Allocator, RefCount> {
+public:
+    using string_type = String<Allocator, RefCount>;
+
+
+    /// A string sharing the mapping, which is unmapped once the last reference dies
+    static string_type share(MappedFile &&file, const typename string_type::allocator_type &alloc) {
+        assert(!file.empty());
+
+        return (new MappedLazySource(std::move(file)))->_share(alloc);
+    }
+
+protected:
+    // Unmapped before the base's view of it is destroyed, which doesn't touch the contents
+    MappedFile mapping_;
+
+
+    explicit MappedLazySource(MappedFile &&file) :
+        ExternalLazySource<Allocator, RefCount>(&_destroy), mapping_{std::move(file)} {
+
+        this->source = string_type::view(mapping_.data(), mapping_.size(), mapping_.is_null_padded());
+    }
+
+    static void _destroy(ExternalLazySource<Allocator, RefCount> *source) {
+        delete static_cast<MappedLazySource *>(source);
+    }
+
+};
+
+}
+#pragma endregion MappedLazySource
+
+
+#pragma region Files
+/**
+ * Maps the file into memory, rather than reading it. The result shares
+ * the mapping like a lazy copy would share its source: reading costs
+ * nothing, the first modification copies the contents out, and the file
+ * is unmapped once no string refers to it anymore.
+ * Files that fit in the small buffer are copied right away, and empty
+ * ones give an empty string.
+ * Throws std::system_error if the file can't be opened or mapped.
+ */
+template <typename Str = String<>>
+Str string_from_file(const std::filesystem::path &path,
+                     const typename Str::allocator_type &alloc = typename Str::allocator_type()) {
+    MappedFile file{path};
+
+    if (file.empty()) {
+        // Nothing is mapped, so there's no data to copy either
+        return Str(alloc);
+    }
+
+    if (file.size() < Str::small_string_size) {
+        return Str(file.data(), file.size(), alloc);
+    }
+
+    return _impl::MappedLazySource<typename Str::allocator_type, typename Str::refcount_type>::share(
+        std::move(file), alloc);
+}
+#pragma endregion Files
+
+
+}
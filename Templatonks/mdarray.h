@@ -0,0 +1,593 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <ACL/type_traits.h>
+#include <concepts>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include "storage.h"
+
+
+namespace mylib {
+
+
+template <size_t Rank>
+using md_index = std::array<size_t, Rank>;
+
+
+#pragma region Layouts
+namespace _impl {
+
+template <size_t Rank, bool ColumnMajor>
+class StridedMapping {
+public:
+    using index_type = md_index<Rank>;
+
+    static constexpr bool is_strided = true;
+    /// The dimension with the unit stride, which should be iterated over innermost
+    static constexpr size_t innermost = ColumnMajor ? 0 : Rank - 1;
+
+
+    constexpr StridedMapping() = default;
+
+    constexpr explicit StridedMapping(const index_type &extents) {
+        size_t stride = 1;
+
+        for (size_t i = 0; i < Rank; ++i) {
+            size_t dim = ColumnMajor ? i : Rank - 1 - i;
+
+            strides_[dim] = stride;
+            stride *= extents[dim];
+        }
+
+        size_ = stride;
+    }
+
+    constexpr size_t operator()(const index_type &idx) const {
+        return [&]<size_t ... Ns>(std::index_sequence<Ns...>) {
+            return ((idx[Ns] * strides_[Ns]) + ... + 0);
+        }(std::make_index_sequence<Rank>());
+    }
+
+    constexpr size_t required_size() const {
+        return size_;
+    }
+
+    constexpr const index_type &strides() const {
+        return strides_;
+    }
+
+protected:
+    index_type strides_{};
+    size_t size_ = 0;
+
+};
+
+}
+
+struct RowMajorLayout {
+    static constexpr size_t preferred_tile = 32;
+
+    template <size_t Rank>
+    using mapping = _impl::StridedMapping<Rank, false>;
+};
+
+struct ColumnMajorLayout {
+    static constexpr size_t preferred_tile = 32;
+
+    template <size_t Rank>
+    using mapping = _impl::StridedMapping<Rank, true>;
+};
+
+/**
+ * Stores the array as a row-major grid of TileSize^Rank tiles, each of which
+ * is row-major itself. The extents are padded up to a multiple of TileSize.
+ */
+template <size_t TileSize>
+requires (TileSize > 0)
+struct BlockedLayout {
+    static constexpr size_t preferred_tile = TileSize;
+
+    template <size_t Rank>
+    class mapping {
+    public:
+        using index_type = md_index<Rank>;
+
+        static constexpr bool is_strided = false;
+        static constexpr size_t innermost = Rank - 1;
+
+        static constexpr size_t tile_volume = [] {
+            size_t result = 1;
+
+            for (size_t i = 0; i < Rank; ++i) {
+                result *= TileSize;
+            }
+
+            return result;
+        }();
+
+
+        constexpr mapping() = default;
+
+        constexpr explicit mapping(const index_type &extents) {
+            size_t stride = 1;
+
+            for (size_t dim = Rank; dim-- > 0;) {
+                tile_strides_[dim] = stride;
+                stride *= (extents[dim] + TileSize - 1) / TileSize;
+            }
+
+            size_ = stride * tile_volume;
+        }
+
+        constexpr size_t operator()(const index_type &idx) const {
+            size_t tile = 0;
+            size_t inner = 0;
+
+            for (size_t dim = 0; dim < Rank; ++dim) {
+                tile += idx[dim] / TileSize * tile_strides_[dim];
+                inner = inner * TileSize + idx[dim] % TileSize;
+            }
+
+            return tile * tile_volume + inner;
+        }
+
+        constexpr size_t required_size() const {
+            return size_;
+        }
+
+    protected:
+        index_type tile_strides_{};
+        size_t size_ = 0;
+
+    };
+};
+#pragma endregion Layouts
+
+
+#pragma region Index iteration
+namespace _impl {
+
+/// Calls func(idx) for every idx < extents, with dimension Inner varying the fastest
+template <size_t Inner, size_t Rank, typename F>
+void md_for_each_index(const md_index<Rank> &extents, F &&func) {
+    static_assert(Inner == 0 || Inner == Rank - 1);
+
+    for (size_t extent : extents) {
+        if (extent == 0) {
+            return;
+        }
+    }
+
+    md_index<Rank> idx{};
+
+    while (true) {
+        for (idx[Inner] = 0; idx[Inner] < extents[Inner]; ++idx[Inner]) {
+            func(std::as_const(idx));
+        }
+
+        size_t step = 1;
+        for (; step < Rank; ++step) {
+            size_t dim = Inner == 0 ? step : Rank - 1 - step;
+
+            if (++idx[dim] < extents[dim]) {
+                break;
+            }
+
+            idx[dim] = 0;
+        }
+
+        if (step == Rank) {
+            return;
+        }
+    }
+}
+
+}
+#pragma endregion Index iteration
+
+
+template <typename Arr>
+class MdView;
+
+
+#pragma region MdArray
+/**
+ * A multi-dimensional array over a single dynamic storage, with the element
+ * placement controlled by Layout (RowMajorLayout, ColumnMajorLayout or BlockedLayout<N>).
+ * Subviews (MdView) refer to the array's elements and never copy them.
+ */
+template <typename T_, size_t Rank_,
+          template <typename T> typename Storage_ = DynamicLinearStorage,
+          typename Layout_ = RowMajorLayout>
+requires (!std::is_reference_v<T_> && Rank_ > 0 &&
+          Storage<Storage_<T_>, T_>)
+class MdArray {
+public:
+    using value_type = T_;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using layout_type = Layout_;
+    using index_type = md_index<Rank_>;
+    using mapping_type = typename layout_type::template mapping<Rank_>;
+    using view_type = MdView<MdArray>;
+    using const_view_type = MdView<const MdArray>;
+
+    static constexpr size_t rank = Rank_;
+
+    #pragma region Protected helpers
+protected:
+    using storage_type = Storage_<value_type>;
+
+public:
+    #pragma endregion Protected helpers
+
+    MdArray() : storage() {}
+
+    explicit MdArray(const index_type &extents) :
+        extents_{extents}, mapping_(extents),
+        storage(mapping_.required_size()) {
+
+        static_assert(storage_type::is_dynamic);
+    }
+
+    MdArray(const index_type &extents, const value_type &value) :
+        extents_{extents}, mapping_(extents),
+        storage(mapping_.required_size(), value) {
+
+        static_assert(storage_type::is_dynamic);
+    }
+
+    template <std::convertible_to<size_type> ... Is>
+    requires (sizeof...(Is) == rank)
+    explicit MdArray(Is ... extents) :
+        MdArray(index_type{(size_type)extents...}) {}
+
+    #pragma region Access
+    /// Unchecked
+    constexpr reference operator[](const index_type &idx) {
+        assert(in_bounds(idx));
+
+        return storage.item(mapping_(idx));
+    }
+
+    /// Unchecked
+    constexpr const_reference operator[](const index_type &idx) const {
+        return (*const_cast<MdArray *>(this))[idx];
+    }
+
+    /// Unchecked
+    template <std::convertible_to<size_type> ... Is>
+    requires (sizeof...(Is) == rank)
+    constexpr reference operator()(Is ... idx) {
+        return (*this)[index_type{(size_type)idx...}];
+    }
+
+    /// Unchecked
+    template <std::convertible_to<size_type> ... Is>
+    requires (sizeof...(Is) == rank)
+    constexpr const_reference operator()(Is ... idx) const {
+        return (*this)[index_type{(size_type)idx...}];
+    }
+
+    reference at(const index_type &idx) {
+        if (!in_bounds(idx)) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        return (*this)[idx];
+    }
+
+    const_reference at(const index_type &idx) const {
+        return const_cast<MdArray *>(this)->at(idx);
+    }
+    #pragma endregion Access
+
+    #pragma region Size-related info
+    constexpr const index_type &extents() const {
+        return extents_;
+    }
+
+    constexpr size_type extent(size_t dim) const {
+        assert(dim < rank);
+
+        return extents_[dim];
+    }
+
+    constexpr size_type size() const {
+        size_type result = 1;
+
+        for (size_type extent : extents_) {
+            result *= extent;
+        }
+
+        return result;
+    }
+
+    constexpr bool in_bounds(const index_type &idx) const {
+        for (size_t dim = 0; dim < rank; ++dim) {
+            if (idx[dim] >= extents_[dim]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    constexpr const mapping_type &mapping() const {
+        return mapping_;
+    }
+    #pragma endregion Size-related info
+
+    #pragma region Views
+    view_type view() {
+        return view_type(this, index_type{}, extents_);
+    }
+
+    const_view_type view() const {
+        return const_view_type(this, index_type{}, extents_);
+    }
+
+    /// Elements from..to (exclusive), taking every step-th one along each dimension
+    view_type subview(const index_type &from, const index_type &to,
+                      const index_type &step = _unit_steps()) {
+        return view().subview(from, to, step);
+    }
+
+    const_view_type subview(const index_type &from, const index_type &to,
+                            const index_type &step = _unit_steps()) const {
+        return view().subview(from, to, step);
+    }
+    #pragma endregion Views
+
+    #pragma region Iteration
+    /// Calls func(idx, item) for every element, in an order that suits the layout
+    template <typename F>
+    void for_each(F &&func) {
+        if constexpr (mapping_type::is_strided) {
+            _impl::md_for_each_index<mapping_type::innermost>(extents_, [&](const index_type &idx) {
+                func(idx, (*this)[idx]);
+            });
+        } else {
+            for_each_tile([&](view_type tile) {
+                tile.for_each([&](const index_type &idx, reference item) {
+                    func(tile.parent_index(idx), item);
+                });
+            });
+        }
+    }
+
+    template <typename F>
+    void for_each(F &&func) const {
+        const_cast<MdArray *>(this)->for_each([&](const index_type &idx, const_reference item) {
+            func(idx, item);
+        });
+    }
+
+    /**
+     * Calls func(view) for every tile of tile^rank elements (smaller at the edges).
+     * The tiles are visited in the layout's preferred order. For BlockedLayout
+     * with a matching tile size, every tile is contiguous in memory.
+     */
+    template <typename F>
+    void for_each_tile(F &&func, size_type tile = layout_type::preferred_tile) {
+        assert(tile > 0);
+
+        index_type tile_counts{};
+        for (size_t dim = 0; dim < rank; ++dim) {
+            tile_counts[dim] = (extents_[dim] + tile - 1) / tile;
+        }
+
+        _impl::md_for_each_index<mapping_type::innermost>(tile_counts, [&](const index_type &tile_idx) {
+            index_type origin{};
+            index_type tile_extents{};
+
+            for (size_t dim = 0; dim < rank; ++dim) {
+                origin[dim] = tile_idx[dim] * tile;
+                tile_extents[dim] = std::min(tile, extents_[dim] - origin[dim]);
+            }
+
+            func(view_type(this, origin, tile_extents));
+        });
+    }
+    #pragma endregion Iteration
+
+    void fill(const value_type &value) {
+        for (size_type i = 0; i < storage.size(); ++i) {
+            storage.item(i) = value;
+        }
+    }
+
+    void swap(MdArray &other) {
+        std::swap(extents_, other.extents_);
+        std::swap(mapping_, other.mapping_);
+        std::swap(storage,  other.storage );
+    }
+
+protected:
+    index_type extents_{};
+    mapping_type mapping_{};
+    storage_type storage;
+
+
+    static constexpr index_type _unit_steps() {
+        index_type result{};
+        result.fill(1);
+
+        return result;
+    }
+
+};
+#pragma endregion MdArray
+
+
+#pragma region MdView
+/**
+ * A non-owning strided window into an MdArray. Arr may be const-qualified.
+ * Indices are relative to the view: idx maps to origin + idx * step in the parent.
+ */
+template <typename Arr>
+class MdView {
+public:
+    using array_type = Arr;
+    static constexpr bool is_const = std::is_const_v<Arr>;
+
+    using value_type = typename Arr::value_type;
+    using reference = std::conditional_t<is_const, typename Arr::const_reference,
+                                                   typename Arr::reference>;
+    using size_type = typename Arr::size_type;
+    using index_type = typename Arr::index_type;
+
+    static constexpr size_t rank = Arr::rank;
+
+
+    constexpr MdView(Arr *array, const index_type &origin,
+                     const index_type &extents) :
+        array_{array}, origin_{origin}, extents_{extents} {
+
+        steps_.fill(1);
+    }
+
+    constexpr MdView(Arr *array, const index_type &origin,
+                     const index_type &extents, const index_type &steps) :
+        array_{array}, origin_{origin}, extents_{extents}, steps_{steps} {}
+
+    constexpr MdView(const MdView &other) = default;
+    constexpr MdView &operator=(const MdView &other) = default;
+
+    /// Allows passing mutable views where const ones are expected
+    constexpr operator MdView<const Arr>() const requires (!is_const) {
+        return MdView<const Arr>(array_, origin_, extents_, steps_);
+    }
+
+    #pragma region Access
+    constexpr index_type parent_index(const index_type &idx) const {
+        index_type result{};
+
+        for (size_t dim = 0; dim < rank; ++dim) {
+            result[dim] = origin_[dim] + idx[dim] * steps_[dim];
+        }
+
+        return result;
+    }
+
+    /// Unchecked
+    constexpr reference operator[](const index_type &idx) const {
+        assert(in_bounds(idx));
+
+        return (*array_)[parent_index(idx)];
+    }
+
+    /// Unchecked
+    template <std::convertible_to<size_type> ... Is>
+    requires (sizeof...(Is) == rank)
+    constexpr reference operator()(Is ... idx) const {
+        return (*this)[index_type{(size_type)idx...}];
+    }
+
+    reference at(const index_type &idx) const {
+        if (!in_bounds(idx)) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        return (*this)[idx];
+    }
+    #pragma endregion Access
+
+    #pragma region Size-related info
+    constexpr const index_type &extents() const {
+        return extents_;
+    }
+
+    constexpr size_type extent(size_t dim) const {
+        assert(dim < rank);
+
+        return extents_[dim];
+    }
+
+    constexpr size_type size() const {
+        size_type result = 1;
+
+        for (size_type extent : extents_) {
+            result *= extent;
+        }
+
+        return result;
+    }
+
+    constexpr bool in_bounds(const index_type &idx) const {
+        for (size_t dim = 0; dim < rank; ++dim) {
+            if (idx[dim] >= extents_[dim]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+    #pragma endregion Size-related info
+
+    /// Same as MdArray::subview, relative to this view
+    MdView subview(const index_type &from, const index_type &to,
+                   const index_type &step) const {
+        index_type new_extents{};
+        index_type new_steps{};
+
+        for (size_t dim = 0; dim < rank; ++dim) {
+            if (from[dim] > to[dim] || to[dim] > extents_[dim] || step[dim] == 0) {
+                throw std::out_of_range("Invalid subview bounds");
+            }
+
+            new_extents[dim] = (to[dim] - from[dim] + step[dim] - 1) / step[dim];
+            new_steps[dim] = steps_[dim] * step[dim];
+        }
+
+        return MdView(array_, parent_index(from), new_extents, new_steps);
+    }
+
+    /// Calls func(idx, item) for every element; idx is relative to the view
+    template <typename F>
+    void for_each(F &&func) const {
+        using mapping_type = typename Arr::mapping_type;
+
+        _impl::md_for_each_index<mapping_type::innermost>(extents_, [&](const index_type &idx) {
+            func(idx, (*this)[idx]);
+        });
+    }
+
+    /// Assigns the other view's elements to this one's; the extents must match
+    template <typename OtherArr>
+    MdView &assign(const MdView<OtherArr> &other) requires (!is_const) {
+        if (extents_ != other.extents()) {
+            throw std::length_error("Argument size mismatch");
+        }
+
+        for_each([&](const index_type &idx, reference item) {
+            item = other[idx];
+        });
+
+        return *this;
+    }
+
+protected:
+    Arr *array_;
+    index_type origin_;
+    index_type extents_;
+    index_type steps_;
+
+};
+#pragma endregion MdView
+
+
+#pragma region Aliases
+template <typename T, size_t Rank, size_t TileSize = 16>
+using TiledArray = MdArray<T, Rank, DynamicLinearStorage, BlockedLayout<TileSize>>;
+#pragma endregion Aliases
+
+
+}
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <ACL/type_traits.h>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <utility>
+#include "array.h"
+
+
+namespace mylib {
+
+
+#pragma region PackedIntArray
+/**
+ * An array of unsigned integers, each occupying exactly Bits bits.
+ * The values are packed into 64-bit words, held by an Array<uint64_t, Storage_>,
+ * so an element may straddle two adjacent words.
+ * Single elements are accessed through reference proxies (similar to Array<bool>),
+ * while decode() and encode() process whole blocks of words at once.
+ * Values wider than Bits are truncated to their low Bits bits wherever they
+ * are stored, like in an unsigned narrowing conversion.
+ */
+template <unsigned Bits, template <typename T> typename Storage_ = DynamicLinearStorage>
+requires (0 < Bits && Bits <= 32 &&
+          Storage<Storage_<uint64_t>, uint64_t> &&
+          Storage_<uint64_t>::is_dynamic)
+class PackedIntArray : protected Array<uint64_t, Storage_> {
+    #pragma region Protected stuff
+protected:
+    using Base = Array<uint64_t, Storage_>;
+    using word_type = uint64_t;
+    class ReferenceProxy;
+
+    static constexpr unsigned word_bits = 64;
+
+    // The smallest group of elements that starts and ends on a word boundary
+    static constexpr unsigned _block_gcd = std::gcd(Bits, word_bits);
+    static constexpr size_t block_elems = word_bits / _block_gcd;
+    static constexpr size_t block_words = Bits      / _block_gcd;
+
+    static constexpr size_t _words_for(size_t elems) {
+        return (elems * Bits + word_bits - 1) / word_bits;
+    }
+
+    using Base::storage;
+    #pragma endregion Protected stuff
+
+public:
+    using value_type = uint32_t;
+    using reference = ReferenceProxy;
+    using const_reference = value_type;
+    using pointer = void;  // Elements aren't addressable
+    using const_pointer = void;
+    using size_type = typename Base::size_type;
+    using difference_type = typename Base::difference_type;
+    using iterator = _impl::ArrayIterator<PackedIntArray, value_type>;
+    using const_iterator = _impl::ArrayIterator<const PackedIntArray, const value_type>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr unsigned bits = Bits;
+    static constexpr value_type max_value = (value_type)(((uint64_t)1 << Bits) - 1);
+
+
+    PackedIntArray() : Base() {}
+
+    PackedIntArray(size_type size) :
+        Base(_words_for(size), 0), size_{size} {}
+
+    PackedIntArray(size_type size, value_type value) :
+        PackedIntArray(size) {
+
+        fill(value);
+    }
+
+    PackedIntArray(std::initializer_list<value_type> values) :
+        PackedIntArray(values.size()) {
+
+        encode(0, values.size(), std::data(values));
+    }
+
+    constexpr reference operator[](difference_type idx) {
+        return ReferenceProxy(this, prepare_idx(idx));
+    }
+
+    constexpr const_reference operator[](difference_type idx) const {
+        return get(prepare_idx(idx));
+    }
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, size());
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    reverse_iterator rbegin() {
+        return std::make_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return std::make_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() {
+        return std::make_reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return std::make_reverse_iterator(begin());
+    }
+
+    void push_back(value_type value) {
+        if (_words_for(size_ + 1) > storage.size()) {
+            *storage.expand_one() = 0;
+        }
+
+        set(size_++, value);
+    }
+
+    template <typename ... As>
+    void emplace_back(As &&... args) {
+        push_back(value_type{std::forward<As>(args)...});
+    }
+
+    void pop_back() {
+        if (size_ == 0) {
+            throw std::out_of_range("Cannot remove from empty container");
+        }
+
+        --size_;
+
+        if (_words_for(size_) < storage.size()) {
+            storage.remove_one();
+        }
+    }
+
+    void clear() {
+        Base::clear();
+        size_ = 0;
+    }
+
+    void fill(value_type value) {
+        value_type buf[block_elems];
+        std::fill(std::begin(buf), std::end(buf), value);
+
+        for (size_type pos = 0; pos < size_; pos += block_elems) {
+            encode(pos, std::min(block_elems, size_ - pos), buf);
+        }
+    }
+
+    constexpr size_type size() const {
+        return size_;
+    }
+
+    inline bool empty() const {
+        return size() == 0;
+    }
+
+    /// The number of 64-bit words actually occupied
+    inline size_type words() const {
+        return storage.size();
+    }
+
+    inline reference front() {
+        return (*this)[0];
+    }
+
+    inline const_reference front() const {
+        return (*this)[0];
+    }
+
+    inline reference back() {
+        return (*this)[-1];
+    }
+
+    inline const_reference back() const {
+        return (*this)[-1];
+    }
+
+    void swap(PackedIntArray &other) {
+        Base::swap(other);
+        std::swap(size_, other.size_);
+    }
+
+    using Base::allocate_now;
+
+    #pragma region Element access
+    /// Unchecked, unlike operator[]
+    value_type get(size_type idx) const {
+        assert(idx < size_);
+
+        const size_type bit = idx * Bits;
+        const size_type word = bit / word_bits;
+        const unsigned offset = bit % word_bits;
+
+        word_type result = storage.item(word) >> offset;
+
+        if (offset + Bits > word_bits) {
+            result |= storage.item(word + 1) << (word_bits - offset);
+        }
+
+        return (value_type)(result & max_value);
+    }
+
+    /// Unchecked, unlike operator[]
+    void set(size_type idx, value_type value) {
+        assert(idx < size_);
+
+        const size_type bit = idx * Bits;
+        const size_type word = bit / word_bits;
+        const unsigned offset = bit % word_bits;
+        const word_type wide_value = value & max_value;
+
+        word_type &lo = storage.item(word);
+        lo &= ~((word_type)max_value << offset);
+        lo |= wide_value << offset;
+
+        if (offset + Bits > word_bits) {
+            word_type &hi = storage.item(word + 1);
+            const unsigned shift = word_bits - offset;
+
+            hi &= ~((word_type)max_value >> shift);
+            hi |= wide_value >> shift;
+        }
+    }
+    #pragma endregion Element access
+
+    #pragma region Bulk operations
+    /**
+     * Unpacks count elements starting at pos into out.
+     * Whole blocks (block_elems elements spanning block_words words) are decoded
+     * with compile-time shifts, which lets the compiler vectorize the loop.
+     */
+    void decode(size_type pos, size_type count, value_type *out) const {
+        check_range(pos, count);
+
+        for (; count > 0 && pos % block_elems != 0; --count) {
+            *out++ = get(pos++);
+        }
+
+        word_type buf[block_words] = {};
+
+        for (; count >= block_elems; count -= block_elems) {
+            const size_type first_word = pos / block_elems * block_words;
+
+            if constexpr (Base::is_contiguous) {
+                _decode_block(storage.data() + first_word, out,
+                              std::make_index_sequence<block_elems>());
+            } else {
+                for (size_type i = 0; i < block_words; ++i) {
+                    buf[i] = storage.item(first_word + i);
+                }
+
+                _decode_block(buf, out, std::make_index_sequence<block_elems>());
+            }
+
+            pos += block_elems;
+            out += block_elems;
+        }
+
+        for (; count > 0; --count) {
+            *out++ = get(pos++);
+        }
+    }
+
+    /// The inverse of decode()
+    void encode(size_type pos, size_type count, const value_type *in) {
+        check_range(pos, count);
+
+        for (; count > 0 && pos % block_elems != 0; --count) {
+            set(pos++, *in++);
+        }
+
+        word_type buf[block_words] = {};
+
+        for (; count >= block_elems; count -= block_elems) {
+            const size_type first_word = pos / block_elems * block_words;
+
+            std::fill(std::begin(buf), std::end(buf), 0);
+            _encode_block(buf, in, std::make_index_sequence<block_elems>());
+
+            if constexpr (Base::is_contiguous) {
+                std::memcpy(storage.data() + first_word, buf, sizeof(word_type) * block_words);
+            } else {
+                for (size_type i = 0; i < block_words; ++i) {
+                    storage.item(first_word + i) = buf[i];
+                }
+            }
+
+            pos += block_elems;
+            in += block_elems;
+        }
+
+        for (; count > 0; --count) {
+            set(pos++, *in++);
+        }
+    }
+    #pragma endregion Bulk operations
+
+protected:
+    size_type size_{0};
+
+
+    inline size_type prepare_idx(difference_type idx) const {
+        size_type sz = size();
+
+        if (!(-(difference_type)sz <= idx && idx < (difference_type)sz)) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        return (idx + sz) % sz;
+    }
+
+    inline void check_range(size_type pos, size_type count) const {
+        if (pos > size_ || count > size_ - pos) {
+            throw std::out_of_range("Range out of bounds");
+        }
+    }
+
+    #pragma region Block helpers
+    template <size_t Idx>
+    static constexpr value_type _extract(const word_type *words) {
+        constexpr size_t bit = Idx * Bits;
+        constexpr size_t word = bit / word_bits;
+        constexpr unsigned offset = bit % word_bits;
+
+        if constexpr (offset + Bits <= word_bits) {
+            return (value_type)((words[word] >> offset) & max_value);
+        } else {
+            return (value_type)(((words[word    ] >> offset) |
+                                 (words[word + 1] << (word_bits - offset))) & max_value);
+        }
+    }
+
+    template <size_t Idx>
+    static constexpr void _deposit(word_type *words, value_type value) {
+        constexpr size_t bit = Idx * Bits;
+        constexpr size_t word = bit / word_bits;
+        constexpr unsigned offset = bit % word_bits;
+
+        const word_type wide_value = value & max_value;
+
+        words[word] |= wide_value << offset;
+
+        if constexpr (offset + Bits > word_bits) {
+            words[word + 1] |= wide_value >> (word_bits - offset);
+        }
+    }
+
+    template <size_t ... Is>
+    static constexpr void _decode_block(const word_type *words, value_type *out,
+                                        std::index_sequence<Is...>) {
+        ((out[Is] = _extract<Is>(words)), ...);
+    }
+
+    template <size_t ... Is>
+    static constexpr void _encode_block(word_type *words, const value_type *in,
+                                        std::index_sequence<Is...>) {
+        (_deposit<Is>(words, in[Is]), ...);
+    }
+    #pragma endregion Block helpers
+
+
+    #pragma region ReferenceProxy
+    class ReferenceProxy {
+    public:
+        inline operator value_type() const {
+            return array->get(idx);
+        }
+
+        inline ReferenceProxy &operator=(value_type value) {
+            array->set(idx, value);
+
+            return *this;
+        }
+
+        inline ReferenceProxy &operator=(const ReferenceProxy &other) {
+            return *this = (value_type)other;
+        }
+
+        inline ReferenceProxy(const ReferenceProxy &other) = default;
+
+    protected:
+        PackedIntArray *array;
+        size_type idx;
+
+        friend class PackedIntArray;
+
+        ReferenceProxy(PackedIntArray *array_, size_type idx_) :
+            array{array_}, idx{idx_} {}
+
+    };
+    #pragma endregion ReferenceProxy
+
+};
+#pragma endregion PackedIntArray
+
+
+#pragma region Aliases
+template <unsigned Bits>
+using PackedVector = PackedIntArray<Bits, DynamicLinearStorage>;
+
+template <unsigned Bits, size_t ChunkSize>
+using PackedChunkedArray = PackedIntArray<Bits, DynamicChunkedStorageAdapter<ChunkSize>::template type>;
+#pragma endregion Aliases
+
+
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <ACL/type_traits.h>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include "array.h"
+
+
+namespace mylib {
+
+
+#pragma region PriorityQueue
+namespace _impl {
+
+template <typename T>
+struct PQEntry {
+    T value;
+    size_t handle;
+};
+
+/**
+ * The handles' bookkeeping, empty without them. It's a base rather than a member,
+ * so that the empty case takes no space even where [[no_unique_address]] is ignored.
+ */
+template <bool WithHandles>
+struct PQHandles {};
+
+template <>
+struct PQHandles<true> {
+    Vector<size_t> positions_{};
+    Vector<size_t> free_handles_{};
+};
+
+}
+
+/**
+ * A D-ary heap over a Vector. Like std::priority_queue, top() is the greatest
+ * element according to Cmp (so std::greater gives a min-queue).
+ * With WithHandles, push() returns a handle that stays valid until the element
+ * is popped or erased, and allows changing the element's priority in place.
+ */
+template <typename T, typename Cmp = std::less<T>, size_t D = 4, bool WithHandles = false>
+requires (D >= 2 && std::strict_weak_order<Cmp &, const T &, const T &>)
+class PriorityQueue : protected _impl::PQHandles<WithHandles> {
+public:
+    using value_type = T;
+    using value_compare = Cmp;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using size_type = size_t;
+    using handle_type = size_type;
+
+    static constexpr size_type arity = D;
+    static constexpr bool with_handles = WithHandles;
+    static constexpr handle_type npos = (handle_type)-1;
+
+    #pragma region Protected helpers
+protected:
+    using entry_type = std::conditional_t<WithHandles, _impl::PQEntry<T>, T>;
+
+public:
+    #pragma endregion Protected helpers
+
+    #pragma region Constructors
+    explicit PriorityQueue(const Cmp &cmp = Cmp()) :
+        cmp_{cmp} {}
+
+    /// Copies the array's elements and builds the heap in linear time
+    template <template <typename T_> typename Storage_>
+    explicit PriorityQueue(const Array<T, Storage_> &values, const Cmp &cmp = Cmp()) :
+        PriorityQueue(values.begin(), values.end(), cmp) {}
+
+    template <std::input_iterator InputIt>
+    PriorityQueue(InputIt first, InputIt last, const Cmp &cmp = Cmp()) :
+        cmp_{cmp} {
+
+        for (; first != last; ++first) {
+            _append(*first);
+        }
+
+        heapify();
+    }
+
+    /// Takes over the vector's buffer and builds the heap in place
+    explicit PriorityQueue(Vector<T> &&values, const Cmp &cmp = Cmp()) requires (!WithHandles) :
+        heap_{std::move(values)}, cmp_{cmp} {
+
+        heapify();
+    }
+    #pragma endregion Constructors
+
+    #pragma region Basic information
+    inline size_type size() const {
+        return heap_.size();
+    }
+
+    inline bool empty() const {
+        return size() == 0;
+    }
+
+    const_reference top() const {
+        if (empty()) {
+            throw std::out_of_range("Empty queue has no top");
+        }
+
+        return _value(_data()[0]);
+    }
+    #pragma endregion Basic information
+
+    #pragma region Modification
+    auto push(abel::universal_ref<value_type> auto &&value) {
+        size_type pos = _append(FWD(value));
+
+        if constexpr (WithHandles) {
+            handle_type handle = _data()[pos].handle;
+            _sift_up(pos);
+
+            return handle;
+        } else {
+            _sift_up(pos);
+        }
+    }
+
+    template <typename ... As>
+    auto emplace(As &&... args) {
+        return push(value_type(std::forward<As>(args)...));
+    }
+
+    void pop() {
+        if (empty()) {
+            throw std::out_of_range("Cannot pop from empty queue");
+        }
+
+        _pop_top();
+    }
+
+    /// Equivalent to a push followed by a pop, but cheaper. Returns the popped element
+    value_type push_pop(value_type value) requires (!WithHandles) {
+        if (empty() || !cmp_(value, top())) {
+            return value;
+        }
+
+        return _exchange_top(std::move(value));
+    }
+
+    /// Equivalent to a pop followed by a push, but cheaper. Returns the popped element
+    value_type replace_top(value_type value) requires (!WithHandles) {
+        if (empty()) {
+            throw std::out_of_range("Empty queue has no top");
+        }
+
+        return _exchange_top(std::move(value));
+    }
+
+    /// Rebuilds the heap property in linear time, e.g. after bulk modifications
+    void heapify() {
+        if (size() < 2) {
+            return;
+        }
+
+        for (size_type pos = _parent(size() - 1) + 1; pos-- > 0;) {
+            _sift_down(pos);
+        }
+    }
+
+    void clear() {
+        heap_.clear();
+
+        if constexpr (WithHandles) {
+            this->positions_.clear();
+            this->free_handles_.clear();
+        }
+    }
+
+    void swap(PriorityQueue &other) {
+        heap_.swap(other.heap_);
+        std::swap(cmp_, other.cmp_);
+
+        if constexpr (WithHandles) {
+            this->positions_.swap(other.positions_);
+            this->free_handles_.swap(other.free_handles_);
+        }
+    }
+    #pragma endregion Modification
+
+    #pragma region Handles
+    bool contains(handle_type handle) const requires WithHandles {
+        return handle < this->positions_.size() && _positions()[handle] != npos;
+    }
+
+    const_reference get(handle_type handle) const requires WithHandles {
+        return _data()[_position_of(handle)].value;
+    }
+
+    /// Changes the element's priority in either direction (covers decrease-key)
+    void update(handle_type handle, value_type value) requires WithHandles {
+        size_type pos = _position_of(handle);
+        entry_type *data = _data();
+
+        bool raised = cmp_(data[pos].value, value);
+        data[pos].value = std::move(value);
+
+        if (raised) {
+            _sift_up(pos);
+        } else {
+            _sift_down(pos);
+        }
+    }
+
+    void erase(handle_type handle) requires WithHandles {
+        _remove_at(_position_of(handle));
+    }
+    #pragma endregion Handles
+
+protected:
+    Vector<entry_type> heap_{};
+    [[no_unique_address]] Cmp cmp_;
+
+
+    #pragma region Protected interface
+    static constexpr size_type _parent(size_type pos) {
+        return (pos - 1) / D;
+    }
+
+    static constexpr size_type _first_child(size_type pos) {
+        return pos * D + 1;
+    }
+
+    static constexpr const T &_value(const entry_type &entry) {
+        if constexpr (WithHandles) {
+            return entry.value;
+        } else {
+            return entry;
+        }
+    }
+
+    // Vector's own iterators are raw pointers, so this skips
+    // operator[]'s range checks on the hot paths
+    inline entry_type *_data() {
+        return std::to_address(heap_.begin());
+    }
+
+    inline const entry_type *_data() const {
+        return std::to_address(heap_.begin());
+    }
+
+    inline size_type *_positions() {
+        return std::to_address(this->positions_.begin());
+    }
+
+    inline const size_type *_positions() const {
+        return std::to_address(this->positions_.begin());
+    }
+
+    inline void _place(size_type pos, entry_type &&entry) {
+        if constexpr (WithHandles) {
+            _positions()[entry.handle] = pos;
+        }
+
+        _data()[pos] = std::move(entry);
+    }
+
+    size_type _position_of(handle_type handle) const requires WithHandles {
+        if (!contains(handle)) {
+            throw std::out_of_range("Invalid handle");
+        }
+
+        return _positions()[handle];
+    }
+
+    /// Appends without restoring the heap property
+    size_type _append(abel::universal_ref<value_type> auto &&value) {
+        size_type pos = size();
+
+        if constexpr (WithHandles) {
+            handle_type handle = this->positions_.size();
+
+            if (!this->free_handles_.empty()) {
+                handle = this->free_handles_.back();
+                this->free_handles_.pop_back();
+                _positions()[handle] = pos;
+            } else {
+                this->positions_.push_back(pos);
+            }
+
+            heap_.push_back(entry_type{FWD(value), handle});
+        } else {
+            heap_.push_back(FWD(value));
+        }
+
+        return pos;
+    }
+
+    void _remove_at(size_type pos) {
+        assert(pos < size());
+
+        if constexpr (WithHandles) {
+            handle_type handle = _data()[pos].handle;
+            _positions()[handle] = npos;
+            this->free_handles_.push_back(handle);
+        }
+
+        size_type last = size() - 1;
+
+        if (pos != last) {
+            entry_type *data = _data();
+
+            bool raised = cmp_(_value(data[pos]), _value(data[last]));
+            _place(pos, std::move(data[last]));
+            heap_.pop_back();
+
+            if (raised) {
+                _sift_up(pos);
+            } else {
+                _sift_down(pos);
+            }
+        } else {
+            heap_.pop_back();
+        }
+    }
+
+    /**
+     * Moves the hole at the root all the way down to a leaf, and only then
+     * sifts the last element up from there. The last element usually belongs
+     * near the bottom anyway, so this saves a comparison on every level.
+     */
+    void _pop_top() {
+        if constexpr (WithHandles) {
+            handle_type handle = _data()[0].handle;
+            _positions()[handle] = npos;
+            this->free_handles_.push_back(handle);
+        }
+
+        const size_type sz = size() - 1;
+
+        if (sz == 0) {
+            heap_.pop_back();
+            return;
+        }
+
+        entry_type *data = _data();
+        entry_type item = std::move(data[sz]);
+        heap_.pop_back();
+
+        size_type pos = 0;
+
+        while (true) {
+            size_type first = _first_child(pos);
+
+            if (first >= sz) {
+                break;
+            }
+
+            size_type last = std::min(first + D, sz);
+            size_type best = first;
+
+            for (size_type child = first + 1; child < last; ++child) {
+                if (cmp_(_value(data[best]), _value(data[child]))) {
+                    best = child;
+                }
+            }
+
+            _place(pos, std::move(data[best]));
+            pos = best;
+        }
+
+        _place(pos, std::move(item));
+        _sift_up(pos);
+    }
+
+    value_type _exchange_top(value_type &&value) {
+        value_type result = std::exchange(_data()[0], std::move(value));
+
+        _sift_down(0);
+
+        return result;
+    }
+
+    void _sift_up(size_type pos) {
+        entry_type *data = _data();
+        entry_type item = std::move(data[pos]);
+
+        while (pos > 0) {
+            size_type parent = _parent(pos);
+
+            if (!cmp_(_value(data[parent]), _value(item))) {
+                break;
+            }
+
+            _place(pos, std::move(data[parent]));
+            pos = parent;
+        }
+
+        _place(pos, std::move(item));
+    }
+
+    void _sift_down(size_type pos) {
+        entry_type *data = _data();
+        const size_type sz = size();
+        entry_type item = std::move(data[pos]);
+
+        while (true) {
+            size_type first = _first_child(pos);
+
+            if (first >= sz) {
+                break;
+            }
+
+            size_type last = std::min(first + D, sz);
+            size_type best = first;
+
+            for (size_type child = first + 1; child < last; ++child) {
+                if (cmp_(_value(data[best]), _value(data[child]))) {
+                    best = child;
+                }
+            }
+
+            if (!cmp_(_value(item), _value(data[best]))) {
+                break;
+            }
+
+            _place(pos, std::move(data[best]));
+            pos = best;
+        }
+
+        _place(pos, std::move(item));
+    }
+    #pragma endregion Protected interface
+
+};
+#pragma endregion PriorityQueue
+
+
+#pragma region Aliases
+template <typename T, typename Cmp = std::less<T>, size_t D = 4>
+using HandlePriorityQueue = PriorityQueue<T, Cmp, D, true>;
+#pragma endregion Aliases
+
+
+}
@@ -0,0 +1,589 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <ACL/type_traits.h>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "array.h"
+
+
+namespace mylib {
+
+
+#pragma region Helpers
+namespace _impl {
+
+template <typename R>
+concept iterable = requires (R &range) {
+    range.begin();
+    range.end();
+};
+
+template <typename R>
+concept sized_iterable = iterable<R> && requires (R &range) {
+    { range.size() } -> std::convertible_to<size_t>;
+};
+
+template <typename R>
+using iter_t = decltype(std::declval<R &>().begin());
+
+template <typename R>
+using sent_t = decltype(std::declval<R &>().end());
+
+template <typename R>
+using ref_t = decltype(*std::declval<iter_t<R> &>());
+
+/// Lvalue sources are stored by reference, rvalue ones (e.g. other views) by value
+template <typename R>
+using view_source_t = std::conditional_t<std::is_lvalue_reference_v<R>, R, std::remove_cvref_t<R>>;
+
+template <typename It, typename Sent>
+It advance_bounded(It it, size_t count, const Sent &end) {
+    if constexpr (std::random_access_iterator<It> && std::same_as<It, Sent>) {
+        return it + (ptrdiff_t)std::min(count, (size_t)(end - it));
+    } else {
+        for (; count > 0 && it != end; --count) {
+            ++it;
+        }
+
+        return it;
+    }
+}
+
+template <typename F>
+struct RangeAdaptor {
+    F func;
+
+    template <iterable R>
+    friend inline auto operator|(R &&range, RangeAdaptor adaptor) {
+        return std::move(adaptor.func)(std::forward<R>(range));
+    }
+};
+
+template <typename F>
+RangeAdaptor(F) -> RangeAdaptor<F>;
+
+/// An iterator and a sentinel, in case a view needs to yield a range
+template <typename It, typename Sent = It>
+class Subrange {
+public:
+    constexpr Subrange(It first, Sent last) :
+        first_{std::move(first)}, last_{std::move(last)} {}
+
+    constexpr It begin() const { return first_; }
+    constexpr Sent end() const { return last_; }
+
+    constexpr size_t size() const requires std::sized_sentinel_for<Sent, It> {
+        return (size_t)(last_ - first_);
+    }
+
+protected:
+    It first_;
+    Sent last_;
+
+};
+
+}
+#pragma endregion Helpers
+
+
+#pragma region Views
+/*
+ * All the views here are lazy: nothing is evaluated until the view is iterated
+ * over, and a chain of views is still traversed in a single pass. Like any
+ * view, they must not outlive the containers they refer to.
+ */
+
+#pragma region MapView
+template <typename R, typename F>
+class MapView {
+protected:
+    using Src = _impl::view_source_t<R>;
+    using src_iter = _impl::iter_t<Src>;
+    using src_sent = _impl::sent_t<Src>;
+
+public:
+    struct Sentinel {
+        src_sent end;
+    };
+
+    class Iterator {
+    public:
+        using reference = std::invoke_result_t<F &, _impl::ref_t<Src>>;
+        using value_type = std::remove_cvref_t<reference>;
+        using difference_type = ptrdiff_t;
+
+        Iterator(src_iter it, F *func) :
+            it_{std::move(it)}, func_{func} {}
+
+        inline reference operator*() const {
+            return std::invoke(*func_, *it_);
+        }
+
+        inline Iterator &operator++() {
+            ++it_;
+
+            return *this;
+        }
+
+        inline bool operator==(const Sentinel &sent) const {
+            return it_ == sent.end;
+        }
+
+    protected:
+        src_iter it_;
+        F *func_;
+
+    };
+
+
+    MapView(R &&src, F func) :
+        src_(std::forward<R>(src)), func_{std::move(func)} {}
+
+    Iterator begin() { return Iterator(src_.begin(), &func_); }
+    Sentinel end() { return Sentinel{src_.end()}; }
+
+    size_t size() requires _impl::sized_iterable<Src> {
+        return src_.size();
+    }
+
+protected:
+    Src src_;
+    F func_;
+
+};
+#pragma endregion MapView
+
+#pragma region FilterView
+template <typename R, typename P>
+class FilterView {
+protected:
+    using Src = _impl::view_source_t<R>;
+    using src_iter = _impl::iter_t<Src>;
+    using src_sent = _impl::sent_t<Src>;
+
+public:
+    struct Sentinel {};
+
+    class Iterator {
+    public:
+        using reference = _impl::ref_t<Src>;
+        using value_type = std::remove_cvref_t<reference>;
+        using difference_type = ptrdiff_t;
+
+        Iterator(src_iter it, src_sent end, P *pred) :
+            it_{std::move(it)}, end_{std::move(end)}, pred_{pred} {
+
+            skip();
+        }
+
+        inline reference operator*() const {
+            return *it_;
+        }
+
+        inline Iterator &operator++() {
+            ++it_;
+            skip();
+
+            return *this;
+        }
+
+        inline bool operator==(const Sentinel &) const {
+            return it_ == end_;
+        }
+
+    protected:
+        src_iter it_;
+        src_sent end_;
+        P *pred_;
+
+
+        inline void skip() {
+            while (!(it_ == end_) && !std::invoke(*pred_, *it_)) {
+                ++it_;
+            }
+        }
+
+    };
+
+
+    FilterView(R &&src, P pred) :
+        src_(std::forward<R>(src)), pred_{std::move(pred)} {}
+
+    Iterator begin() { return Iterator(src_.begin(), src_.end(), &pred_); }
+    Sentinel end() { return Sentinel{}; }
+
+protected:
+    Src src_;
+    P pred_;
+
+};
+#pragma endregion FilterView
+
+#pragma region TakeView
+template <typename R>
+class TakeView {
+protected:
+    using Src = _impl::view_source_t<R>;
+    using src_iter = _impl::iter_t<Src>;
+    using src_sent = _impl::sent_t<Src>;
+
+public:
+    struct Sentinel {
+        src_sent end;
+    };
+
+    class Iterator {
+    public:
+        using reference = _impl::ref_t<Src>;
+        using value_type = std::remove_cvref_t<reference>;
+        using difference_type = ptrdiff_t;
+
+        Iterator(src_iter it, size_t left) :
+            it_{std::move(it)}, left_{left} {}
+
+        inline reference operator*() const {
+            return *it_;
+        }
+
+        inline Iterator &operator++() {
+            assert(left_ > 0);
+
+            ++it_;
+            --left_;
+
+            return *this;
+        }
+
+        inline bool operator==(const Sentinel &sent) const {
+            return left_ == 0 || it_ == sent.end;
+        }
+
+    protected:
+        src_iter it_;
+        size_t left_;
+
+    };
+
+
+    TakeView(R &&src, size_t count) :
+        src_(std::forward<R>(src)), count_{count} {}
+
+    Iterator begin() { return Iterator(src_.begin(), count_); }
+    Sentinel end() { return Sentinel{src_.end()}; }
+
+    size_t size() requires _impl::sized_iterable<Src> {
+        return std::min(count_, (size_t)src_.size());
+    }
+
+protected:
+    Src src_;
+    size_t count_;
+
+};
+#pragma endregion TakeView
+
+#pragma region ChunkView
+/**
+ * Yields consecutive ranges of (at most) count elements. Needs forward iterators.
+ * Over common ranges, where iterators compare with each other, the chunks are
+ * plain Subranges. Otherwise, as with other views' iterators, which only compare
+ * with their sentinels, they are TakeViews of the rest of the source.
+ */
+template <typename R>
+requires std::copyable<_impl::iter_t<_impl::view_source_t<R>>>
+class ChunkView {
+protected:
+    using Src = _impl::view_source_t<R>;
+    using src_iter = _impl::iter_t<Src>;
+    using src_sent = _impl::sent_t<Src>;
+
+    static constexpr bool is_common = std::same_as<src_iter, src_sent>;
+
+public:
+    struct Sentinel {};
+
+    class Iterator {
+    public:
+        using reference = std::conditional_t<is_common,
+                                             _impl::Subrange<src_iter>,
+                                             TakeView<_impl::Subrange<src_iter, src_sent>>>;
+        using value_type = reference;
+        using difference_type = ptrdiff_t;
+
+        Iterator(src_iter it, src_sent end, size_t count) :
+            cur_{it}, next_{_impl::advance_bounded(std::move(it), count, end)},
+            end_{std::move(end)}, count_{count} {}
+
+        inline reference operator*() const {
+            if constexpr (is_common) {
+                return reference(cur_, next_);
+            } else {
+                return reference(_impl::Subrange<src_iter, src_sent>(cur_, end_), count_);
+            }
+        }
+
+        inline Iterator &operator++() {
+            cur_ = next_;
+            next_ = _impl::advance_bounded(next_, count_, end_);
+
+            return *this;
+        }
+
+        inline bool operator==(const Sentinel &) const {
+            return cur_ == end_;
+        }
+
+    protected:
+        src_iter cur_;
+        src_iter next_;
+        src_sent end_;
+        size_t count_;
+
+    };
+
+
+    ChunkView(R &&src, size_t count) :
+        src_(std::forward<R>(src)), count_{count} {
+
+        if (count == 0) {
+            throw std::invalid_argument("Chunk size must be positive");
+        }
+    }
+
+    Iterator begin() { return Iterator(src_.begin(), src_.end(), count_); }
+    Sentinel end() { return Sentinel{}; }
+
+    size_t size() requires _impl::sized_iterable<Src> {
+        return ((size_t)src_.size() + count_ - 1) / count_;
+    }
+
+protected:
+    Src src_;
+    size_t count_;
+
+};
+#pragma endregion ChunkView
+
+#pragma region EnumerateView
+/// Yields std::pair<size_t, reference>
+template <typename R>
+class EnumerateView {
+protected:
+    using Src = _impl::view_source_t<R>;
+    using src_iter = _impl::iter_t<Src>;
+    using src_sent = _impl::sent_t<Src>;
+
+public:
+    struct Sentinel {
+        src_sent end;
+    };
+
+    class Iterator {
+    public:
+        using reference = std::pair<size_t, _impl::ref_t<Src>>;
+        using value_type = reference;
+        using difference_type = ptrdiff_t;
+
+        Iterator(src_iter it) :
+            it_{std::move(it)} {}
+
+        inline reference operator*() const {
+            return reference(idx_, *it_);
+        }
+
+        inline Iterator &operator++() {
+            ++it_;
+            ++idx_;
+
+            return *this;
+        }
+
+        inline bool operator==(const Sentinel &sent) const {
+            return it_ == sent.end;
+        }
+
+    protected:
+        src_iter it_;
+        size_t idx_ = 0;
+
+    };
+
+
+    EnumerateView(R &&src) :
+        src_(std::forward<R>(src)) {}
+
+    Iterator begin() { return Iterator(src_.begin()); }
+    Sentinel end() { return Sentinel{src_.end()}; }
+
+    size_t size() requires _impl::sized_iterable<Src> {
+        return src_.size();
+    }
+
+protected:
+    Src src_;
+
+};
+#pragma endregion EnumerateView
+
+#pragma region ZipView
+/// Yields std::pair<reference_a, reference_b>, stopping at the shorter range's end
+template <typename RA, typename RB>
+class ZipView {
+protected:
+    using SrcA = _impl::view_source_t<RA>;
+    using SrcB = _impl::view_source_t<RB>;
+
+public:
+    struct Sentinel {
+        _impl::sent_t<SrcA> end_a;
+        _impl::sent_t<SrcB> end_b;
+    };
+
+    class Iterator {
+    public:
+        using reference = std::pair<_impl::ref_t<SrcA>, _impl::ref_t<SrcB>>;
+        using value_type = reference;
+        using difference_type = ptrdiff_t;
+
+        Iterator(_impl::iter_t<SrcA> it_a, _impl::iter_t<SrcB> it_b) :
+            it_a_{std::move(it_a)}, it_b_{std::move(it_b)} {}
+
+        inline reference operator*() const {
+            return reference(*it_a_, *it_b_);
+        }
+
+        inline Iterator &operator++() {
+            ++it_a_;
+            ++it_b_;
+
+            return *this;
+        }
+
+        inline bool operator==(const Sentinel &sent) const {
+            return it_a_ == sent.end_a || it_b_ == sent.end_b;
+        }
+
+    protected:
+        _impl::iter_t<SrcA> it_a_;
+        _impl::iter_t<SrcB> it_b_;
+
+    };
+
+
+    ZipView(RA &&src_a, RB &&src_b) :
+        src_a_(std::forward<RA>(src_a)), src_b_(std::forward<RB>(src_b)) {}
+
+    Iterator begin() { return Iterator(src_a_.begin(), src_b_.begin()); }
+    Sentinel end() { return Sentinel{src_a_.end(), src_b_.end()}; }
+
+    size_t size() requires (_impl::sized_iterable<SrcA> && _impl::sized_iterable<SrcB>) {
+        return std::min((size_t)src_a_.size(), (size_t)src_b_.size());
+    }
+
+protected:
+    SrcA src_a_;
+    SrcB src_b_;
+
+};
+#pragma endregion ZipView
+#pragma endregion Views
+
+
+#pragma region Adaptors
+namespace views {
+
+template <typename F>
+inline auto map(F func) {
+    return _impl::RangeAdaptor{[func = std::move(func)]<typename R>(R &&src) mutable {
+        return MapView<R, F>(std::forward<R>(src), std::move(func));
+    }};
+}
+
+template <typename P>
+inline auto filter(P pred) {
+    return _impl::RangeAdaptor{[pred = std::move(pred)]<typename R>(R &&src) mutable {
+        return FilterView<R, P>(std::forward<R>(src), std::move(pred));
+    }};
+}
+
+inline auto take(size_t count) {
+    return _impl::RangeAdaptor{[count]<typename R>(R &&src) {
+        return TakeView<R>(std::forward<R>(src), count);
+    }};
+}
+
+inline auto chunk(size_t count) {
+    return _impl::RangeAdaptor{[count]<typename R>(R &&src) {
+        return ChunkView<R>(std::forward<R>(src), count);
+    }};
+}
+
+inline auto enumerate() {
+    return _impl::RangeAdaptor{[]<typename R>(R &&src) {
+        return EnumerateView<R>(std::forward<R>(src));
+    }};
+}
+
+/// The other range is captured the same way as the piped one: by reference if it's an lvalue
+template <_impl::iterable RB>
+inline auto zip(RB &&other) {
+    using holder_type = std::tuple<_impl::view_source_t<RB>>;
+
+    return _impl::RangeAdaptor{[other = holder_type(std::forward<RB>(other))]<typename RA>(RA &&src) mutable {
+        return ZipView<RA, RB>(std::forward<RA>(src), std::forward<RB>(std::get<0>(other)));
+    }};
+}
+
+}
+#pragma endregion Adaptors
+
+
+#pragma region Collect
+/**
+ * Materializes a range into an Arr (an Array with any storage).
+ * Dynamic arrays are reserved up front when the range's size is known,
+ * so the whole pipeline costs at most a single allocation.
+ */
+template <typename Arr, _impl::iterable R>
+Arr collect(R &&range) {
+    Arr result{};
+
+    if constexpr (Arr::is_dynamic) {
+        if constexpr (_impl::sized_iterable<R>) {
+            result.reserve(range.size());
+        }
+
+        for (auto &&item : range) {
+            result.emplace_back(FWD(item));
+        }
+    } else {
+        size_t idx = 0;
+
+        for (auto &&item : range) {
+            if (idx >= result.size()) {
+                throw std::length_error("Too many values for a static array");
+            }
+
+            result[idx++] = FWD(item);
+        }
+    }
+
+    return result;
+}
+
+/// For use at the end of a pipeline: `arr | views::map(f) | collect<Vector<int>>()`
+template <typename Arr>
+inline auto collect() {
+    return _impl::RangeAdaptor{[]<typename R>(R &&src) {
+        return collect<Arr>(std::forward<R>(src));
+    }};
+}
+#pragma endregion Collect
+
+
+}
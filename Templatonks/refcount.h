@@ -0,0 +1,104 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <atomic>
+#include <concepts>
+
+
+namespace mylib {
+
+
+#pragma region RefCount
+/**
+ * A reference counter policy. Counters start at zero; release() reports
+ * whether the last reference was dropped, so the owner can die.
+ */
+template <typename RC>
+concept RefCountPolicy = std::default_initializable<RC> && requires (RC counter, const RC const_counter) {
+    counter.acquire();
+    { counter.release() } -> std::same_as<bool>;
+    { const_counter.is_unique() } -> std::same_as<bool>;
+};
+
+
+/// The cheap one. Only for objects that never leave their thread
+class PlainRefCount {
+public:
+    static constexpr bool is_thread_safe = false;
+
+
+    constexpr PlainRefCount() noexcept = default;
+
+    PlainRefCount(const PlainRefCount &other) = delete;
+    PlainRefCount &operator=(const PlainRefCount &other) = delete;
+
+    constexpr void acquire() noexcept {
+        ++cnt_;
+    }
+
+    constexpr bool release() noexcept {
+        assert(cnt_ > 0);
+
+        return --cnt_ == 0;
+    }
+
+    constexpr bool is_unique() const noexcept {
+        return cnt_ == 1;
+    }
+
+protected:
+    unsigned cnt_{0};
+
+};
+
+
+/**
+ * Lets the owners be copied and destroyed on different threads.
+ * Same orderings as std::shared_ptr: new references can only be made
+ * from existing ones, so acquiring is relaxed, while the final release
+ * must see every write made through the other references.
+ */
+class AtomicRefCount {
+public:
+    static constexpr bool is_thread_safe = true;
+
+
+    constexpr AtomicRefCount() noexcept = default;
+
+    AtomicRefCount(const AtomicRefCount &other) = delete;
+    AtomicRefCount &operator=(const AtomicRefCount &other) = delete;
+
+    inline void acquire() noexcept {
+        cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline bool release() noexcept {
+        unsigned prev = cnt_.fetch_sub(1, std::memory_order_release);
+        assert(prev > 0);
+
+        if (prev == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /// If true, no other thread may hold a reference, so writing is safe
+    inline bool is_unique() const noexcept {
+        return cnt_.load(std::memory_order_acquire) == 1;
+    }
+
+protected:
+    std::atomic<unsigned> cnt_{0};
+
+};
+
+
+static_assert(RefCountPolicy<PlainRefCount>);
+static_assert(RefCountPolicy<AtomicRefCount>);
+#pragma endregion RefCount
+
+
+}
@@ -0,0 +1,548 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <ACL/type_traits.h>
+#include <algorithm>
+#include <concepts>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include "refcount.h"
+#include "string.h"
+
+
+namespace mylib {
+
+
+#pragma region RopeNode
+namespace _impl {
+
+template <typename String_, RefCountPolicy RefCount>
+class RopeNodePtr;
+
+/**
+ * Immutable once built, so any number of ropes may share it.
+ * A leaf holds a chunk (which is itself a view, a shared source window,
+ * or a small string); an inner node concatenates its two children.
+ */
+template <typename String_, RefCountPolicy RefCount>
+class RopeNode {
+public:
+    using string_type = String_;
+    using size_type = typename string_type::size_type;
+    using ptr_type = RopeNodePtr<String_, RefCount>;
+
+    friend class RopeNodePtr<String_, RefCount>;
+
+
+    /// Empty chunks aren't stored, so expects chunk to be non-empty
+    static ptr_type leaf(string_type &&chunk) {
+        assert(!chunk.empty());
+
+        RopeNode *node = new RopeNode();
+
+        // Moves an owned buffer into a shared source, so that
+        // substrings of this leaf become windows rather than copies
+        node->chunk = chunk.share();
+        node->size = node->chunk.size();
+
+        return ptr_type(node);
+    }
+
+    static ptr_type concat(ptr_type left, ptr_type right) {
+        assert(left && right);
+
+        RopeNode *node = new RopeNode();
+
+        node->size = left->size + right->size;
+        node->height = (unsigned char)(std::max(left->height, right->height) + 1);
+        node->left = std::move(left);
+        node->right = std::move(right);
+
+        return ptr_type(node);
+    }
+
+    constexpr bool is_leaf() const {
+        return height == 0;
+    }
+
+    string_type chunk{};
+    ptr_type left{};
+    ptr_type right{};
+    size_type size{0};
+    unsigned char height{0};
+
+protected:
+    RefCount ref_cnt{};
+
+
+    RopeNode() = default;
+
+};
+
+
+template <typename String_, RefCountPolicy RefCount>
+class RopeNodePtr {
+public:
+    using node_type = RopeNode<String_, RefCount>;
+
+    friend class RopeNode<String_, RefCount>;
+
+
+    constexpr RopeNodePtr() noexcept : node{nullptr} {}
+
+    RopeNodePtr(const RopeNodePtr &other) noexcept : node{other.node} {
+        if (node) {
+            node->ref_cnt.acquire();
+        }
+    }
+
+    RopeNodePtr &operator=(const RopeNodePtr &other) noexcept {
+        RopeNodePtr tmp{other};
+        std::swap(node, tmp.node);
+
+        return *this;
+    }
+
+    constexpr RopeNodePtr(RopeNodePtr &&other) noexcept : node{other.node} {
+        other.node = nullptr;
+    }
+
+    constexpr RopeNodePtr &operator=(RopeNodePtr &&other) noexcept {
+        std::swap(node, other.node);
+
+        return *this;
+    }
+
+    inline ~RopeNodePtr() {
+        if (node && node->ref_cnt.release()) {
+            delete node;
+        }
+
+        node = nullptr;
+    }
+
+    inline const node_type &operator*() const {
+        assert(node);
+
+        return *node;
+    }
+
+    inline const node_type *operator->() const {
+        return &**this;
+    }
+
+    constexpr explicit operator bool() const {
+        return node;
+    }
+
+protected:
+    node_type *node;
+
+
+    inline explicit RopeNodePtr(node_type *node_) :
+        node{node_} {
+
+        assert(node);
+        node->ref_cnt.acquire();
+    }
+
+};
+
+}
+#pragma endregion RopeNode
+
+
+#pragma region Rope
+/**
+ * A string for building large texts piece by piece. Chunks are kept in
+ * an AVL-balanced tree of shared immutable nodes, so concatenation, substr
+ * and indexing take O(log n), and copying a rope is O(1).
+ * Short appends are gathered in a tail buffer first, so that appending
+ * character by character doesn't produce a leaf per character.
+ * Chunks are never copied into the tree: owned Strings become shared
+ * sources, and views stay views (so their lifetime is still the caller's concern).
+ */
+template <typename Allocator = std::allocator<char>, RefCountPolicy RefCount = PlainRefCount>
+class Rope {
+public:
+    using string_type = String<Allocator, RefCount>;
+    using value_type = typename string_type::value_type;
+    using size_type = typename string_type::size_type;
+    using difference_type = typename string_type::difference_type;
+
+    static constexpr size_type npos = string_type::npos;
+
+    /// Appends shorter than this are copied into the tail, which becomes a leaf once full
+    static constexpr size_type leaf_size = 4096;
+
+    #pragma region Protected
+protected:
+    using node_type = _impl::RopeNode<string_type, RefCount>;
+    using node_ptr = typename node_type::ptr_type;
+
+public:
+    #pragma endregion Protected
+
+
+    Rope() = default;
+
+    /// Lvalue Strings are shared lazily, as with String's non-const copy constructor
+    Rope(string_type str) {
+        append(std::move(str));
+    }
+
+    explicit Rope(std::string_view str) {
+        append(str);
+    }
+
+    Rope(const value_type *str) :
+        Rope(std::string_view(str)) {}
+
+    #pragma region Size
+    inline size_type size() const {
+        return _root_size() + tail_.size();
+    }
+
+    inline size_type length() const {
+        return size();
+    }
+
+    inline bool empty() const {
+        return size() == 0;
+    }
+
+    /// Of the chunk tree, mostly for diagnostics
+    inline unsigned height() const {
+        return root_ ? root_->height : 0;
+    }
+    #pragma endregion Size
+
+    #pragma region Access
+    /// O(log n), so iterate with for_each_chunk instead where possible
+    value_type operator[](size_type idx) const {
+        assert(idx < size());
+
+        if (idx >= _root_size()) {
+            return tail_.data()[idx - _root_size()];
+        }
+
+        const node_type *node = &*root_;
+
+        while (!node->is_leaf()) {
+            if (idx < node->left->size) {
+                node = &*node->left;
+            } else {
+                idx -= node->left->size;
+                node = &*node->right;
+            }
+        }
+
+        return node->chunk.data()[idx];
+    }
+
+    value_type at(size_type idx) const {
+        if (idx >= size()) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        return (*this)[idx];
+    }
+
+    /// Calls func with each chunk, in order, as a std::string_view
+    template <typename F>
+    void for_each_chunk(F &&func) const {
+        if (root_) {
+            _for_each_chunk(*root_, func);
+        }
+
+        if (!tail_.empty()) {
+            func((std::string_view)tail_);
+        }
+    }
+
+    /// A contiguous copy, allocated once
+    string_type flatten() const {
+        string_type result{};
+        result.reserve(size() + 1);
+
+        for_each_chunk([&result](std::string_view chunk) {
+            result.append(chunk);
+        });
+
+        return result;
+    }
+
+    explicit operator string_type() const {
+        return flatten();
+    }
+    #pragma endregion Access
+
+    #pragma region Modification
+    Rope &append(string_type str) {
+        if (str.size() < leaf_size) {
+            return append((std::string_view)str);
+        }
+
+        _seal_tail();
+        _append_node(node_type::leaf(std::move(str)));
+
+        return *this;
+    }
+
+    Rope &append(std::string_view str) {
+        if (str.empty()) {
+            return *this;
+        }
+
+        if (tail_.size() + str.size() > leaf_size) {
+            _seal_tail();
+        }
+
+        if (str.size() >= leaf_size) {
+            _append_node(node_type::leaf(string_type(str)));
+
+            return *this;
+        }
+
+        if (tail_.capacity() < leaf_size) {
+            tail_.reserve(leaf_size + 1);
+        }
+
+        tail_.append(str);
+
+        return *this;
+    }
+
+    inline Rope &append(const value_type *str) {
+        return append(std::string_view(str));
+    }
+
+    inline Rope &append(value_type chr) {
+        return append(std::string_view(&chr, 1));
+    }
+
+    Rope &append(const Rope &other) {
+        if (&other == this) {
+            Rope copy = other;
+
+            return append(copy);
+        }
+
+        if (other.root_) {
+            _seal_tail();
+            _append_node(other.root_);
+        }
+
+        return append((std::string_view)other.tail_);
+    }
+
+    template <typename T>
+    inline Rope &operator+=(T &&arg) {
+        return append(std::forward<T>(arg));
+    }
+
+    template <typename T>
+    friend Rope operator+(Rope rope, T &&arg) {
+        rope.append(std::forward<T>(arg));
+
+        return rope;
+    }
+
+    void clear() {
+        root_ = node_ptr{};
+        tail_.clear();
+    }
+
+    void swap(Rope &other) {
+        std::swap(root_, other.root_);
+        std::swap(tail_, other.tail_);
+    }
+    #pragma endregion Modification
+
+    #pragma region Substrings
+    /// Shares the chunks with this rope, apart from the (short) part of the tail
+    Rope substr(size_type pos, size_type count = npos) const {
+        if (pos > size()) {
+            throw std::out_of_range("Starting pos out of rope range");
+        }
+
+        count = std::min(count, size() - pos);
+
+        Rope result{};
+        const size_type root_size = _root_size();
+
+        if (pos < root_size) {
+            result.root_ = _slice(root_, pos, std::min(pos + count, root_size));
+        }
+
+        if (pos + count > root_size) {
+            size_type from = std::max(pos, root_size) - root_size;
+
+            result.append(((std::string_view)tail_).substr(from, pos + count - root_size - from));
+        }
+
+        return result;
+    }
+    #pragma endregion Substrings
+
+protected:
+    node_ptr root_{};
+    // Owned, unlike the chunks in the tree
+    string_type tail_{};
+
+
+    #pragma region Tree helpers
+    inline size_type _root_size() const {
+        return root_ ? root_->size : 0;
+    }
+
+    void _seal_tail() {
+        if (tail_.empty()) {
+            return;
+        }
+
+        // A tail sealed early, e.g. before a long append, would otherwise
+        // keep its whole leaf-sized buffer for as long as the leaf lives
+        if (tail_.capacity() - tail_.size() > leaf_size / 8) {
+            tail_.shrink_to_fit();
+        }
+
+        _append_node(node_type::leaf(std::move(tail_)));
+        tail_ = string_type{};
+    }
+
+    void _append_node(node_ptr node) {
+        root_ = _join(std::move(root_), std::move(node));
+    }
+
+    template <typename F>
+    static void _for_each_chunk(const node_type &node, F &func) {
+        if (node.is_leaf()) {
+            func((std::string_view)node.chunk);
+            return;
+        }
+
+        _for_each_chunk(*node.left, func);
+        _for_each_chunk(*node.right, func);
+    }
+
+    static inline unsigned _height(const node_ptr &node) {
+        return node->height;
+    }
+
+    static node_ptr _rotate_left(const node_ptr &node) {
+        const node_ptr &right = node->right;
+
+        return node_type::concat(node_type::concat(node->left, right->left), right->right);
+    }
+
+    static node_ptr _rotate_right(const node_ptr &node) {
+        const node_ptr &left = node->left;
+
+        return node_type::concat(left->left, node_type::concat(left->right, node->right));
+    }
+
+    /**
+     * AVL join: descends along the taller tree's inner spine to a subtree of
+     * about the shorter one's height, and rotates on the way back.
+     * Takes O(|height(left) - height(right)| + 1)
+     */
+    static node_ptr _join(node_ptr left, node_ptr right) {
+        if (!left) {
+            return right;
+        }
+
+        if (!right) {
+            return left;
+        }
+
+        if (_height(left) > _height(right) + 1) {
+            return _join_right(left, std::move(right));
+        }
+
+        if (_height(right) > _height(left) + 1) {
+            return _join_left(std::move(left), right);
+        }
+
+        return node_type::concat(std::move(left), std::move(right));
+    }
+
+    static node_ptr _join_right(const node_ptr &left, node_ptr right) {
+        const node_ptr &outer = left->left;
+        const node_ptr &inner = left->right;
+
+        if (_height(inner) <= _height(right) + 1) {
+            node_ptr joined = node_type::concat(inner, std::move(right));
+
+            if (_height(joined) <= _height(outer) + 1) {
+                return node_type::concat(outer, std::move(joined));
+            }
+
+            return _rotate_left(node_type::concat(outer, _rotate_right(joined)));
+        }
+
+        node_ptr joined = _join_right(inner, std::move(right));
+        bool balanced = _height(joined) <= _height(outer) + 1;
+        node_ptr result = node_type::concat(outer, std::move(joined));
+
+        return balanced ? result : _rotate_left(result);
+    }
+
+    static node_ptr _join_left(node_ptr left, const node_ptr &right) {
+        const node_ptr &outer = right->right;
+        const node_ptr &inner = right->left;
+
+        if (_height(inner) <= _height(left) + 1) {
+            node_ptr joined = node_type::concat(std::move(left), inner);
+
+            if (_height(joined) <= _height(outer) + 1) {
+                return node_type::concat(std::move(joined), outer);
+            }
+
+            return _rotate_right(node_type::concat(_rotate_left(joined), outer));
+        }
+
+        node_ptr joined = _join_left(std::move(left), inner);
+        bool balanced = _height(joined) <= _height(outer) + 1;
+        node_ptr result = node_type::concat(std::move(joined), outer);
+
+        return balanced ? result : _rotate_right(result);
+    }
+
+    /// The part of the node's contents in [from, to), reusing whole subtrees where possible
+    static node_ptr _slice(const node_ptr &node, size_type from, size_type to) {
+        assert(from <= to && to <= node->size);
+
+        if (from == to) {
+            return node_ptr{};
+        }
+
+        if (from == 0 && to == node->size) {
+            return node;
+        }
+
+        if (node->is_leaf()) {
+            // A view or a window onto the same source, so no copying either way
+            return node_type::leaf(node->chunk.substr(from, to - from));
+        }
+
+        const size_type mid = node->left->size;
+
+        if (to <= mid) {
+            return _slice(node->left, from, to);
+        }
+
+        if (from >= mid) {
+            return _slice(node->right, from - mid, to - mid);
+        }
+
+        return _join(_slice(node->left, from, mid), _slice(node->right, 0, to - mid));
+    }
+    #pragma endregion Tree helpers
+
+};
+#pragma endregion Rope
+
+
+}
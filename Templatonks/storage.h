@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <initializer_list>
 #include <optional>
+#include <memory>
+#include <cstring>
 #include <new>
 
 
@@ -25,6 +27,7 @@ concept Storage = ((requires (std::remove_cvref_t<St> storage,
     { const_storage.size() } -> std::unsigned_integral;
     { St::is_dynamic } -> std::convertible_to<bool>;
     { St::provides_iterators } -> std::convertible_to<bool>;
+    { St::is_contiguous } -> std::convertible_to<bool>;
 }) && (!St::is_dynamic ||
        requires (std::remove_cvref_t<St> storage,
                  const std::remove_cvref_t<St> const_storage,
@@ -59,6 +62,17 @@ concept Storage = ((requires (std::remove_cvref_t<St> storage,
     { const_storage.end() } -> std::sentinel_for<typename St::const_iterator>;
 
     // Maybe something else?
+}) && (!St::is_contiguous ||
+       requires (      std::remove_cvref_t<St> storage,
+                 const std::remove_cvref_t<St> const_storage) {
+    // Contiguous requirements
+    // (Elements [0, size()) are laid out as a plain array starting at data())
+    requires St::provides_iterators;
+    requires std::contiguous_iterator<typename St::iterator> &&
+             std::contiguous_iterator<typename St::const_iterator>;
+
+    { storage.data() } -> std::same_as<T *>;
+    { const_storage.data() } -> std::same_as<const T *>;
 }));
 #pragma endregion Storage concept
 
@@ -89,6 +103,7 @@ protected:
 public:
     static constexpr bool is_dynamic = true;
     static constexpr bool provides_iterators = true;
+    static constexpr bool is_contiguous = true;
 
     using iterator = T *;
     using const_iterator = const T *;
@@ -112,9 +127,15 @@ public:
 
         ensure_capacity(new_size);
 
-        for (size_t i = 0; i < new_size; ++i) {
-            new (&data_[i]) T(val);
-            ++size_;
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            // Becomes a memset or a vectorized store loop
+            std::uninitialized_fill_n(data_, new_size, val);
+            size_ = new_size;
+        } else {
+            for (size_t i = 0; i < new_size; ++i) {
+                new (&data_[i]) T(val);
+                ++size_;
+            }
         }
     }
 
@@ -129,11 +150,9 @@ public:
     DynamicLinearStorage(const DynamicLinearStorage &other) {
         static_assert(std::is_copy_constructible_v<T>);
 
-        ensure_capacity(other.capacity_);
+        ensure_capacity(other.size_);
 
-        for (; size < other.size; ++size) {
-            new (&data_[size]) T(other.data_[size]);
-        }
+        copy_from(other);
     }
 
     DynamicLinearStorage &operator=(const DynamicLinearStorage &other) noexcept {
@@ -145,11 +164,9 @@ public:
         // TODO: Could be optimized, but who cares, really...
         clear();
 
-        ensure_capacity(other.capacity_);
+        ensure_capacity(other.size_);
 
-        for (; size < other.size; ++size) {
-            new (&data_[size]) T(other.data_[size]);
-        }
+        copy_from(other);
 
         return *this;
     }
@@ -193,6 +210,9 @@ public:
     inline       iterator end()       { return data_ + size(); }
     inline const_iterator end() const { return data_ + size(); }
 
+    inline       T *data()       { return data_; }
+    inline const T *data() const { return data_; }
+
 
     T *expand_one() {
         ensure_capacity(size_ + 1);
@@ -221,6 +241,10 @@ public:
         return size_;
     }
 
+    inline void reserve(size_t capacity) {
+        ensure_capacity(capacity);
+    }
+
 protected:
     T *data_ = nullptr;
     size_t size_ = 0;
@@ -242,7 +266,7 @@ protected:
             return;
         }
 
-        if (desired < capacity_) {
+        if (desired <= capacity_) {
             return;
         }
 
@@ -255,6 +279,16 @@ protected:
 
         assert(new_capacity >= size_);
 
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::memcpy(new_data, data_, size_ * sizeof(T));
+
+            ::operator delete[](data_);
+            data_ = new_data;
+            capacity_ = new_capacity;
+
+            return;
+        }
+
         for (size_t i = 0; i < size_; ++i) {
             try {
                 new (&new_data[i]) T(std::move(data_[i]));
@@ -283,6 +317,24 @@ protected:
         capacity_ = new_capacity;
     }
 
+    /// Expects an empty storage with enough capacity
+    void copy_from(const DynamicLinearStorage &other) {
+        assert(size_ == 0);
+        assert(other.size_ == 0 || capacity_ >= other.size_);
+
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (other.size_ > 0) {
+                std::memcpy(data_, other.data_, other.size_ * sizeof(T));
+            }
+
+            size_ = other.size_;
+        } else {
+            for (; size_ < other.size_; ++size_) {
+                new (&data_[size_]) T(other.data_[size_]);
+            }
+        }
+    }
+
 };
 #pragma endregion DynamicLinearStorage
 
@@ -293,6 +345,7 @@ class StaticLinearStorage {
 public:
     static constexpr bool is_dynamic = false;
     static constexpr bool provides_iterators = true;
+    static constexpr bool is_contiguous = true;
 
     using iterator = T *;
     using const_iterator = const T *;
@@ -358,6 +411,9 @@ public:
     inline       iterator end()       { return data_ + size(); }
     inline const_iterator end() const { return data_ + size(); }
 
+    inline       T *data()       { return data_; }
+    inline const T *data() const { return data_; }
+
 protected:
     T data_[Size];
 
@@ -372,7 +428,8 @@ struct StaticLinearStorageAdapter {
 
 
 #pragma region DynamicChunkedStorage
-// IMPORTANT: Should always maintain at least one chunk, okay if empty
+// IMPORTANT: The last chunk is okay if empty. No chunks at all is empty too,
+//            so that neither construction, moves nor clear() have to allocate
 template <typename T, size_t ChunkSize>
 class DynamicChunkedStorage {
     #pragma region Protected stuff
@@ -390,10 +447,11 @@ class DynamicChunkedStorage {
 public:
     static constexpr bool is_dynamic = true;
     static constexpr bool provides_iterators = false;
+    static constexpr bool is_contiguous = false;
 
 
     DynamicChunkedStorage() :
-        chunks_(1), last_size_{0}, default_item_{} {}
+        chunks_{}, last_size_{0}, default_item_{} {}
 
     DynamicChunkedStorage(size_t new_size) :
         chunks_(new_size / chunk_size + 1),
@@ -424,8 +482,8 @@ public:
 
         static_assert(std::is_copy_constructible_v<T>);
 
-        while (size < other.size) {
-            new (expand_one()) T(other.item(size));
+        for (size_t i = 0, sz = other.size(); i < sz; ++i) {
+            new (expand_one()) T(other.item(i));
         }
     }
 
@@ -438,8 +496,8 @@ public:
         // TODO: Could be optimized, but who cares, really...
         clear();
 
-        while (size < other.size) {
-            new (expand_one()) T(other.item(size));
+        for (size_t i = 0, sz = other.size(); i < sz; ++i) {
+            new (expand_one()) T(other.item(i));
         }
 
         return *this;
@@ -449,6 +507,7 @@ public:
         chunks_{std::move(other.chunks_)}, last_size_{other.last_size_},
         default_item_{std::move(other.default_item_)} {
 
+        // Left without chunks, which is empty
         other.last_size_ = 0;
     }
 
@@ -480,6 +539,10 @@ public:
     }
 
     T *expand_one() {
+        if (chunks_.size() == 0) {
+            *chunks_.expand_one() = nullptr;
+        }
+
         ++last_size_;
 
         if (last_size_ == chunk_size) {
@@ -513,18 +576,20 @@ public:
     }
 
     void clear() noexcept {
-        for (unsigned i = 0; i < chunks_.size() - 1; ++i) {
+        // The last chunk included, or it leaks
+        for (size_t i = 0; i < chunks_.size(); ++i) {
             clear_chunk(i);
         }
 
         chunks_.clear();
-        *chunks_.expand_one() = nullptr;
         last_size_ = 0;
         default_item_.reset();
     }
 
     inline size_t size() const {
-        assert(chunks_.size() > 0);
+        if (chunks_.size() == 0) {
+            return 0;
+        }
 
         return (chunks_.size() - 1) * chunk_size + last_size_;
     }
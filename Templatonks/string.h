@@ -5,26 +5,54 @@
 #include <ACL/type_traits.h>
 #include <concepts>
 #include <memory>
+#include <cstddef>
 #include <cstring>
 #include <string>  // For interoperability
 #include <string_view>
 #include <initializer_list>
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <climits>
 #include <new>
+#include <stdexcept>
+#include <atomic>
+#include <charconv>
+#include <format>
+#include "refcount.h"
+#include "string_search.h"
+#include "hash.h"
 
 
 #define HEAVY_NULLTERM_CHECK_ 0
 
+// MSVC ignores the standard spelling for ABI compatibility
+#ifdef _MSC_VER
+#define NO_UNIQUE_ADDRESS_ [[msvc::no_unique_address]]
+#else
+#define NO_UNIQUE_ADDRESS_ [[no_unique_address]]
+#endif
+
+// Constant evaluation can only read a long string's flags where the compiler
+// can tell which member of the rep union is active, which MSVC can't
+#if defined(__GNUC__) || defined(__clang__)
+#define STRING_CONSTEXPR_FLAGS_ 1
+#else
+#define STRING_CONSTEXPR_FLAGS_ 0
+#endif
+
 
 namespace mylib {
 
 
 namespace _impl {
 
-template <typename Allocator>
+template <typename Allocator, RefCountPolicy RefCount>
 class SharedLazySourcePtr;
 
+template <typename Allocator, RefCountPolicy RefCount>
+class ExternalLazySource;
+
 template <typename T, typename CharT>
 concept string_view_like =
     std::convertible_to<T, std::basic_string_view<CharT>> &&
@@ -33,15 +61,163 @@ concept string_view_like =
 static_assert(string_view_like<std::string_view, char>);
 static_assert(!string_view_like<const char *, char>);
 
+/**
+ * Mirrors the start of String's small representation, to tell where its characters
+ * begin: right after the flags' byte, unless bit-fields keep the whole word to
+ * themselves, as they do with MSVC
+ */
+template <typename CharT>
+struct SmallStringHead {
+    size_t flags : CHAR_BIT;
+    CharT contents;
+};
+
+/// A multi-byte delimiter, with the same interface as search::ByteScanner. Keeps a copy of it
+class SubstrFinder {
+public:
+    SubstrFinder(const char *hay, size_t n, const char *delim, size_t count) :
+        hay_{hay}, n_{n}, delim_(delim, count) {}
+
+    size_t next(size_t pos) const {
+        size_t found = search::find(hay_ + pos, n_ - pos, delim_.data(), delim_.size());
+
+        return found == search::npos ? search::npos : pos + found;
+    }
+
+protected:
+    const char *hay_;
+    size_t n_;
+    std::string delim_;
+
+};
+
 }
 
 
-template <typename Allocator = std::allocator<char>>
+#pragma region SplitView
+/**
+ * A lazy range over the fields of a string, each yielded as a String::view, so
+ * iterating never allocates. Like any view, it must not outlive the string it
+ * splits, and the string mustn't be modified meanwhile. Iterators carry their own
+ * copy of the finder, though, so they may outlive the view.
+ * Finder locates the delimiters (_impl::search::CharScanner for a single byte,
+ * _impl::search::ByteScanner for sets of them, _impl::SubstrFinder for multi-byte
+ * ones). With Lines, a trailing '\r' is stripped off every field, and a delimiter
+ * at the very end doesn't start one more, empty, field.
+ */
+template <typename Str, typename Finder, bool Lines = false>
+class SplitView {
+public:
+    struct Sentinel {};
+
+    class Iterator {
+    public:
+        using value_type = Str;
+        using reference = Str;
+        using difference_type = ptrdiff_t;
+
+        Iterator(const Finder &finder, const char *data, size_t size, size_t delim_size) :
+            finder_{finder}, data_{data}, size_{size}, delim_size_{delim_size} {
+
+            if (Lines && size_ == 0) {
+                done_ = true;
+                return;
+            }
+
+            _find_end();
+        }
+
+        inline reference operator*() const {
+            size_t end = end_;
+
+            if constexpr (Lines) {
+                if (end > start_ && data_[end - 1] == '\r') {
+                    --end;
+                }
+            }
+
+            return Str::view(data_ + start_, end - start_);
+        }
+
+        inline Iterator &operator++() {
+            if (end_ == size_) {
+                done_ = true;
+                return *this;
+            }
+
+            start_ = end_ + delim_size_;
+
+            if (Lines && start_ == size_) {
+                done_ = true;
+                return *this;
+            }
+
+            _find_end();
+
+            return *this;
+        }
+
+        inline Iterator operator++(int) {
+            Iterator result = *this;
+            ++*this;
+
+            return result;
+        }
+
+        inline bool operator==(const Sentinel &) const {
+            return done_;
+        }
+
+    protected:
+        Finder finder_;
+        const char *data_;
+        size_t size_;
+        size_t delim_size_;
+        size_t start_ = 0;
+        size_t end_ = 0;
+        bool done_ = false;
+
+
+        void _find_end() {
+            size_t found = finder_.next(start_);
+
+            end_ = found == _impl::search::npos ? size_ : found;
+        }
+
+    };
+
+
+    SplitView(const char *data, size_t size, std::string_view delim) :
+        data_{data}, size_{size}, finder_(data, size, delim.data(), delim.size()),
+        // A scanner matches any one of its bytes, rather than all of them in a row
+        delim_size_{std::is_same_v<Finder, _impl::SubstrFinder> ? delim.size() : 1} {}
+
+    Iterator begin() const { return Iterator(finder_, data_, size_, delim_size_); }
+    Sentinel end() const { return Sentinel{}; }
+
+protected:
+    const char *data_;
+    size_t size_;
+    // Copied into every iterator, which is then independent of the delimiter's lifetime
+    Finder finder_;
+    size_t delim_size_;
+
+};
+#pragma endregion SplitView
+
+
+/**
+ * RefCount controls the sources shared between lazy copies:
+ * with AtomicRefCount, such copies may be handed to other threads
+ * (as long as each String object itself is only used by one thread at a time).
+ */
+template <typename Allocator = std::allocator<char>, RefCountPolicy RefCount = PlainRefCount>
 class String {
 public:
     #pragma region Typedefs & constants
     using value_type = char;
     using allocator_type = Allocator;
+    using refcount_type = RefCount;
     using reference = value_type &;
     using const_reference = const value_type &;
     using pointer = value_type *;
@@ -54,13 +230,18 @@ public:
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-    static constexpr size_type small_string_size = sizeof(void *) / sizeof(value_type);
+    /// Including the null terminator. Reuses the whole object, save for the flags
+    static constexpr size_type small_string_size =
+        (3 * sizeof(size_type) - offsetof(_impl::SmallStringHead<value_type>, contents)) / sizeof(value_type);
     static constexpr size_type npos = (size_type)-1;
     static constexpr value_type nullchr = value_type{0};
 
     #pragma region Protected
 protected:
-    using sls_ptr_type = _impl::SharedLazySourcePtr<Allocator>;
+    using sls_ptr_type = _impl::SharedLazySourcePtr<Allocator, RefCount>;
+
+    template <typename Allocator_, RefCountPolicy RefCount_>
+    friend class _impl::ExternalLazySource;
 
     enum class LazyState : unsigned {
         small, owned, view, shared,
@@ -72,14 +253,11 @@ public:
 
 public:
     #pragma region Constructors & such
-    String() noexcept(noexcept(allocator_type())) :
+    constexpr String() noexcept(noexcept(allocator_type())) :
         String(allocator_type()) {}
 
-    explicit String(const allocator_type &alloc) noexcept :
-        allocator_{alloc},
-        small_contents_{""},
-        capacity_{small_string_size}, size_{1},  // Including the null char
-        flags_{.lazy_state = LazyState::small} {}
+    constexpr explicit String(const allocator_type &alloc) noexcept :
+        allocator_{alloc}, rep_{} {}
 
     String(size_type count, value_type ch,
            const allocator_type &alloc = allocator_type()) noexcept :
@@ -110,16 +288,32 @@ public:
         return assign(other);
     }
 
-    String(String &&other) :
-        allocator_{std::move(other.allocator_)},
-        ptr_{nullptr},
-        capacity_{other.capacity_}, size_{other.size_},
-        flags_{std::move(other.flags_)} {
+    constexpr String(String &&other) :
+        allocator_{std::move(other.allocator_)}, rep_{} {
 
-        if (other.flags_.lazy_state == LazyState::shared) {
-            new (&sls_ptr_) sls_ptr_type(std::move(other.sls_ptr_));
-        } else {
-            std::swap(ptr_, other.ptr_);
+        switch (other._lazy_state()) {
+        case LazyState::small:
+            rep_.small = other.rep_.small;
+            break;
+
+        case LazyState::shared:
+            _copy_large_fields(other);
+            new (&rep_.large.sls_ptr) sls_ptr_type(std::move(other.rep_.large.sls_ptr));
+            break;
+
+        case LazyState::view:
+            _copy_large_fields(other);
+            rep_.large.view_ptr = other.rep_.large.view_ptr;
+            break;
+
+        case LazyState::owned:
+            _copy_large_fields(other);
+            rep_.large.ptr = other.rep_.large.ptr;
+            // So that other.clear() doesn't deallocate it
+            other._set_lazy_state(LazyState::view);
+            break;
+
+        NODEFAULT
         }
 
         other.clear();
@@ -190,8 +384,8 @@ public:
         assign(ilist);
     }
 
-    ~String() {
-        clear();
+    constexpr ~String() {
+        _release();
     }
     #pragma endregion Constructors & such
 
@@ -203,35 +397,29 @@ public:
      * If count is explicitly specified, yet the string is guaranteed (by the user) to be
      * null-terminated, the last parameter, null_terminated_promise, may be set to true.
      */
-    static String view(const value_type *str, size_type count = npos, bool null_terminated_promise = false) {
+    static constexpr String view(const value_type *str, size_type count = npos, bool null_terminated_promise = false) {
         assert(str);
 
-        String result{};
-        assert(result.flags_.lazy_state == LazyState::small);
-
-        result.flags_.lazy_state = LazyState::view;
-        result.flags_.is_null_terminated = false;
+        bool null_terminated = false;
 
         if (count == npos) {
-            count = strlen(str);
+            count = std::char_traits<value_type>::length(str);
 
-            result.flags_.is_null_terminated = true;
+            null_terminated = true;
         } else if (null_terminated_promise) {
             if (str[count] != nullchr) {
                 throw std::logic_error("Null terminator was promised, but is not present");
             }
 
-            result.flags_.is_null_terminated = true;
+            null_terminated = true;
         }
 
-        if (result.flags_.is_null_terminated) {
-            // Include the null terminator
-            ++count;
-        }
-
-        result.view_ptr_ = str;
-        result.size_ = count;
-        result.capacity_ = count;
+        // Splitting makes lots of these, so the fields are set directly
+        String result(LazyState::view, allocator_type());
+        result.rep_.large.is_null_terminated = null_terminated;
+        // Including the null terminator
+        result.rep_.large.size = count + (size_type)null_terminated;
+        result.rep_.large.view_ptr = str;
 
         return result;
     }
@@ -266,9 +454,10 @@ public:
      * If the other string is already copy-on-write, this one simply gets another reference
      * to its source.
      * If the other string is a view, shares its contents directly.
+     * Small strings are copied instead, since sharing would take an allocation.
      */
     static String view(String &other) {
-        if (other.flags_.lazy_state == LazyState::view) {
+        if (other._lazy_state() == LazyState::view) {
             return view(other.as_const());
         }
 
@@ -280,12 +469,12 @@ public:
      * If the other string is a view, shares its contents. Otherwise, fails.
      */
     static String view(const String &other) {
-        if (other.flags_.lazy_state != LazyState::view) {
+        if (other._lazy_state() != LazyState::view) {
             throw std::logic_error("Requested to perform a view-copy from a non-view");
         }
 
         String result(other);
-        assert(result.flags_.lazy_state == LazyState::view);
+        assert(result._lazy_state() == LazyState::view);
 
         return result;
     }
@@ -295,8 +484,8 @@ public:
     String &assign(size_type count, value_type chr) {
         ensure_total_capacity(count + 1);
 
-        *std::fill(begin(), begin() + count, chr) = nullchr;
-        size_ = count + 1;
+        *std::fill_n(begin(), count, chr) = nullchr;
+        _set_size(count + 1);
 
         return *this;
     }
@@ -307,13 +496,11 @@ public:
         }
 
         #if 0
-        if (other.flags_.lazy_state == LazyState::view) {
+        if (other._lazy_state() == LazyState::view) {
             clear();
 
-            view_ptr_ = other.view_ptr_;
-            size_ = other.size_;
-            capacity_ = other.capacity_;
-            flags_ = other.flags_;
+            rep_.large.view_ptr = other.rep_.large.view_ptr;
+            _copy_large_fields(other);
 
             return *this;
         }
@@ -328,7 +515,7 @@ public:
         }
 
         #if 0
-        if (other.flags_.lazy_state == LazyState::view) {
+        if (other._lazy_state() == LazyState::view) {
             return assign(other.as_const());
         }
         #endif
@@ -374,7 +561,7 @@ public:
         ensure_total_capacity(count + 1);
 
         *std::copy(first, last, begin()) = nullchr;
-        size_ = count + 1;
+        _set_size(count + 1);
 
         return *this;
     }
@@ -383,7 +570,7 @@ public:
     String &assign(InputIt first, InputIt last) {
         ensure_ownership();
 
-        size_ = 0;
+        _set_size(0);
 
         for (; first != last; ++first) {
             push_back(*first);
@@ -408,34 +595,16 @@ public:
         return assign(sv.data() + pos, std::min(sv.size(), count));
     }
 
-    void clear() {
-        switch (flags_.lazy_state) {
-        case LazyState::small:
-        case LazyState::view:
-            break;
-
-        case LazyState::shared:
-            sls_ptr_.~sls_ptr_type();
-            break;
-
-        case LazyState::owned:
-            allocator_.deallocate(ptr_, capacity());
-            break;
+    constexpr void clear() {
+        _release();
 
-        NODEFAULT
-        }
-
-        // Equivalent to setting small_contents to an empty string
-        ptr_ = nullptr;
-        size_ = 0;
-        capacity_ = small_string_size;
-        flags_ = {.lazy_state = LazyState::small};
+        std::construct_at(&rep_.small);
     }
     #pragma endregion Assign & clear
 
     #pragma region Size-related info
     constexpr size_type size() const {
-        return size_with_null() - (difference_type)flags_.is_null_terminated;
+        return size_with_null() - (difference_type)is_null_terminated();
     }
 
     constexpr size_type length() const {
@@ -443,11 +612,28 @@ public:
     }
 
     constexpr size_type size_with_null() const {
-        return size_;
+        if (_is_large()) {
+            return rep_.large.size;
+        }
+
+        return rep_.small.size;
     }
 
     constexpr size_type capacity() const {
-        return capacity_;
+        switch (_lazy_state()) {
+        case LazyState::small:
+            return small_string_size;
+
+        case LazyState::owned:
+            return rep_.large.capacity_or_offset;
+
+        case LazyState::view:
+        case LazyState::shared:
+            // The source isn't ours to grow
+            return size_with_null();
+
+        NODEFAULT
+        }
     }
 
     constexpr bool empty() const {
@@ -484,13 +670,13 @@ public:
 
     const value_type *c_str() const {
         #if HEAVY_NULLTERM_CHECK_
-        if (!flags_.is_null_terminated) {
-            assert(flags_.lazy_state == LazyState::view);
+        if (!is_null_terminated()) {
+            assert(_lazy_state() == LazyState::view);
 
             throw std::runtime_error("The view is not null-terminated");
         }
         #else
-        assert(flags_.is_null_terminated);
+        assert(is_null_terminated());
         #endif
 
         return data();
@@ -498,13 +684,13 @@ public:
 
     value_type *mutable_c_str() {
         #if HEAVY_NULLTERM_CHECK_
-        if (!flags_.is_null_terminated) {
-            assert(flags_.lazy_state == LazyState::view);
+        if (!is_null_terminated()) {
+            assert(_lazy_state() == LazyState::view);
 
             throw std::runtime_error("The view is not null-terminated");
         }
         #else
-        assert(flags_.is_null_terminated);
+        assert(is_null_terminated());
         #endif
 
         return mutable_data();
@@ -643,9 +829,10 @@ public:
         ensure_total_capacity(count + 1);
 
         if (count > size()) {
-            *std::fill(end(), begin() + count, chr) = nullchr;
+            std::fill(end(), begin() + count, chr);
         }
-        size_ = count + 1;
+        begin()[count] = nullchr;
+        _set_size(count + 1);
     }
     #pragma endregion Capacity & size manipulation
 
@@ -664,11 +851,69 @@ public:
     }
 
     constexpr bool is_owning() const {
-        return flags_.lazy_state <= LazyState::owned;
+        return _lazy_state() <= LazyState::owned;
     }
 
     constexpr bool is_null_terminated() const {
-        return flags_.is_null_terminated;
+        return _is_large() ? rep_.large.is_null_terminated : rep_.small.is_null_terminated;
+    }
+
+    /**
+     * Never copies the characters of a view or a shared string: the result is a view
+     * or a window onto the same shared source, respectively. Like views, windows
+     * that end before their source does aren't null-terminated.
+     * Owned strings are copied, since sharing them would require modifying this one;
+     * see share() for that.
+     */
+    String substr(size_type pos = 0, size_type count = npos) const {
+        if (pos > size()) {
+            throw std::out_of_range("Starting pos out of string range");
+        }
+
+        count = std::min(count, size() - pos);
+
+        switch (_lazy_state()) {
+        case LazyState::view:
+            return view(data() + pos, count, is_null_terminated() && pos + count == size());
+
+        case LazyState::shared:
+            return _shared_window(pos, count);
+
+        case LazyState::small:
+        case LazyState::owned:
+            return String(data() + pos, count, get_allocator());
+
+        NODEFAULT
+        }
+    }
+
+    /**
+     * The zero-copy substr. Like the non-const copy constructor, moves an owned
+     * string's buffer into a shared source, so that this and every later substring
+     * are windows onto it. After the first call, slicing is allocation-free.
+     * Substrings short enough for the small-string buffer are still copied.
+     */
+    String share(size_type pos = 0, size_type count = npos) {
+        if (pos > size()) {
+            throw std::out_of_range("Starting pos out of string range");
+        }
+
+        count = std::min(count, size() - pos);
+
+        if (_lazy_state() == LazyState::owned && count >= small_string_size) {
+            _make_shared();
+        }
+
+        return as_const().substr(pos, count);
+    }
+
+    /// Python-style: negative indices count from the end, and the range is clamped to the string
+    String slice(difference_type from,
+                 difference_type to = std::numeric_limits<difference_type>::max()) const {
+        size_type first = _clamp_idx(from);
+        size_type last = std::max(first, _clamp_idx(to));
+
+        return substr(first, last - first);
     }
     #pragma endregion View-oriented
 
@@ -679,7 +924,7 @@ public:
 
         size_type sz = size();
 
-        ++size_;
+        _set_size(size_with_null() + 1);
 
         at(sz) = chr;
         at(sz + 1) = nullchr;
@@ -692,7 +937,7 @@ public:
 
         value_type result = std::exchange(at(-1), nullchr);
 
-        --size_;
+        _set_size(size_with_null() - 1);
 
         return result;
     }
@@ -702,8 +947,8 @@ public:
     String &append(size_type count, value_type chr) {
         ensure_extra_capacity(count);
 
-        *std::fill(end(), end() + count, chr) = nullchr;
-        size_ += count;
+        *std::fill_n(end(), count, chr) = nullchr;
+        _set_size(size_with_null() + count);
 
         return *this;
     }
@@ -741,7 +986,7 @@ public:
         ensure_extra_capacity(count);
 
         *std::copy(first, last, begin() + size()) = nullchr;
-        size_ += count;
+        _set_size(size_with_null() + count);
 
         return *this;
     }
@@ -774,6 +1019,64 @@ public:
     }
     #pragma endregion Append
 
+    #pragma region Numbers & formatting
+    /// Writes straight into the buffer, with no temporary strings
+    template <std::integral T>
+    requires (!std::same_as<T, bool>)
+    String &append_int(T value, int base = 10) {
+        // Even base 2 fits, sign included
+        return _append_chars(sizeof(T) * CHAR_BIT + 1, [value, base](value_type *first, value_type *last) {
+            return std::to_chars(first, last, value, base);
+        });
+    }
+
+    /// The shortest representation that reads back as the same value
+    template <std::floating_point T>
+    String &append_float(T value) {
+        return _append_chars(32, [value](value_type *first, value_type *last) {
+            return std::to_chars(first, last, value);
+        });
+    }
+
+    template <std::floating_point T>
+    String &append_float(T value, std::chars_format format, int precision) {
+        // Fixed notation may need way more than this, in which case it's retried
+        return _append_chars(32 + (size_type)std::max(precision, 0),
+                             [value, format, precision](value_type *first, value_type *last) {
+            return std::to_chars(first, last, value, format, precision);
+        });
+    }
+
+    /**
+     * Same as appending std::format(fmt, args...), but without the temporary.
+     * The text is formatted straight into the spare capacity. Only if it
+     * doesn't fit there, the buffer grows once, by exactly as much as needed,
+     * and the text is formatted again.
+     */
+    template <typename ... As>
+    String &append_format(std::format_string<As...> fmt, As &&... args) {
+        ensure_ownership();
+
+        value_type *first = begin() + size();
+        const size_type spare = capacity() - size_with_null();
+
+        // Formatting only ever reads the arguments, so forwarding them twice is fine
+        auto [last, count] = std::format_to_n(first, spare, fmt, std::forward<As>(args)...);
+
+        if ((size_type)count > spare) {
+            ensure_extra_capacity(count);
+
+            first = begin() + size();
+            last = std::format_to(first, fmt, std::forward<As>(args)...);
+        }
+
+        *last = nullchr;
+        _set_size(size_with_null() + count);
+
+        return *this;
+    }
+    #pragma endregion Numbers & formatting
+
     #pragma region Operator +
     template <typename T>
     String &operator+=(T &&arg) {
@@ -797,7 +1100,122 @@ public:
     }
     #pragma endregion Operator +
 
-    // TODO: Provide insert, substr, compare overloads, replace, find?
+    // TODO: Provide insert, substr, compare overloads, replace?
+
+    #pragma region Search
+    /// Every overload of these only reads the current buffer, so no lazy state gets copied
+    size_type find(const value_type *str, size_type pos, size_type count) const {
+        if (pos > size()) {
+            return npos;
+        }
+
+        return _offset(pos, _impl::search::find(data() + pos, size() - pos, str, count));
+    }
+
+    size_type rfind(const value_type *str, size_type pos, size_type count) const {
+        if (count > size()) {
+            return npos;
+        }
+
+        // The match must start at pos or before it
+        size_type limit = std::min(pos, size() - count) + count;
+
+        return _impl::search::rfind(data(), limit, str, count);
+    }
+
+    size_type find_first_of(const value_type *str, size_type pos, size_type count) const {
+        if (pos >= size()) {
+            return npos;
+        }
+
+        return _offset(pos, _impl::search::find_of<false, false>(data() + pos, size() - pos,
+                                                                 str, count));
+    }
+
+    size_type find_first_not_of(const value_type *str, size_type pos, size_type count) const {
+        if (pos >= size()) {
+            return npos;
+        }
+
+        return _offset(pos, _impl::search::find_of<false, true>(data() + pos, size() - pos,
+                                                                str, count));
+    }
+
+    size_type find_last_of(const value_type *str, size_type pos, size_type count) const {
+        return _impl::search::find_of<true, false>(data(), _rlimit(pos), str, count);
+    }
+
+    size_type find_last_not_of(const value_type *str, size_type pos, size_type count) const {
+        return _impl::search::find_of<true, true>(data(), _rlimit(pos), str, count);
+    }
+
+    #define SEARCH_OVERLOADS_(NAME, DEFAULT_POS)                                    \
+        inline size_type NAME(const String &str, size_type pos = DEFAULT_POS) const { \
+            return NAME(str.data(), pos, str.size());                               \
+        }                                                                           \
+                                                                                    \
+        inline size_type NAME(const value_type *str, size_type pos = DEFAULT_POS) const { \
+            return NAME(str, pos, strlen(str));                                     \
+        }                                                                           \
+                                                                                    \
+        inline size_type NAME(value_type chr, size_type pos = DEFAULT_POS) const {  \
+            return NAME(&chr, pos, 1);                                              \
+        }                                                                           \
+                                                                                    \
+        template <_impl::string_view_like<value_type> StringViewLike>               \
+        inline size_type NAME(const StringViewLike &str, size_type pos = DEFAULT_POS) const { \
+            std::string_view sv(str);                                               \
+            return NAME(sv.data(), pos, sv.size());                                 \
+        }
+
+    SEARCH_OVERLOADS_(find, 0)
+    SEARCH_OVERLOADS_(rfind, npos)
+    SEARCH_OVERLOADS_(find_first_of, 0)
+    SEARCH_OVERLOADS_(find_first_not_of, 0)
+    SEARCH_OVERLOADS_(find_last_of, npos)
+    SEARCH_OVERLOADS_(find_last_not_of, npos)
+
+    #undef SEARCH_OVERLOADS_
+
+    template <typename T>
+    inline bool contains(T &&needle) const {
+        return find(std::forward<T>(needle)) != npos;
+    }
+
+    inline bool starts_with(const value_type *prefix, size_type count) const {
+        return size() >= count && std::equal(prefix, prefix + count, data());
+    }
+
+    inline bool ends_with(const value_type *suffix, size_type count) const {
+        return size() >= count && std::equal(suffix, suffix + count, data() + size() - count);
+    }
+
+    // Same overload set as the search functions, so that literals, Strings
+    // and string_views all have exactly one best match
+    #define AFFIX_OVERLOADS_(NAME, AT)                                              \
+        inline bool NAME(const String &str) const {                                 \
+            return NAME(str.data(), str.size());                                    \
+        }                                                                           \
+                                                                                    \
+        inline bool NAME(const value_type *str) const {                             \
+            return NAME(str, strlen(str));                                          \
+        }                                                                           \
+                                                                                    \
+        inline bool NAME(value_type chr) const {                                    \
+            return size() > 0 && data()[AT] == chr;                                 \
+        }                                                                           \
+                                                                                    \
+        template <_impl::string_view_like<value_type> StringViewLike>               \
+        inline bool NAME(const StringViewLike &str) const {                         \
+            std::string_view sv(str);                                               \
+            return NAME(sv.data(), sv.size());                                      \
+        }
+
+    AFFIX_OVERLOADS_(starts_with, 0)
+    AFFIX_OVERLOADS_(ends_with, size() - 1)
+
+    #undef AFFIX_OVERLOADS_
+    #pragma endregion Search
 
     #pragma region Erase
     inline String &erase(difference_type raw_pos, size_type count = npos) {
@@ -811,14 +1229,14 @@ public:
     iterator erase(const_iterator pos) {
         iterator result = begin() + (pos - cbegin());
         *std::move(std::next(pos), end(), result) = nullchr;
-        size_--;
+        _set_size(size_with_null() - 1);
         return result;
     }
 
     iterator erase(const_iterator first, const_iterator last) {
         iterator result = begin() + (first - cbegin());
         *std::move(first, last, result) = nullchr;
-        size_ -= (last - first);
+        _set_size(size_with_null() - (last - first));
         return result;
     }
     #pragma endregion Erase
@@ -839,46 +1257,245 @@ public:
         );
     }
 
-    inline friend bool operator==(const String &a, std::string_view &b) {
-        return a == String::view(b);
+    // The reversed forms are synthesized by the compiler
+
+    inline friend bool operator==(const String &a, std::string_view b) {
+        return (std::string_view)a == b;
     }
 
-    inline friend auto operator<=>(const String &a, std::string_view &b) {
-        return a <=> String::view(b);
+    inline friend auto operator<=>(const String &a, std::string_view b) {
+        return (std::string_view)a <=> b;
     }
 
-    inline friend bool operator==(const std::string_view &a, String &b) {
-        return String::view(a) == b;
+    // Without these, string literals would be ambiguous between String and std::string_view
+    inline friend bool operator==(const String &a, const value_type *b) {
+        return a == std::string_view(b);
     }
 
-    inline friend auto operator<=>(const std::string_view &a, String &b) {
-        return String::view(a) <=> b;
+    inline friend auto operator<=>(const String &a, const value_type *b) {
+        return a <=> std::string_view(b);
     }
     #pragma endregion Comparison
 
+    #pragma region Splitting
+    /**
+     * Like Python's str.split(sep): adjacent delimiters enclose empty fields,
+     * and a string without any is a single field. See SplitView.
+     */
+    SplitView<String, _impl::search::CharScanner> split(value_type delim) const {
+        return {get_buf(), size(), std::string_view(&delim, 1)};
+    }
+
+    SplitView<String, _impl::SubstrFinder> split(std::string_view delim) const {
+        if (delim.empty()) {
+            throw std::invalid_argument("Empty delimiter");
+        }
+
+        return {get_buf(), size(), delim};
+    }
+
+    /// Fields delimited by any single one of the chars
+    SplitView<String, _impl::search::ByteScanner> split_any(std::string_view chars) const {
+        return {get_buf(), size(), chars};
+    }
+
+    /// Split by '\n' or "\r\n". A line break at the very end doesn't start an empty line
+    SplitView<String, _impl::search::CharScanner, true> lines() const {
+        return {get_buf(), size(), "\n"};
+    }
+    #pragma endregion Splitting
+
+    #pragma region Hashing
+    /**
+     * Same as hash_bytes over the contents. Strings spanning a whole shared source
+     * compute it once, in the source, and every other copy of it reuses the result.
+     */
+    size_t hash() const noexcept {
+        if (_lazy_state() == LazyState::shared && rep_.large.capacity_or_offset == 0 &&
+            size() == rep_.large.sls_ptr->size()) {
+            return rep_.large.sls_ptr.cached_hash();
+        }
+
+        return hash_bytes(get_buf(), size());
+    }
+    #pragma endregion Hashing
+
 protected:
     #pragma region Fields
-    allocator_type allocator_{};
-    union {  // Null-terminated in all cases
-        value_type *ptr_;
-        const value_type *view_ptr_;
-        sls_ptr_type sls_ptr_;
-        static_assert(sizeof(sls_ptr_) <= sizeof(void *));
-        value_type small_contents_[small_string_size] = {};
+    /*
+     * The layout follows libc++: both representations begin with the same flag bit-fields,
+     * which makes them a common initial sequence that may be read through either one.
+     * A small string keeps its size next to the flags and its characters in the rest of
+     * the object. Strings are small exactly when lazy_state == LazyState::small, and then
+     * rep_.small is the active member, otherwise rep_.large is; _set_lazy_state switches
+     * between them. The buffer is null-terminated in all cases.
+     */
+    struct LongRep {
+        // Mirror SmallRep's flags
+        size_type lazy_state : 2;
+        size_type is_null_terminated : 1;
+        // For lazy_state == LazyState::owned, the capacity. For LazyState::shared, where
+        // this string is a window onto the source, the offset the window starts at
+        size_type capacity_or_offset : sizeof(size_type) * CHAR_BIT - 3;
+        size_type size;
+        union {
+            value_type *ptr;
+            const value_type *view_ptr;
+            sls_ptr_type sls_ptr;
+        };
+
+        constexpr LongRep() noexcept :
+            lazy_state{0}, is_null_terminated{1}, capacity_or_offset{0}, size{0}, ptr{nullptr} {}
+
+        constexpr ~LongRep() {}
     };
-    size_type capacity_ = 0;
-    size_type size_ = 0;
-    struct {
+
+    struct SmallRep {
         // Whether the string is small-string-optimized, owned, or to be copied on write
-        LazyState lazy_state: 2 = LazyState::owned;
+        size_type lazy_state : 2 = (size_type)LazyState::small;
         // Whether the string is known to be null-terminated. Only makes sense when
-        // lazy_state == LazyState::view, otherwise it must be true
-        bool is_null_terminated : 1 = true;
-    } flags_;
+        // lazy_state is LazyState::view or LazyState::shared (for windows that
+        // end before the source does), otherwise it must be true
+        size_type is_null_terminated : 1 = true;
+        // Including the null terminator
+        size_type size : 5 = 1;
+        value_type contents[small_string_size] = {};
+    };
+
+    static_assert(sizeof(SmallRep) == sizeof(LongRep));
+    static_assert(small_string_size < (1 << 5));
+
+    NO_UNIQUE_ADDRESS_ allocator_type allocator_{};
+    union Rep {
+        SmallRep small;
+        LongRep large;
+
+        constexpr Rep() noexcept : small{} {}
+
+        constexpr explicit Rep(LazyState state) noexcept : large{} {
+            assert(state != LazyState::small);
+
+            large.lazy_state = (size_type)state;
+        }
+
+        constexpr ~Rep() {}
+    } rep_;
     #pragma endregion Fields
 
 
     #pragma region Protected interface
+    /// Starts out with rep_.large active, for strings that are never going to be small
+    constexpr String(LazyState state, const allocator_type &alloc) noexcept :
+        allocator_{alloc}, rep_(state) {}
+
+    /// A lazy copy of the whole source
+    static String _from_source(sls_ptr_type &&sls_ptr, const allocator_type &alloc) {
+        String result(LazyState::shared, alloc);
+        new (&result.rep_.large.sls_ptr) sls_ptr_type(std::move(sls_ptr));
+        result._pull_shared_info();
+
+        return result;
+    }
+
+    /// Whether rep_.large is the active member
+    constexpr bool _is_large() const {
+        #if STRING_CONSTEXPR_FLAGS_
+        // Constant evaluation doesn't allow reading the common initial sequence
+        // through the inactive member, so probe for the active one instead
+        if (std::is_constant_evaluated()) {
+            return __builtin_constant_p(rep_.large.lazy_state);
+        }
+        #endif
+
+        return rep_.small.lazy_state != (size_type)LazyState::small;
+    }
+
+    constexpr LazyState _lazy_state() const {
+        return (LazyState)(_is_large() ? rep_.large.lazy_state : rep_.small.lazy_state);
+    }
+
+    /**
+     * Switching to or from LazyState::small changes the active member of rep_, which
+     * resets it, so it must come before anything else is stored. Switching from
+     * LazyState::small keeps the null-terminatedness, though
+     */
+    constexpr void _set_lazy_state(LazyState state) {
+        const bool was_large = _is_large();
+
+        if (state == LazyState::small) {
+            if (was_large) {
+                std::construct_at(&rep_.small);
+            }
+
+            return;
+        }
+
+        if (!was_large) {
+            const bool null_terminated = rep_.small.is_null_terminated;
+
+            std::construct_at(&rep_.large);
+            rep_.large.is_null_terminated = null_terminated;
+        }
+
+        rep_.large.lazy_state = (size_type)state;
+    }
+
+    constexpr void _set_null_terminated(bool value) {
+        if (_is_large()) {
+            rep_.large.is_null_terminated = value;
+        } else {
+            rep_.small.is_null_terminated = value;
+        }
+    }
+
+    constexpr void _set_size(size_type value) {
+        if (_is_large()) {
+            rep_.large.size = value;
+        } else {
+            assert(value <= small_string_size);
+
+            rep_.small.size = value;
+        }
+    }
+
+    /// Everything but the pointer itself, for strings that aren't small
+    constexpr void _copy_large_fields(const String &other) {
+        assert(other._lazy_state() != LazyState::small);
+
+        _set_lazy_state(other._lazy_state());
+        _set_null_terminated(other.is_null_terminated());
+        rep_.large.capacity_or_offset = other.rep_.large.capacity_or_offset;
+        rep_.large.size = other.rep_.large.size;
+    }
+
+    /// What clear() frees, without resetting the fields, which the destructor doesn't need
+    constexpr void _release() {
+        switch (_lazy_state()) {
+        case LazyState::small:
+        case LazyState::view:
+            break;
+
+        case LazyState::shared:
+            rep_.large.sls_ptr.~sls_ptr_type();
+            break;
+
+        case LazyState::owned:
+            allocator_.deallocate(rep_.large.ptr, capacity());
+            break;
+
+        NODEFAULT
+        }
+    }
+
+    static constexpr size_type _offset(size_type pos, size_type found) {
+        return found == npos ? npos : pos + found;
+    }
+
+    /// How much of the buffer a backward search starting at pos covers
+    constexpr size_type _rlimit(size_type pos) const {
+        return pos >= size() ? size() : pos + 1;
+    }
+
     inline size_type prepare_idx(difference_type idx) const {
         if (idx < 0) {
             idx = idx + size();
@@ -892,41 +1509,41 @@ protected:
     }
 
     const value_type *get_buf() const {
-        switch (flags_.lazy_state) {
+        switch (_lazy_state()) {
         case LazyState::small:
-            return small_contents_;
+            return rep_.small.contents;
 
         case LazyState::view:
-            return view_ptr_;
+            return rep_.large.view_ptr;
 
         case LazyState::shared:
-            return sls_ptr_->get_buf();
+            return rep_.large.sls_ptr->get_buf() + rep_.large.capacity_or_offset;
 
         case LazyState::owned:
-            return ptr_;
+            return rep_.large.ptr;
 
         NODEFAULT
         }
     }
 
     value_type *get_owned_buf() {
-        switch (flags_.lazy_state) {
+        switch (_lazy_state()) {
         case LazyState::small:
-            return small_contents_;
+            return rep_.small.contents;
 
         case LazyState::view:
         case LazyState::shared:
             throw std::runtime_error("Buffer is not owned");
 
         case LazyState::owned:
-            return ptr_;
+            return rep_.large.ptr;
 
         NODEFAULT
         }
     }
 
     value_type *ensure_owned_buf() {
-        switch (flags_.lazy_state) {
+        switch (_lazy_state()) {
         case LazyState::view:
             _copy_from_view();
             break;
@@ -946,6 +1563,10 @@ protected:
         ensure_ownership();
 
         size_type proposed_capacity = capacity();
+        if (desired_capacity <= proposed_capacity) {
+            return;
+        }
+
         if (proposed_capacity == 0) {
             proposed_capacity = 8;
         }
@@ -958,8 +1579,50 @@ protected:
     }
 
     inline void ensure_extra_capacity(size_type extra_capacity) {
+        // Taking ownership may add a null terminator, changing size_with_null()
+        ensure_ownership();
+
         ensure_total_capacity(size_with_null() + extra_capacity);
     }
+
+    /// Enough for any integer, and for all floats but huge fixed-notation ones
+    static constexpr size_type convert_buf_size = 128;
+
+    /**
+     * Converts on the stack first, so that the worst-case guess doesn't spill
+     * a small string to the heap. Failing that, reserves room for `guess`
+     * characters, and retries with more if convert reports it wasn't enough.
+     */
+    template <typename F>
+    String &_append_chars(size_type guess, F &&convert) {
+        if (guess <= convert_buf_size) {
+            value_type buf[convert_buf_size];
+            const std::to_chars_result result = convert(buf, buf + convert_buf_size);
+
+            if (result.ec == std::errc{}) {
+                return append(buf, (size_type)(result.ptr - buf));
+            }
+
+            guess = convert_buf_size * 2;
+        }
+
+        while (true) {
+            ensure_extra_capacity(guess);
+
+            value_type *first = begin() + size();
+            const std::to_chars_result result = convert(first, first + guess);
+
+            if (result.ec == std::errc{}) {
+                *result.ptr = nullchr;
+                _set_size(size_with_null() + (result.ptr - first));
+
+                return *this;
+            }
+
+            assert(result.ec == std::errc::value_too_large);
+            guess *= 2;
+        }
+    }
     #pragma endregion Protected interface
 
     #pragma region Impl details
@@ -974,9 +1637,9 @@ protected:
         value_type *new_buf = nullptr;
         bool going_small = false;
 
-        abel::Defer release_buf_on_error([this, &new_buf, &going_small]() {
+        abel::Defer release_buf_on_error([this, &new_buf, &going_small, new_capacity]() {
             if (!going_small && new_buf) {
-                allocator_.deallocate(new_buf, capacity());
+                allocator_.deallocate(new_buf, new_capacity);
                 new_buf = nullptr;  // As a sanity check
             }
         });
@@ -984,7 +1647,9 @@ protected:
         if (new_capacity <= small_string_size) {
             assert(amount + 1 <= small_string_size);
 
-            new_buf = small_contents_;
+            // The source is never our own buffer if this switches to the small one
+            _set_lazy_state(LazyState::small);
+            new_buf = rep_.small.contents;
             going_small = true;
         } else {
             new_buf = allocator_.allocate(new_capacity);
@@ -994,45 +1659,58 @@ protected:
 
         new_buf[amount] = nullchr;
 
-        flags_.is_null_terminated = true;
+        if (!going_small) {
+            _set_lazy_state(LazyState::owned);
+            rep_.large.capacity_or_offset = new_capacity;
+            rep_.large.ptr = new_buf;
+        }
 
-        size_ = amount + 1;
+        _set_null_terminated(true);
 
-        if (going_small) {
-            flags_.lazy_state = LazyState::small;
-            capacity_ = small_string_size;
-        } else {
-            flags_.lazy_state = LazyState::owned;
-            capacity_ = new_capacity;
-            ptr_ = new_buf;
-        }
+        _set_size(amount + 1);
 
         new_buf = nullptr;
     }
 
     void _copy_from_view() {
-        assert(flags_.lazy_state == LazyState::view);
+        assert(_lazy_state() == LazyState::view);
 
         // Not size_with_null, because _copy_from should add the null byte
         // even if the view was not null-terminated
-        _copy_from(view_ptr_, size());
+        _copy_from(rep_.large.view_ptr, size());
     }
 
     void _copy_from_shared() {
-        assert(flags_.lazy_state == LazyState::shared);
+        assert(_lazy_state() == LazyState::shared);
+
+        const size_type offset = rep_.large.capacity_or_offset;
+        const size_type count = size();
 
-        sls_ptr_type tmp_sls_ptr = std::move(sls_ptr_);
-        sls_ptr_.~sls_ptr_type();
+        sls_ptr_type tmp_sls_ptr = std::move(rep_.large.sls_ptr);
+        rep_.large.sls_ptr.~sls_ptr_type();
+        // So that nothing (e.g. clear()) touches the destroyed pointer again
+        _set_lazy_state(LazyState::small);
 
-        // As an optimization
-        if (tmp_sls_ptr.is_last()) {
+        assert(offset + count <= tmp_sls_ptr->size());
+
+        // As an optimization. Not for mapped files, though: their views die with the source
+        if (tmp_sls_ptr.is_last() && tmp_sls_ptr->is_owning()) {
             (*this) = std::move(*tmp_sls_ptr);
+
+            if (offset != 0 || count != size()) {
+                // Only a window of the source was ours, but trimming
+                // the buffer in place still beats copying it
+                value_type *buf = get_owned_buf();
+
+                std::memmove(buf, buf + offset, count);
+                buf[count] = nullchr;
+                _set_size(count + 1);
+            }
+
             return;
         }
 
-        // We rely on our size_ being the same as the *tmp_sls_ptr's ones.
-        assert(tmp_sls_ptr->size() == size());
-        _copy_from(tmp_sls_ptr->data(), size());
+        _copy_from(tmp_sls_ptr->data() + offset, count);
     }
 
     void _set_capacity(size_type new_capacity) {
@@ -1043,13 +1721,14 @@ protected:
         }
 
         value_type *old_buf = ensure_owned_buf();
-        abel::Defer release_buf_eventually([this, &old_buf,
-                                           was_allocated = flags_.lazy_state == LazyState::owned]() {
+        abel::Defer release_buf_eventually([this, &old_buf, old_capacity = capacity(),
+                                           was_allocated = _lazy_state() == LazyState::owned]() {
             if (!was_allocated) {
                 return;
             }
 
-            allocator_.deallocate(old_buf, capacity());
+            // Not capacity(), since _copy_from has already updated it
+            allocator_.deallocate(old_buf, old_capacity);
             old_buf = nullptr;  // As a sanity check
         });
 
@@ -1057,12 +1736,57 @@ protected:
     }
 
     void _pull_shared_info() {
-        assert(flags_.lazy_state == LazyState::shared);
+        assert(_lazy_state() == LazyState::shared);
 
-        size_ = sls_ptr_->size_;
-        capacity_ = sls_ptr_->capacity_;
+        _set_size(rep_.large.sls_ptr->size_with_null());
+        rep_.large.capacity_or_offset = 0;
         // Pointless, but whatever
-        flags_.is_null_terminated = sls_ptr_->flags_.is_null_terminated;
+        _set_null_terminated(rep_.large.sls_ptr->is_null_terminated());
+    }
+
+    /// Moves the contents into a new shared source, unless they're there already
+    void _make_shared() {
+        assert(_lazy_state() != LazyState::view);
+
+        if (_lazy_state() == LazyState::shared) {
+            return;
+        }
+
+        sls_ptr_type new_sls = sls_ptr_type::source_type::create();
+        *new_sls = std::move(*this);
+
+        // Just in case
+        clear();
+
+        _set_lazy_state(LazyState::shared);
+        new (&rep_.large.sls_ptr) sls_ptr_type(std::move(new_sls));
+        _pull_shared_info();
+    }
+
+    /// Another reference to the same source, limited to [pos, pos + count) of this string
+    String _shared_window(size_type pos, size_type count) const {
+        assert(_lazy_state() == LazyState::shared);
+        assert(pos + count <= size());
+
+        String result(get_allocator());
+
+        result._set_lazy_state(LazyState::shared);
+        new (&result.rep_.large.sls_ptr) sls_ptr_type(rep_.large.sls_ptr.copy());
+        result.rep_.large.capacity_or_offset = rep_.large.capacity_or_offset + pos;
+
+        // Only a window reaching our end may rely on our null terminator
+        result._set_null_terminated(is_null_terminated() && pos + count == size());
+        result._set_size(count + (size_type)result.is_null_terminated());
+
+        return result;
+    }
+
+    size_type _clamp_idx(difference_type idx) const {
+        if (idx < 0) {
+            idx += (difference_type)size();
+        }
+
+        return (size_type)std::clamp<difference_type>(idx, 0, (difference_type)size());
     }
 
     void _share_from(String &other) {
@@ -1070,31 +1794,25 @@ protected:
             return;
         }
 
-        if (other.flags_.lazy_state == LazyState::view) {
+        if (other._lazy_state() == LazyState::view) {
             *this = view(other);
             return;
         }
 
         clear();
 
-        if (other.flags_.lazy_state != LazyState::shared) {
-            sls_ptr_type new_sls = sls_ptr_type::source_type::create();
-            *new_sls = std::move(other);
-
-            // Just in case
-            other.clear();
-
-            new (&other.sls_ptr_) sls_ptr_type(std::move(new_sls));
-
-            other.flags_.lazy_state = LazyState::shared;
-            other._pull_shared_info();
+        // Copying these is cheaper than allocating a source to share
+        if (other._lazy_state() == LazyState::small) {
+            rep_.small = other.rep_.small;
+            return;
         }
 
-        assert(other.flags_.lazy_state == LazyState::shared);
-        new (&sls_ptr_) sls_ptr_type(std::move(other.sls_ptr_.copy()));
+        other._make_shared();
 
-        flags_.lazy_state = LazyState::shared;
-        _pull_shared_info();
+        assert(other._lazy_state() == LazyState::shared);
+        // Other may be a window, so its own info is used rather than the source's
+        _copy_large_fields(other);
+        new (&rep_.large.sls_ptr) sls_ptr_type(std::move(other.rep_.large.sls_ptr.copy()));
     }
     #pragma endregion Impl details
 
@@ -1105,15 +1823,15 @@ protected:
 namespace _impl {
 
 #pragma region Source
-template <typename Allocator>
+template <typename Allocator, RefCountPolicy RefCount>
 class SharedLazySource {
 public:
-    using string_type = String<Allocator>;
+    using string_type = String<Allocator, RefCount>;
 
-    template <typename Allocator_>
+    template <typename Allocator_, RefCountPolicy RefCount_>
     friend class SharedLazySourcePtr;
 
-    using ptr_type = SharedLazySourcePtr<Allocator>;
+    using ptr_type = SharedLazySourcePtr<Allocator, RefCount>;
 
 
     static inline [[nodiscard]] ptr_type create() {
@@ -1125,33 +1843,86 @@ public:
     }
 
     constexpr bool is_last() const {
-        return ref_cnt == 1;
+        return ref_cnt.is_unique();
+    }
+
+    size_t cached_hash() const noexcept {
+        size_t result = hash_cache.load(std::memory_order_relaxed);
+
+        // Zero means 'not computed yet'. A genuine zero just gets recomputed every time
+        if (result == 0) {
+            result = hash_bytes(source.data(), source.size());
+            hash_cache.store(result, std::memory_order_relaxed);
+        }
+
+        return result;
     }
 
 protected:
     string_type source{};
-    unsigned ref_cnt{0};
+    RefCount ref_cnt{};
+    // The source never changes while shared, and racing threads would store the same value,
+    // so relaxed atomics suffice. They compile to plain moves where it matters
+    mutable std::atomic<size_t> hash_cache{0};
 
 
     inline SharedLazySource() {}
 
     inline void die() {
+        if (!source.is_owning()) {
+            // Lazy copies never view anything, so this is an external source
+            auto *external = static_cast<ExternalLazySource<Allocator, RefCount> *>(this);
+            external->destroy_(external);
+
+            return;
+        }
+
         delete this;
     }
 
+};
+
+/**
+ * A source that views memory owned by something else, like a mapped file
+ * (see mapped_file.h). Derived types keep that memory alive, and destroy_
+ * deletes them as such. Sources that own their string don't pay for it.
+ */
+template <typename Allocator, RefCountPolicy RefCount>
+class ExternalLazySource : public SharedLazySource<Allocator, RefCount> {
+public:
+    using string_type = String<Allocator, RefCount>;
+
+    friend class SharedLazySource<Allocator, RefCount>;
+
+protected:
+    using destroy_type = void (*)(ExternalLazySource *);
+
+    destroy_type destroy_;
+
+
+    explicit ExternalLazySource(destroy_type destroy) :
+        destroy_{destroy} {}
+
+    /// Takes the first reference to this source
+    string_type _share(const typename string_type::allocator_type &alloc) {
+        assert(!this->source.is_owning());
+
+        return string_type::_from_source(this->get_ptr(), alloc);
+    }
+
 };
 #pragma endregion Source
 
 #pragma region Pointer
-template <typename Allocator>
+template <typename Allocator, RefCountPolicy RefCount>
 class SharedLazySourcePtr {
 public:
-    using string_type = String<Allocator>;
+    using string_type = String<Allocator, RefCount>;
 
-    template <typename Allocator_>
+    template <typename Allocator_, RefCountPolicy RefCount_>
     friend class SharedLazySource;
 
-    using source_type = SharedLazySource<Allocator>;
+    using source_type = SharedLazySource<Allocator, RefCount>;
 
 
     constexpr SharedLazySourcePtr() : source{nullptr} {}
@@ -1174,7 +1945,7 @@ public:
             return;
         }
 
-        if (--source->ref_cnt == 0) {
+        if (source->ref_cnt.release()) {
             source->die();
         }
 
@@ -1199,6 +1970,10 @@ public:
         return source->get_ptr();
     }
 
+    inline size_t cached_hash() const noexcept {
+        return source->cached_hash();
+    }
+
 protected:
     source_type *source;
 
@@ -1207,7 +1982,7 @@ protected:
         source{source} {
 
         assert(source);
-        ++source->ref_cnt;
+        source->ref_cnt.acquire();
     }
 
 };
@@ -1216,6 +1991,19 @@ protected:
 }
 #pragma endregion SharedLazySource
 
+// Three words, whichever compiler: MSVC needs its own spelling of [[no_unique_address]]
+static_assert(sizeof(String<>) == 3 * sizeof(void *));
+
+
+#pragma region Formatting
+/// Appends the formatted text to dest. See String::append_format
+template <typename Allocator, RefCountPolicy RefCount, typename ... As>
+inline String<Allocator, RefCount> &format_to(String<Allocator, RefCount> &dest,
+                                              std::format_string<As...> fmt, As &&... args) {
+    return dest.append_format(fmt, std::forward<As>(args)...);
+}
+#pragma endregion Formatting
+
 
 #pragma region Literals
 namespace string_literals {
@@ -1236,13 +2024,13 @@ String<> operator ""_sv(const char *str, size_t size) {
 
 
 #pragma region IOStream compat
-template <typename Allocator>
-std::ostream &operator<<(std::ostream &out, const mylib::String<Allocator> &str) {
+template <typename Allocator, mylib::RefCountPolicy RefCount>
+std::ostream &operator<<(std::ostream &out, const mylib::String<Allocator, RefCount> &str) {
     return out << (std::string_view)str;
 }
 
-template <typename Allocator>
-std::istream &operator<<(std::istream &out, mylib::String<Allocator> &str) {
+template <typename Allocator, mylib::RefCountPolicy RefCount>
+std::istream &operator<<(std::istream &out, mylib::String<Allocator, RefCount> &str) {
     std::string tmp{};
     out >> tmp;
     str = std::move(tmp);
@@ -1250,3 +2038,15 @@ std::istream &operator<<(std::istream &out, mylib::String<Allocator> &str) {
     return out;
 }
 #pragma endregion IOStream compat
+
+
+namespace std {
+
+template <typename Allocator, mylib::RefCountPolicy RefCount>
+struct hash<mylib::String<Allocator, RefCount>> {
+    inline size_t operator()(const mylib::String<Allocator, RefCount> &str) const noexcept {
+        return str.hash();
+    }
+};
+
+}
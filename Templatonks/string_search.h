@@ -0,0 +1,667 @@
+#pragma once
+
+#include <ACL/general.h>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+
+#if defined(__AVX2__)
+#define SEARCH_USE_AVX2_ 1
+#else
+#define SEARCH_USE_AVX2_ 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SEARCH_USE_SSE2_ 1
+#else
+#define SEARCH_USE_SSE2_ 0
+#endif
+
+#if SEARCH_USE_AVX2_ || SEARCH_USE_SSE2_
+#include <immintrin.h>
+#endif
+
+
+/**
+ * Byte-string search primitives behind String's find family.
+ * Everything works on a (pointer, size) pair, so the callers never need
+ * a null-terminated or owned buffer. All positions are relative to the
+ * haystack's start, and npos means 'not found'.
+ */
+namespace mylib::_impl::search {
+
+
+constexpr size_t npos = (size_t)-1;
+
+/// Needles this long and longer go to Two-Way, which is linear in the worst case
+constexpr size_t two_way_threshold = 64;
+
+
+#pragma region SIMD
+#if SEARCH_USE_SSE2_
+struct Sse2 {
+    using reg = __m128i;
+
+    static constexpr size_t width = 16;
+
+    static inline reg load(const char *ptr) {
+        return _mm_loadu_si128((const reg *)ptr);
+    }
+
+    static inline reg splat(char chr) {
+        return _mm_set1_epi8(chr);
+    }
+
+    static inline reg eq(reg a, reg b) {
+        return _mm_cmpeq_epi8(a, b);
+    }
+
+    static inline reg both(reg a, reg b) {
+        return _mm_and_si128(a, b);
+    }
+
+    static inline reg either(reg a, reg b) {
+        return _mm_or_si128(a, b);
+    }
+
+    static inline reg none() {
+        return _mm_setzero_si128();
+    }
+
+    /// One bit per byte, the lowest for the first byte
+    static inline uint32_t mask(reg a) {
+        return (uint32_t)_mm_movemask_epi8(a);
+    }
+};
+#endif
+
+#if SEARCH_USE_AVX2_
+struct Avx2 {
+    using reg = __m256i;
+
+    static constexpr size_t width = 32;
+
+    static inline reg load(const char *ptr) {
+        return _mm256_loadu_si256((const reg *)ptr);
+    }
+
+    static inline reg splat(char chr) {
+        return _mm256_set1_epi8(chr);
+    }
+
+    static inline reg eq(reg a, reg b) {
+        return _mm256_cmpeq_epi8(a, b);
+    }
+
+    static inline reg both(reg a, reg b) {
+        return _mm256_and_si256(a, b);
+    }
+
+    static inline reg either(reg a, reg b) {
+        return _mm256_or_si256(a, b);
+    }
+
+    static inline reg none() {
+        return _mm256_setzero_si256();
+    }
+
+    static inline uint32_t mask(reg a) {
+        return (uint32_t)_mm256_movemask_epi8(a);
+    }
+};
+#endif
+
+#if SEARCH_USE_AVX2_
+using Isa = Avx2;
+#define SEARCH_HAS_SIMD_ 1
+#elif SEARCH_USE_SSE2_
+using Isa = Sse2;
+#define SEARCH_HAS_SIMD_ 1
+#else
+#define SEARCH_HAS_SIMD_ 0
+#endif
+
+constexpr unsigned _lowest_bit(uint32_t mask) {
+    return (unsigned)std::countr_zero(mask);
+}
+
+constexpr unsigned _highest_bit(uint32_t mask) {
+    return 31 - (unsigned)std::countl_zero(mask);
+}
+#pragma endregion SIMD
+
+
+#pragma region Two-Way
+/// Lets Two-Way run over the haystack and the needle backwards, for rfind
+template <bool Reversed>
+struct _Seq {
+    const unsigned char *ptr;
+    size_t size;
+
+    constexpr unsigned char operator[](size_t idx) const {
+        if constexpr (Reversed) {
+            return ptr[size - 1 - idx];
+        } else {
+            return ptr[idx];
+        }
+    }
+};
+
+/// Returns the start of the critical factorization and sets period accordingly
+template <bool Reversed, bool Inverse>
+size_t _maximal_suffix(_Seq<Reversed> needle, size_t &period) {
+    size_t ms = (size_t)-1;  // Intentionally wraps around
+    size_t j = 0;
+    size_t k = 1;
+    period = 1;
+
+    while (j + k < needle.size) {
+        unsigned char a = needle[ms + k];
+        unsigned char b = needle[j  + k];
+
+        if (a == b) {
+            if (k == period) {
+                j += period;
+                k = 1;
+            } else {
+                ++k;
+            }
+        } else if (Inverse ? a < b : a > b) {
+            j += k;
+            k = 1;
+            period = j - ms;
+        } else {
+            ms = j++;
+            k = period = 1;
+        }
+    }
+
+    return ms;
+}
+
+/// Crochemore-Perrin string matching: O(n + m) time, O(1) space
+template <bool Reversed>
+size_t two_way(_Seq<Reversed> hay, _Seq<Reversed> needle) {
+    const size_t m = needle.size;
+    assert(m > 0);
+
+    if (hay.size < m) {
+        return npos;
+    }
+
+    size_t period = 0;
+    size_t inv_period = 0;
+    size_t ms = _maximal_suffix<Reversed, false>(needle, period);
+    size_t inv_ms = _maximal_suffix<Reversed, true>(needle, inv_period);
+
+    if (inv_ms + 1 > ms + 1) {
+        ms = inv_ms;
+        period = inv_period;
+    }
+
+    bool periodic = true;
+    for (size_t i = 0; i < ms + 1; ++i) {
+        if (needle[i] != needle[i + period]) {
+            periodic = false;
+            break;
+        }
+    }
+
+    // How much of the needle's prefix is known to match after a shift by period
+    size_t mem0 = 0;
+    if (periodic) {
+        mem0 = m - period;
+    } else {
+        period = std::max(ms, m - ms - 1) + 1;
+    }
+
+    size_t mem = 0;
+
+    for (size_t pos = 0; pos + m <= hay.size;) {
+        size_t k = std::max(ms + 1, mem);
+
+        while (k < m && needle[k] == hay[pos + k]) {
+            ++k;
+        }
+
+        if (k < m) {
+            pos += k - ms;
+            mem = 0;
+            continue;
+        }
+
+        for (k = ms + 1; k > mem && needle[k - 1] == hay[pos + k - 1];) {
+            --k;
+        }
+
+        if (k <= mem) {
+            return pos;
+        }
+
+        pos += period;
+        mem = mem0;
+    }
+
+    return npos;
+}
+#pragma endregion Two-Way
+
+
+#pragma region Single byte
+inline size_t find_byte(const char *hay, size_t n, char chr) {
+    const void *found = std::memchr(hay, chr, n);
+
+    return found ? (size_t)((const char *)found - hay) : npos;
+}
+
+inline size_t rfind_byte(const char *hay, size_t n, char chr) {
+    size_t pos = n;
+
+    #if SEARCH_HAS_SIMD_
+    const Isa::reg target = Isa::splat(chr);
+
+    for (; pos >= Isa::width; pos -= Isa::width) {
+        uint32_t mask = Isa::mask(Isa::eq(Isa::load(hay + pos - Isa::width), target));
+
+        if (mask) {
+            return pos - Isa::width + _highest_bit(mask);
+        }
+    }
+    #endif
+
+    while (pos-- > 0) {
+        if (hay[pos] == chr) {
+            return pos;
+        }
+    }
+
+    return npos;
+}
+#pragma endregion Single byte
+
+
+#pragma region Substring
+/**
+ * Compares the needle's first and last bytes against a whole register of
+ * candidate positions at once, and only verifies the survivors with memcmp.
+ * (See http://0x80.pl/articles/simd-strfind.html)
+ */
+inline size_t find(const char *hay, size_t n, const char *needle, size_t m) {
+    if (m == 0) {
+        return 0;
+    }
+
+    if (m > n) {
+        return npos;
+    }
+
+    if (m == 1) {
+        return find_byte(hay, n, needle[0]);
+    }
+
+    if (m >= two_way_threshold) {
+        return two_way(_Seq<false>{(const unsigned char *)hay, n},
+                       _Seq<false>{(const unsigned char *)needle, m});
+    }
+
+    const size_t last = m - 1;
+    size_t pos = 0;
+
+    #if SEARCH_HAS_SIMD_
+    const Isa::reg first_bytes = Isa::splat(needle[0]);
+    const Isa::reg last_bytes = Isa::splat(needle[last]);
+
+    for (; pos + last + Isa::width <= n; pos += Isa::width) {
+        uint32_t mask = Isa::mask(Isa::both(Isa::eq(first_bytes, Isa::load(hay + pos)),
+                                            Isa::eq(last_bytes, Isa::load(hay + pos + last))));
+
+        for (; mask; mask &= mask - 1) {
+            size_t candidate = pos + _lowest_bit(mask);
+
+            if (std::memcmp(hay + candidate + 1, needle + 1, m - 2) == 0) {
+                return candidate;
+            }
+        }
+    }
+    #endif
+
+    while (pos + m <= n) {
+        size_t candidate = find_byte(hay + pos, n - m + 1 - pos, needle[0]);
+
+        if (candidate == npos) {
+            break;
+        }
+
+        pos += candidate;
+
+        if (hay[pos + last] == needle[last] &&
+            std::memcmp(hay + pos + 1, needle + 1, m - 2) == 0) {
+            return pos;
+        }
+
+        ++pos;
+    }
+
+    return npos;
+}
+
+/// The last occurrence, by the same scheme as find, just scanning backwards
+inline size_t rfind(const char *hay, size_t n, const char *needle, size_t m) {
+    if (m > n) {
+        return npos;
+    }
+
+    if (m == 0) {
+        return n;
+    }
+
+    if (m == 1) {
+        return rfind_byte(hay, n, needle[0]);
+    }
+
+    if (m >= two_way_threshold) {
+        size_t found = two_way(_Seq<true>{(const unsigned char *)hay, n},
+                               _Seq<true>{(const unsigned char *)needle, m});
+
+        return found == npos ? npos : n - m - found;
+    }
+
+    const size_t last = m - 1;
+    // The number of candidate positions not yet checked, all below this one
+    size_t end = n - m + 1;
+
+    #if SEARCH_HAS_SIMD_
+    const Isa::reg first_bytes = Isa::splat(needle[0]);
+    const Isa::reg last_bytes = Isa::splat(needle[last]);
+
+    for (; end >= Isa::width; end -= Isa::width) {
+        const size_t pos = end - Isa::width;
+
+        uint32_t mask = Isa::mask(Isa::both(Isa::eq(first_bytes, Isa::load(hay + pos)),
+                                            Isa::eq(last_bytes, Isa::load(hay + pos + last))));
+
+        for (; mask; mask &= ~((uint32_t)1 << _highest_bit(mask))) {
+            size_t candidate = pos + _highest_bit(mask);
+
+            if (std::memcmp(hay + candidate + 1, needle + 1, m - 2) == 0) {
+                return candidate;
+            }
+        }
+    }
+    #endif
+
+    while (end-- > 0) {
+        if (hay[end] == needle[0] && hay[end + last] == needle[last] &&
+            std::memcmp(hay + end + 1, needle + 1, m - 2) == 0) {
+            return end;
+        }
+    }
+
+    return npos;
+}
+#pragma endregion Substring
+
+
+#pragma region Character sets
+/// Sets this small are matched with one comparison per member per register
+constexpr size_t simd_set_limit = 8;
+
+class ByteSet {
+public:
+    ByteSet(const char *chars, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            unsigned char chr = (unsigned char)chars[i];
+            bits_[chr / 64] |= (uint64_t)1 << (chr % 64);
+        }
+    }
+
+    inline bool contains(char raw_chr) const {
+        unsigned char chr = (unsigned char)raw_chr;
+
+        return (bits_[chr / 64] >> (chr % 64)) & 1;
+    }
+
+protected:
+    uint64_t bits_[4] = {};
+
+};
+
+/**
+ * The first (or, with Backward, the last) byte that is in the set
+ * (or, with Negate, that isn't)
+ */
+template <bool Backward, bool Negate>
+size_t find_of(const char *hay, size_t n, const char *chars, size_t count) {
+    if (count == 0) {
+        if constexpr (Negate) {
+            return n == 0 ? npos : (Backward ? n - 1 : 0);
+        } else {
+            return npos;
+        }
+    }
+
+    size_t pos = Backward ? n : 0;
+
+    #if SEARCH_HAS_SIMD_
+    if (count <= simd_set_limit) {
+        Isa::reg members[simd_set_limit];
+        for (size_t i = 0; i < count; ++i) {
+            members[i] = Isa::splat(chars[i]);
+        }
+
+        auto block_mask = [&](size_t at) {
+            const Isa::reg block = Isa::load(hay + at);
+            Isa::reg hits = Isa::none();
+
+            for (size_t i = 0; i < count; ++i) {
+                hits = Isa::either(hits, Isa::eq(block, members[i]));
+            }
+
+            uint32_t mask = Isa::mask(hits);
+
+            if constexpr (Negate) {
+                mask = ~mask & (uint32_t)(((uint64_t)1 << Isa::width) - 1);
+            }
+
+            return mask;
+        };
+
+        if constexpr (Backward) {
+            for (; pos >= Isa::width; pos -= Isa::width) {
+                if (uint32_t mask = block_mask(pos - Isa::width)) {
+                    return pos - Isa::width + _highest_bit(mask);
+                }
+            }
+        } else {
+            for (; pos + Isa::width <= n; pos += Isa::width) {
+                if (uint32_t mask = block_mask(pos)) {
+                    return pos + _lowest_bit(mask);
+                }
+            }
+        }
+    }
+    #endif
+
+    const ByteSet set{chars, count};
+
+    if constexpr (Backward) {
+        while (pos-- > 0) {
+            if (set.contains(hay[pos]) != Negate) {
+                return pos;
+            }
+        }
+    } else {
+        for (; pos < n; ++pos) {
+            if (set.contains(hay[pos]) != Negate) {
+                return pos;
+            }
+        }
+    }
+
+    return npos;
+}
+
+/**
+ * Finds successive occurrences of any of a few bytes, for splitting. Each
+ * register-sized block is compared once, and its match mask is kept between
+ * calls: fields are usually shorter than a register, so restarting a search
+ * for every one of them would mostly rescan the same bytes.
+ * The scanner keeps its own copy of the set, so the bytes needn't outlive it.
+ */
+class ByteScanner {
+public:
+    ByteScanner(const char *hay, size_t n, const char *chars, size_t count) :
+        hay_{hay}, n_{n}, count_{count}, set_{chars, count} {
+
+        std::copy_n(chars, std::min(count, simd_set_limit), chars_);
+    }
+
+    /// The first match at or after pos. pos must not decrease between calls
+    size_t next(size_t pos) {
+        #if SEARCH_HAS_SIMD_
+        if (count_ <= simd_set_limit) {
+            while (pos < n_) {
+                if (pos < block_ || pos - block_ >= Isa::width) {
+                    _load_block(pos);
+                }
+
+                if (uint32_t mask = mask_ >> (pos - block_)) {
+                    return pos + _lowest_bit(mask);
+                }
+
+                pos = block_ + Isa::width;
+            }
+
+            return npos;
+        }
+        #endif
+
+        for (; pos < n_; ++pos) {
+            if (set_.contains(hay_[pos])) {
+                return pos;
+            }
+        }
+
+        return npos;
+    }
+
+protected:
+    const char *hay_;
+    size_t n_;
+    char chars_[simd_set_limit] = {};
+    size_t count_;
+    ByteSet set_;
+    #if SEARCH_HAS_SIMD_
+    // The block starting at block_ has a bit set in mask_ for every match
+    size_t block_ = npos;
+    uint32_t mask_ = 0;
+
+
+    void _load_block(size_t at) {
+        block_ = at;
+
+        if (at + Isa::width <= n_) {
+            mask_ = _block_mask(at);
+            return;
+        }
+
+        if (n_ >= Isa::width) {
+            // The last whole register instead, overlapping what's already been scanned
+            mask_ = _block_mask(n_ - Isa::width) >> (at + Isa::width - n_);
+            return;
+        }
+
+        mask_ = 0;
+        for (size_t i = at; i < n_; ++i) {
+            mask_ |= (uint32_t)set_.contains(hay_[i]) << (i - at);
+        }
+    }
+
+    uint32_t _block_mask(size_t at) const {
+        const Isa::reg block = Isa::load(hay_ + at);
+        Isa::reg hits = Isa::none();
+
+        for (size_t i = 0; i < count_; ++i) {
+            hits = Isa::either(hits, Isa::eq(block, Isa::splat(chars_[i])));
+        }
+
+        return Isa::mask(hits);
+    }
+    #endif
+
+};
+
+/// ByteScanner, specialized for a single byte
+class CharScanner {
+public:
+    CharScanner(const char *hay, size_t n, const char *chars, size_t count) :
+        hay_{hay}, n_{n}, chr_{chars[0]} {
+
+        assert(count == 1);
+    }
+
+    /// The first match at or after pos. pos must not decrease between calls
+    size_t next(size_t pos) {
+        #if SEARCH_HAS_SIMD_
+        while (pos < n_) {
+            if (pos < block_ || pos - block_ >= Isa::width) {
+                _load_block(pos);
+            }
+
+            if (uint32_t mask = mask_ >> (pos - block_)) {
+                return pos + _lowest_bit(mask);
+            }
+
+            pos = block_ + Isa::width;
+        }
+
+        return npos;
+        #else
+        const void *found = std::memchr(hay_ + pos, chr_, n_ - pos);
+
+        return found ? (size_t)((const char *)found - hay_) : npos;
+        #endif
+    }
+
+protected:
+    const char *hay_;
+    size_t n_;
+    char chr_;
+    #if SEARCH_HAS_SIMD_
+    // The block starting at block_ has a bit set in mask_ for every match
+    uint32_t mask_ = 0;
+    size_t block_ = npos;
+
+
+    void _load_block(size_t at) {
+        block_ = at;
+
+        if (at + Isa::width <= n_) {
+            mask_ = _block_mask(at);
+            return;
+        }
+
+        if (n_ >= Isa::width) {
+            // The last whole register instead, overlapping what's already been scanned
+            mask_ = _block_mask(n_ - Isa::width) >> (at + Isa::width - n_);
+            return;
+        }
+
+        mask_ = 0;
+        for (size_t i = at; i < n_; ++i) {
+            mask_ |= (uint32_t)(hay_[i] == chr_) << (i - at);
+        }
+    }
+
+    uint32_t _block_mask(size_t at) const {
+        return Isa::mask(Isa::eq(Isa::load(hay_ + at), Isa::splat(chr_)));
+    }
+    #endif
+
+};
+#pragma endregion Character sets
+
+
+}
@@ -4,15 +4,55 @@
 #include <sstream>
 #include <exception>
 #include <filesystem>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <fstream>
+#include <cstdlib>
+#include <new>
+#include <charconv>
+#include <cctype>
 
 
 namespace utest {
 
 
 #pragma region Logging
-static unsigned indentation = 0;
+// Every thread indents on its own
+static thread_local unsigned indentation = 0;
+static thread_local bool should_indent = true;
 static constexpr unsigned INDENTATION_STEP = 2;
 
+// Set while a Runner's worker runs a test
+static thread_local std::string *log_capture = nullptr;
+static std::mutex stdout_mutex{};
+
+/// Redirects this thread's log into a buffer, starting from a clean indentation
+class LogCapture {
+public:
+    explicit LogCapture(std::string &buf) :
+        prev_capture{std::exchange(log_capture, &buf)},
+        prev_indentation{std::exchange(indentation, 0)},
+        prev_should_indent{std::exchange(should_indent, true)} {}
+
+    LogCapture(const LogCapture &other) = delete;
+    LogCapture &operator=(const LogCapture &other) = delete;
+
+    ~LogCapture() {
+        log_capture = prev_capture;
+        indentation = prev_indentation;
+        should_indent = prev_should_indent;
+    }
+
+protected:
+    std::string *prev_capture;
+    unsigned prev_indentation;
+    bool prev_should_indent;
+
+};
+
 void log(const char *fmt, ...) {
     va_list args{};
     va_start(args, fmt);
@@ -20,7 +60,6 @@ void log(const char *fmt, ...) {
     va_end(args);
 
     std::ostringstream indented{};
-    static bool should_indent = true;
     for (char c : result) {
         if (should_indent) {
             for (unsigned i = 0; i < indentation; ++i) {
@@ -39,6 +78,12 @@ void log(const char *fmt, ...) {
 
     auto view = indented.view();
 
+    if (log_capture) {
+        log_capture->append(view);
+        return;
+    }
+
+    std::lock_guard lock{stdout_mutex};
     fwrite(view.data(), sizeof(char), view.size(), stdout);
     fflush(stdout);
 }
@@ -53,8 +98,99 @@ void dedent() {
 #pragma endregion Logging
 
 
+#pragma region Allocations
+// Constant-initialized, so that operator new can use it at any point
+static thread_local AllocStats thread_stats{};
+
+#if UTEST_COUNT_ALLOCS_
+/// Right in front of every block handed out by the replaced operator new
+struct AllocHeader {
+    void *raw;
+    size_t size;
+};
+
+static void *counted_alloc(size_t size, size_t align) noexcept {
+    align = std::max(align, alignof(AllocHeader));
+
+    if (size > SIZE_MAX - sizeof(AllocHeader) - align) {
+        return nullptr;
+    }
+
+    void *raw = std::malloc(size + sizeof(AllocHeader) + align);
+    if (!raw) {
+        return nullptr;
+    }
+
+    uintptr_t result = ((uintptr_t)raw + sizeof(AllocHeader) + align - 1) & ~(uintptr_t)(align - 1);
+    ((AllocHeader *)result)[-1] = AllocHeader{raw, size};
+
+    ++thread_stats.allocations;
+    thread_stats.bytes += size;
+    thread_stats.live_bytes += (ptrdiff_t)size;
+    thread_stats.peak_live_bytes = std::max(thread_stats.peak_live_bytes, thread_stats.live_bytes);
+
+    return (void *)result;
+}
+
+/// Follows the standard's protocol for the throwing forms of operator new
+static void *counted_alloc_or_throw(size_t size, size_t align) {
+    while (true) {
+        if (void *result = counted_alloc(size, align)) {
+            return result;
+        }
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+
+        handler();
+    }
+}
+
+static void counted_free(void *ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+
+    const AllocHeader &header = ((const AllocHeader *)ptr)[-1];
+
+    ++thread_stats.deallocations;
+    thread_stats.live_bytes -= (ptrdiff_t)header.size;
+
+    std::free(header.raw);
+}
+#endif
+
+AllocStats thread_alloc_stats() noexcept {
+    return thread_stats;
+}
+
+AllocCounter::AllocCounter() noexcept :
+    start_{thread_stats},
+    outer_peak_{thread_stats.peak_live_bytes} {
+
+    thread_stats.peak_live_bytes = thread_stats.live_bytes;
+}
+
+AllocCounter::~AllocCounter() {
+    thread_stats.peak_live_bytes = std::max(outer_peak_, thread_stats.peak_live_bytes);
+}
+
+AllocStats AllocCounter::stats() const noexcept {
+    return AllocStats{
+        thread_stats.allocations - start_.allocations,
+        thread_stats.deallocations - start_.deallocations,
+        thread_stats.bytes - start_.bytes,
+        thread_stats.live_bytes - start_.live_bytes,
+        thread_stats.peak_live_bytes - start_.live_bytes,
+    };
+}
+#pragma endregion Allocations
+
+
 #pragma region Test
-Test *Test::current_ptr = nullptr;
+thread_local Test *Test::current_ptr = nullptr;
 decltype(Test::global_stats) Test::global_stats{};
 
 
@@ -72,6 +208,14 @@ bool Test::run() {
 
     header();
 
+    AllocCounter allocs{};
+    alloc_counter_ = &allocs;
+    abel::Defer reset_counter{[this]() {
+        alloc_counter_ = nullptr;
+    }};
+
+    start_time_ = std::chrono::steady_clock::now();
+
     try {
         result = func();
     } catch (const user_fail_error &) {
@@ -91,9 +235,10 @@ bool Test::run() {
     return result;
 }
 
-static constexpr const char *COLOR_RED   = "\033[31m";
-static constexpr const char *COLOR_GREEN = "\033[32m";
-static constexpr const char *COLOR_NONE  = "\033[0m";
+static constexpr const char *COLOR_RED    = "\033[31m";
+static constexpr const char *COLOR_GREEN  = "\033[32m";
+static constexpr const char *COLOR_YELLOW = "\033[33m";
+static constexpr const char *COLOR_NONE   = "\033[0m";
 
 void Test::header() const {
     assert(status != Status::dead);
@@ -103,19 +248,43 @@ void Test::header() const {
         loc.function_name(), loc.line());
 }
 
+std::string Test::stop_clock() const {
+    elapsed_ = std::chrono::steady_clock::now() - start_time_;
+    alloc_stats_ = alloc_counter_ ? alloc_counter_->stats() : AllocStats{};
+
+    std::string alloc_note{};
+    if (alloc_stats_.allocations) {
+        alloc_note = abel::sprintfxx("; %zu allocations, %zu B, peak %td B",
+                                     alloc_stats_.allocations, alloc_stats_.bytes,
+                                     alloc_stats_.peak_live_bytes);
+    }
+
+    if (!is_slow()) {
+        return abel::sprintfxx(" (%.3f ms%s)", elapsed_.count(), alloc_note.c_str());
+    }
+
+    ++global_stats.slow_cnt;
+
+    return abel::sprintfxx(" (%s%.3f ms, slow%s%s)", COLOR_YELLOW, elapsed_.count(), COLOR_NONE, alloc_note.c_str());
+}
+
 void Test::pass() const {
     assert(status != Status::dead);
 
+    std::string time_note = stop_clock();
+
     //log("ok\n");
-    log("%sok%s\n", COLOR_GREEN, COLOR_NONE);
+    log("%sok%s%s\n", COLOR_GREEN, COLOR_NONE, time_note.c_str());
     status = Status::passed;
 }
 
 void Test::fail() const {
     assert(status != Status::dead);
 
+    std::string time_note = stop_clock();
+
     //log("FAIL!\n");
-    log("%sFAIL!%s\n", COLOR_RED, COLOR_NONE);
+    log("%sFAIL!%s%s\n", COLOR_RED, COLOR_NONE, time_note.c_str());
     status = Status::failed;
 
     ++global_stats.fail_cnt;
@@ -159,19 +328,745 @@ Test::~Test() {
 }
 
 void Test::sum_up() {
+    if (global_stats.slow_cnt != 0) {
+        log("\n%s%u tests took over %.0f ms%s\n",
+            COLOR_YELLOW, global_stats.slow_cnt.load(), slow_threshold.count(), COLOR_NONE);
+    }
+
     if (global_stats.fail_cnt == 0) {
         log("\n%sAll tests passed!%s\n\n", COLOR_GREEN, COLOR_NONE);
     } else {
-        log("\n%s%u tests failed!%s\n\n", COLOR_RED, global_stats.fail_cnt, COLOR_NONE);
+        log("\n%s%u tests failed!%s\n\n", COLOR_RED, global_stats.fail_cnt.load(), COLOR_NONE);
 
         PAUSE();
     }
 }
 
 void Test::reset() {
-    global_stats = {};
+    global_stats.fail_cnt = 0;
+    global_stats.slow_cnt = 0;
 }
 #pragma endregion Test
 
 
+#pragma region Runner
+Runner::Runner(unsigned thread_cnt) :
+    thread_cnt{thread_cnt ? thread_cnt : std::max(std::thread::hardware_concurrency(), 1u)} {}
+
+bool Runner::run() {
+    std::vector<std::string> outputs(tests.size());
+    std::atomic<size_t> next_idx = 0;
+    std::atomic<unsigned> cnt_failed = 0;
+
+    auto worker = [&]() {
+        for (size_t idx = next_idx++; idx < tests.size(); idx = next_idx++) {
+            LogCapture capture{outputs[idx]};
+
+            if (!tests[idx].run()) {
+                ++cnt_failed;
+            }
+        }
+    };
+
+    const unsigned cnt_threads = (unsigned)std::min<size_t>(thread_cnt, tests.size());
+    const auto start_time = std::chrono::steady_clock::now();
+
+    {
+        std::vector<std::jthread> threads{};
+
+        // The calling thread does its share too
+        for (unsigned i = 1; i < cnt_threads; ++i) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+    }
+
+    const Test::duration_type wall_time = std::chrono::steady_clock::now() - start_time;
+
+    Test::duration_type total_time{};
+    for (size_t i = 0; i < tests.size(); ++i) {
+        log("%.*s", (int)outputs[i].size(), outputs[i].data());
+        total_time += tests[i].elapsed();
+    }
+
+    log("%zu tests on %u threads: %.3f ms wall time, %.3f ms in tests\n",
+        tests.size(), std::max(cnt_threads, 1u), wall_time.count(), total_time.count());
+
+    tests.clear();
+
+    return cnt_failed == 0;
+}
+#pragma endregion Runner
+
+
+#pragma region Bench
+void _impl::use_char_pointer(const volatile char *) {}
+
+std::vector<Bench::Result> Bench::results_{};
+
+const std::vector<Bench::Result> &Bench::results() {
+    return results_;
+}
+
+void Bench::reset() {
+    results_.clear();
+}
+
+/// Picks the unit by the magnitude of ns, and scales ns to it
+static const char *pick_time_unit(double ns, double &scale) {
+    if (ns < 1e3) {
+        scale = 1;
+        return "ns";
+    } else if (ns < 1e6) {
+        scale = 1e-3;
+        return "us";
+    } else if (ns < 1e9) {
+        scale = 1e-6;
+        return "ms";
+    }
+
+    scale = 1e-9;
+    return "s ";
+}
+
+Bench::Result Bench::_record(std::string_view name, size_t iterations, size_t calls,
+                             double allocations, std::vector<double> samples) {
+    assert(!samples.empty());
+
+    Result result{};
+    result.name = name;
+    result.iterations = iterations;
+    result.calls = calls;
+    result.samples = std::move(samples);
+    result.allocations = allocations;
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    const size_t cnt = sorted.size();
+
+    result.min = sorted.front();
+    result.median = cnt % 2 ? sorted[cnt / 2] : (sorted[cnt / 2 - 1] + sorted[cnt / 2]) / 2;
+    // Nearest rank
+    result.p99 = sorted[(size_t)std::ceil(0.99 * cnt) - 1];
+    result.mean = std::accumulate(sorted.begin(), sorted.end(), 0.) / cnt;
+
+    double sq_dev = 0;
+    for (double sample : sorted) {
+        sq_dev += (sample - result.mean) * (sample - result.mean);
+    }
+    result.stddev = cnt > 1 ? std::sqrt(sq_dev / (cnt - 1)) : 0;
+
+    double scale = 1;
+    const char *unit = pick_time_unit(result.median, scale);
+
+    log("%-48.*s %10.3f %s  (min %.3f, p99 %.3f, sd %.3f; %zu x %zu)\n",
+        (int)name.size(), name.data(), result.median * scale, unit,
+        result.min * scale, result.p99 * scale, result.stddev * scale,
+        cnt, iterations);
+
+    results_.push_back(result);
+
+    return result;
+}
+
+static void append_json_string(std::string &out, std::string_view str) {
+    out += '"';
+
+    for (char c : str) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+
+        case '\\':
+            out += "\\\\";
+            break;
+
+        case '\n':
+            out += "\\n";
+            break;
+
+        default:
+            if ((unsigned char)c < 0x20) {
+                out += abel::sprintfxx("\\u%04x", (unsigned)c);
+            } else {
+                out += c;
+            }
+            break;
+        }
+    }
+
+    out += '"';
+}
+
+std::string Bench::to_json() {
+    std::string out = "{\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const Result &result = results_[i];
+
+        out += i ? ",\n    {\"name\": " : "\n    {\"name\": ";
+        append_json_string(out, result.name);
+
+        out += abel::sprintfxx(", \"iterations\": %zu, \"calls\": %zu, "
+                               "\"min_ns\": %.3f, \"median_ns\": %.3f, \"p99_ns\": %.3f, "
+                               "\"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"allocations\": %.3f, \"samples_ns\": [",
+                               result.iterations, result.calls,
+                               result.min, result.median, result.p99,
+                               result.mean, result.stddev, result.allocations);
+
+        for (size_t j = 0; j < result.samples.size(); ++j) {
+            out += abel::sprintfxx(j ? ", %.3f" : "%.3f", result.samples[j]);
+        }
+
+        out += "]}";
+    }
+
+    out += results_.empty() ? "]\n}\n" : "\n  ]\n}\n";
+
+    return out;
+}
+
+void Bench::save_json(const std::filesystem::path &path) {
+    std::ofstream file(path, std::ios::binary);
+    file << to_json();
+
+    if (!file) {
+        throw std::runtime_error("Failed to write the benchmark results");
+    }
+}
+
+/// Just enough JSON to read back what to_json() writes
+class JsonReader {
+public:
+    struct Value {
+        enum class Type {
+            null,
+            boolean,
+            number,
+            string,
+            array,
+            object,
+        } type = Type::null;
+
+        double number = 0;
+        std::string string{};
+        std::vector<Value> items{};
+        std::vector<std::pair<std::string, Value>> fields{};
+
+
+        const Value *find(std::string_view key) const {
+            for (const auto &[name, value] : fields) {
+                if (name == key) {
+                    return &value;
+                }
+            }
+
+            return nullptr;
+        }
+    };
+
+
+    explicit JsonReader(std::string_view text) :
+        text_{text} {}
+
+    Value parse() {
+        Value result = parse_value();
+
+        skip_space();
+        if (pos_ != text_.size()) {
+            error("Trailing characters");
+        }
+
+        return result;
+    }
+
+protected:
+    std::string_view text_;
+    size_t pos_ = 0;
+
+
+    [[noreturn]] void error(const char *what) const {
+        throw std::runtime_error(abel::sprintfxx("Bad JSON at %zu: %s", pos_, what));
+    }
+
+    void skip_space() {
+        while (pos_ < text_.size() && std::isspace((unsigned char)text_[pos_])) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c) {
+        skip_space();
+
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            error(abel::sprintfxx("Expected '%c'", c).c_str());
+        }
+    }
+
+    bool consume_word(std::string_view word) {
+        if (text_.substr(pos_, word.size()) == word) {
+            pos_ += word.size();
+            return true;
+        }
+
+        return false;
+    }
+
+    Value parse_value() {
+        skip_space();
+        if (pos_ == text_.size()) {
+            error("Unexpected end");
+        }
+
+        Value result{};
+
+        switch (text_[pos_]) {
+        case '{':
+            result.type = Value::Type::object;
+            ++pos_;
+
+            if (consume('}')) {
+                break;
+            }
+
+            do {
+                skip_space();
+                std::string key = parse_string();
+                expect(':');
+                result.fields.emplace_back(std::move(key), parse_value());
+            } while (consume(','));
+
+            expect('}');
+            break;
+
+        case '[':
+            result.type = Value::Type::array;
+            ++pos_;
+
+            if (consume(']')) {
+                break;
+            }
+
+            do {
+                result.items.push_back(parse_value());
+            } while (consume(','));
+
+            expect(']');
+            break;
+
+        case '"':
+            result.type = Value::Type::string;
+            result.string = parse_string();
+            break;
+
+        default:
+            if (consume_word("null")) {
+                break;
+            }
+
+            if (consume_word("true")) {
+                result.type = Value::Type::boolean;
+                result.number = 1;
+                break;
+            }
+
+            if (consume_word("false")) {
+                result.type = Value::Type::boolean;
+                break;
+            }
+
+            result.type = Value::Type::number;
+            result.number = parse_number();
+            break;
+        }
+
+        return result;
+    }
+
+    std::string parse_string() {
+        if (pos_ == text_.size() || text_[pos_] != '"') {
+            error("Expected a string");
+        }
+        ++pos_;
+
+        std::string result{};
+
+        while (true) {
+            if (pos_ == text_.size()) {
+                error("Unterminated string");
+            }
+
+            char c = text_[pos_++];
+
+            if (c == '"') {
+                return result;
+            }
+
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+
+            if (pos_ == text_.size()) {
+                error("Unterminated string");
+            }
+
+            switch (c = text_[pos_++]) {
+            case 'n':
+                result += '\n';
+                break;
+
+            case 't':
+                result += '\t';
+                break;
+
+            case 'r':
+                result += '\r';
+                break;
+
+            case 'u': {
+                // Only ever written for control characters
+                unsigned code = 0;
+                if (pos_ + 4 > text_.size() ||
+                    std::from_chars(&text_[pos_], &text_[pos_] + 4, code, 16).ptr != &text_[pos_] + 4 ||
+                    code > 0x7f) {
+                    error("Unsupported escape");
+                }
+
+                result += (char)code;
+                pos_ += 4;
+            } break;
+
+            default:
+                result += c;
+                break;
+            }
+        }
+    }
+
+    double parse_number() {
+        double result = 0;
+
+        const char *first = text_.data() + pos_;
+        const char *last = text_.data() + text_.size();
+        auto [ptr, ec] = std::from_chars(first, last, result);
+
+        if (ec != std::errc{} || ptr == first) {
+            error("Expected a value");
+        }
+
+        pos_ += ptr - first;
+
+        return result;
+    }
+
+};
+
+std::vector<Bench::Result> Bench::load_json(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to read the benchmark results");
+    }
+
+    std::ostringstream text{};
+    text << file.rdbuf();
+
+    const JsonReader::Value root = JsonReader(text.view()).parse();
+    const JsonReader::Value *benchmarks = root.find("benchmarks");
+
+    if (!benchmarks || benchmarks->type != JsonReader::Value::Type::array) {
+        throw std::runtime_error("No benchmarks in the results");
+    }
+
+    std::vector<Result> results{};
+
+    for (const JsonReader::Value &item : benchmarks->items) {
+        const auto number = [&item](std::string_view key) {
+            const JsonReader::Value *value = item.find(key);
+
+            return value ? value->number : 0.;
+        };
+
+        Result result{};
+
+        if (const JsonReader::Value *name = item.find("name")) {
+            result.name = name->string;
+        }
+
+        result.iterations = (size_t)number("iterations");
+        result.calls = (size_t)number("calls");
+        result.min = number("min_ns");
+        result.median = number("median_ns");
+        result.p99 = number("p99_ns");
+        result.mean = number("mean_ns");
+        result.stddev = number("stddev_ns");
+        result.allocations = number("allocations");
+
+        if (const JsonReader::Value *samples = item.find("samples_ns")) {
+            for (const JsonReader::Value &sample : samples->items) {
+                result.samples.push_back(sample.number);
+            }
+        }
+
+        results.push_back(std::move(result));
+    }
+
+    return results;
+}
+
+double Bench::mann_whitney_p(const std::vector<double> &samples, const std::vector<double> &baseline) {
+    const size_t n = samples.size();
+    const size_t m = baseline.size();
+
+    if (n == 0 || m == 0) {
+        return 1;
+    }
+
+    // Ranks over both at once, ties getting the average of theirs
+    std::vector<std::pair<double, bool>> all{};
+    all.reserve(n + m);
+    for (double sample : samples) {
+        all.emplace_back(sample, true);
+    }
+    for (double sample : baseline) {
+        all.emplace_back(sample, false);
+    }
+    std::sort(all.begin(), all.end());
+
+    double rank_sum = 0;
+    double tie_term = 0;
+    for (size_t i = 0; i < all.size(); ) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+
+        const double rank = (double)(i + j + 1) / 2;
+        for (size_t k = i; k < j; ++k) {
+            rank_sum += all[k].second ? rank : 0;
+        }
+
+        const double tied = (double)(j - i);
+        tie_term += tied * tied * tied - tied;
+
+        i = j;
+    }
+
+    // How many of the (sample, baseline) pairs have the sample slower
+    const double u = rank_sum - (double)n * (n + 1) / 2;
+
+    if (n <= 20 && m <= 20) {
+        // The exact distribution, from counts[k][u] = orderings of k samples among the baseline giving u
+        const size_t max_u = n * m;
+        std::vector<std::vector<double>> counts(n + 1, std::vector<double>(max_u + 1, 0));
+
+        for (size_t j = 0; j <= m; ++j) {
+            std::vector<std::vector<double>> next(n + 1, std::vector<double>(max_u + 1, 0));
+
+            for (size_t k = 0; k <= n; ++k) {
+                for (size_t v = 0; v <= k * j; ++v) {
+                    if (j == 0) {
+                        next[k][v] = v == 0;
+                        continue;
+                    }
+
+                    // The largest of all is either one of the baseline's, or one of the samples,
+                    // in which case it beats all j of the baseline
+                    next[k][v] = counts[k][v] + (k > 0 && v >= j ? next[k - 1][v - j] : 0);
+                }
+            }
+
+            counts = std::move(next);
+        }
+
+        double total = 0;
+        double tail = 0;
+        for (size_t v = 0; v <= max_u; ++v) {
+            total += counts[n][v];
+            tail += (double)v >= u - 1e-9 ? counts[n][v] : 0;
+        }
+
+        return tail / total;
+    }
+
+    const double total = (double)(n + m);
+    const double mean = (double)n * m / 2;
+    const double variance = (double)n * m / 12 * ((total + 1) - tie_term / (total * (total - 1)));
+
+    if (variance <= 0) {
+        return 1;
+    }
+
+    // With a continuity correction
+    const double z = (u - mean - 0.5) / std::sqrt(variance);
+
+    return std::erfc(z / std::sqrt(2.)) / 2;
+}
+
+std::vector<Bench::Comparison> Bench::compare(const std::vector<Result> &baseline) {
+    std::vector<Comparison> comparisons{};
+    std::vector<bool> used(baseline.size(), false);
+    unsigned cnt_regressed = 0;
+
+    log("Compared to the baseline:\n");
+    LogBlock block{};
+
+    for (const Result &result : results_) {
+        // Repeated names are matched in order
+        size_t idx = 0;
+        while (idx < baseline.size() && (used[idx] || baseline[idx].name != result.name)) {
+            ++idx;
+        }
+
+        if (idx == baseline.size()) {
+            log("%-48s %12s\n", result.name.c_str(), "(new)");
+            continue;
+        }
+
+        used[idx] = true;
+        const Result &base = baseline[idx];
+
+        Comparison cmp{};
+        cmp.name = result.name;
+        cmp.baseline_median = base.median;
+        cmp.median = result.median;
+        cmp.p_value = mann_whitney_p(result.samples, base.samples);
+        cmp.regressed = cmp.ratio() > 1 + regression_threshold && cmp.p_value <= significance;
+
+        if (cmp.regressed) {
+            ++cnt_regressed;
+            ++Test::global_stats.fail_cnt;
+        }
+
+        log("%-48s %+11.1f%%  (p = %.4f)%s\n",
+            result.name.c_str(), (cmp.ratio() - 1) * 100, cmp.p_value,
+            cmp.regressed ? abel::sprintfxx(" %sREGRESSED%s", COLOR_RED, COLOR_NONE).c_str() : "");
+
+        comparisons.push_back(std::move(cmp));
+    }
+
+    if (cnt_regressed) {
+        log("\n%s%u benchmarks regressed by over %.1f%%!%s\n",
+            COLOR_RED, cnt_regressed, regression_threshold * 100, COLOR_NONE);
+    } else {
+        log("\n%sNo regressions.%s\n", COLOR_GREEN, COLOR_NONE);
+    }
+
+    return comparisons;
+}
+
+bool Bench::check_baseline(const std::filesystem::path &path) {
+    if (!std::filesystem::exists(path)) {
+        save_json(path);
+        log("Saved a new baseline to %s\n", path.string().c_str());
+
+        return true;
+    }
+
+    const std::vector<Comparison> comparisons = compare(load_json(path));
+
+    return std::none_of(comparisons.begin(), comparisons.end(),
+                        [](const Comparison &cmp) { return cmp.regressed; });
+}
+#pragma endregion Bench
+
+
+}
+
+
+#if UTEST_COUNT_ALLOCS_
+#pragma region Operator new & delete
+// Global replacements, routing everything through utest's counters
+
+void *operator new(size_t size) {
+    return utest::counted_alloc_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](size_t size) {
+    return utest::counted_alloc_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(size_t size, std::align_val_t align) {
+    return utest::counted_alloc_or_throw(size, (size_t)align);
+}
+
+void *operator new[](size_t size, std::align_val_t align) {
+    return utest::counted_alloc_or_throw(size, (size_t)align);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return utest::counted_alloc(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return utest::counted_alloc(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return utest::counted_alloc(size, (size_t)align);
+}
+
+void *operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return utest::counted_alloc(size, (size_t)align);
+}
+
+void operator delete(void *ptr) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    utest::counted_free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    utest::counted_free(ptr);
 }
+#pragma endregion Operator new & delete
+#endif
@@ -4,6 +4,10 @@
 #include <ACL/type_traits.h>
 #include <concepts>
 #include <functional>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <type_traits>
 #include <source_location>
 #include <string_view>
 #include <format>
@@ -12,11 +16,21 @@
 #include <string>  // For std::to_string
 #include "array.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>  // For _ReadWriteBarrier
+#endif
+
+// Replacing the global operator new and delete affects the whole program, so it's opt-in
+#ifndef UTEST_COUNT_ALLOCS_
+#define UTEST_COUNT_ALLOCS_ 0
+#endif
+
 
 namespace utest {
 
 
 #pragma region Logging
+/// Thread-safe; while a test runs under Runner, goes to that test's own buffer instead
 void log(const char *fmt, ...);
 void indent();
 void dedent();
@@ -34,11 +48,72 @@ struct LogBlock {
 #pragma endregion Logging
 
 
+#pragma region Allocations
+/**
+ * Counters for the global operator new and delete, which utest replaces
+ * when built with UTEST_COUNT_ALLOCS_ set. Otherwise they all stay at zero.
+ * They are kept per thread, so that a Runner's tests don't see each other's
+ * allocations. Memory freed by a different thread than the one that
+ * allocated it counts against the one that freed it.
+ */
+struct AllocStats {
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    /// Requested by all the allocations together
+    size_t bytes = 0;
+    /// Relative to where the measurement started, so these can go negative
+    ptrdiff_t live_bytes = 0;
+    ptrdiff_t peak_live_bytes = 0;
+};
+
+/// Whether AllocStats mean anything in this build
+constexpr bool counts_allocations = UTEST_COUNT_ALLOCS_;
+
+/// Everything the calling thread has allocated since it started
+AllocStats thread_alloc_stats() noexcept;
+
+/// Measures the calling thread's allocations from its construction on. May be nested
+class AllocCounter {
+public:
+    AllocCounter() noexcept;
+
+    AllocCounter(const AllocCounter &other) = delete;
+    AllocCounter &operator=(const AllocCounter &other) = delete;
+
+    ~AllocCounter();
+
+    AllocStats stats() const noexcept;
+
+    inline size_t allocations() const noexcept {
+        return stats().allocations;
+    }
+
+    inline size_t bytes() const noexcept {
+        return stats().bytes;
+    }
+
+    inline ptrdiff_t peak_live_bytes() const noexcept {
+        return stats().peak_live_bytes;
+    }
+
+protected:
+    AllocStats start_;
+    ptrdiff_t outer_peak_;
+
+};
+#pragma endregion Allocations
+
+
 #pragma region Test
 class Test {
 public:
     struct user_fail_error {};
 
+    using duration_type = std::chrono::duration<double, std::milli>;
+
+    /// Tests that take longer than this are flagged in the report
+    static inline duration_type slow_threshold{100};
+
 
     inline Test(std::function<bool ()> func,
                 std::string_view name,
@@ -52,7 +127,8 @@ public:
 
     inline Test(Test &&other) noexcept :
         func{std::move(other.func)}, name{std::move(other.name)},
-        loc{std::move(other.loc)}, status{std::move(other.status)} {
+        loc{std::move(other.loc)}, status{std::move(other.status)},
+        elapsed_{other.elapsed_}, alloc_stats_{other.alloc_stats_} {
 
         other.status = Status::dead;
     }
@@ -62,6 +138,8 @@ public:
         std::swap(name, other.name);
         std::swap(loc, other.loc);
         status = std::move(other.status);
+        elapsed_ = other.elapsed_;
+        alloc_stats_ = other.alloc_stats_;
         other.status = Status::dead;
 
         return *this;
@@ -69,11 +147,34 @@ public:
 
     bool run();
 
+    /// The test running on this thread
     static inline Test &current() {
         assert(current_ptr);
         return *current_ptr;
     }
 
+    inline std::string_view get_name() const noexcept {
+        return name;
+    }
+
+    inline bool passed() const noexcept {
+        return status == Status::passed;
+    }
+
+    /// Wall time from the start of the test up until it passed or failed
+    inline duration_type elapsed() const noexcept {
+        return elapsed_;
+    }
+
+    inline bool is_slow() const noexcept {
+        return elapsed_ > slow_threshold;
+    }
+
+    /// What the test allocated up until it passed or failed
+    inline const AllocStats &alloc_stats() const noexcept {
+        return alloc_stats_;
+    }
+
     void fail() const;
     void fail(const std::string_view &reason) const;
     void fail(const char *exc_name, const std::string_view &exc_what) const;
@@ -103,14 +204,26 @@ protected:
         failed,
     } status{Status::not_reported};
 
-    static Test *current_ptr;
+    std::chrono::steady_clock::time_point start_time_{};
+    mutable duration_type elapsed_{};
+    // Only set while the test runs
+    const AllocCounter *alloc_counter_ = nullptr;
+    mutable AllocStats alloc_stats_{};
+
+    static thread_local Test *current_ptr;
+    // Benchmark regressions count as failures too
+    friend class Bench;
     static struct {
-        unsigned fail_cnt = 0;
+        std::atomic<unsigned> fail_cnt = 0;
+        std::atomic<unsigned> slow_cnt = 0;
     } global_stats;
 
 
     void header() const;
 
+    /// Fixes elapsed_ and alloc_stats_, and produces the " (... ms)" note for the verdict
+    std::string stop_clock() const;
+
     void pass() const;
 
 };
@@ -220,4 +333,259 @@ void suite(const std::string_view &name, As &&...tests) {
 #pragma endregion Suite
 
 
+#pragma region Runner
+/**
+ * Runs independent tests on a pool of threads. Each test logs into a buffer
+ * of its own, and the buffers are printed in the order the tests were added,
+ * so the output doesn't depend on scheduling. Tests that touch shared mutable
+ * state (including abel::randLL's seed) must not be run this way.
+ */
+class Runner {
+public:
+    /// 0 threads means one per hardware thread
+    explicit Runner(unsigned thread_cnt = 0);
+
+    Runner(const Runner &other) = delete;
+    Runner &operator=(const Runner &other) = delete;
+
+    inline Runner &add(Test &&test) {
+        tests.push_back(std::move(test));
+
+        return *this;
+    }
+
+    /// Runs everything added so far, and then forgets it. Returns whether all of it passed
+    bool run();
+
+protected:
+    unsigned thread_cnt;
+    std::vector<Test> tests{};
+
+};
+#pragma endregion Runner
+
+
+#pragma region Bench
+namespace _impl {
+/// Defined out of line, so that the compiler has to assume it reads the pointee
+void use_char_pointer(const volatile char *ptr);
+}
+
+/// Forces value to be computed and kept around, as if something read it
+template <typename T>
+inline void do_not_optimize(T &&value) {
+    #ifdef _MSC_VER
+    _impl::use_char_pointer(&reinterpret_cast<const volatile char &>(value));
+    _ReadWriteBarrier();
+    #else
+    if constexpr (std::is_trivially_copyable_v<std::remove_cvref_t<T>> && sizeof(T) <= sizeof(void *)) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    } else {
+        asm volatile("" : : "m"(value) : "memory");
+    }
+    #endif
+}
+
+/// Forces all pending writes to memory to actually happen
+inline void clobber_memory() {
+    #ifdef _MSC_VER
+    _ReadWriteBarrier();
+    #else
+    asm volatile("" : : : "memory");
+    #endif
+}
+
+
+/**
+ * Microbenchmarks. The function is warmed up, then called in samples of
+ * a calibrated number of iterations, each sample lasting about sample_time,
+ * until time_budget runs out. Calibration times batches of calls that double
+ * in size until one lasts batch_time, so the clock's own cost and resolution
+ * don't skew the estimate. Since it's called many times over, the
+ * function has to leave everything the way it found it. Non-void results
+ * are passed through do_not_optimize.
+ * Every result is logged and kept, to be written out as JSON later.
+ */
+class Bench {
+public:
+    using duration_type = std::chrono::duration<double, std::milli>;
+
+    static inline duration_type warmup_time{20};
+    static inline duration_type batch_time{1};
+    static inline duration_type sample_time{5};
+    static inline duration_type time_budget{200};
+    static inline unsigned min_samples = 3;
+    static inline unsigned max_samples = 1000;
+
+    /// How much slower the median may get before it counts as a regression
+    static inline double regression_threshold = 0.10;
+    /// How sure the Mann-Whitney test has to be that it did get slower. 1 leaves only the threshold
+    static inline double significance = 0.05;
+
+    /// All times are in nanoseconds per call
+    struct Result {
+        std::string name{};
+        /// Calls per sample
+        size_t iterations = 0;
+        /// Calls overall, warm-up included
+        size_t calls = 0;
+        std::vector<double> samples{};
+        /// Per call, over the samples
+        double allocations = 0;
+
+        double min = 0;
+        double median = 0;
+        double p99 = 0;
+        double mean = 0;
+        double stddev = 0;
+    };
+
+
+    template <std::invocable<> F>
+    static Result run(std::string_view name, F &&func) {
+        using clock = std::chrono::steady_clock;
+
+        size_t calls = 0;
+        size_t batch = 1;
+        duration_type last_batch{};
+
+        // Also gives the estimate of how long a call takes, from the last batch
+        const auto warmup_start = clock::now();
+        do {
+            last_batch = _time_batch(func, batch);
+            calls += batch;
+
+            if (last_batch < batch_time) {
+                batch *= 2;
+            }
+        } while (last_batch < batch_time || clock::now() - warmup_start < warmup_time);
+        const duration_type per_call = last_batch / (double)batch;
+
+        const size_t iterations = std::max<size_t>(1, (size_t)(sample_time / per_call));
+        const size_t sample_cnt = std::clamp<size_t>((size_t)(time_budget / (per_call * iterations)),
+                                                     min_samples, max_samples);
+
+        std::vector<double> samples{};
+        samples.reserve(sample_cnt);
+
+        AllocCounter allocs{};
+
+        for (size_t i = 0; i < sample_cnt; ++i) {
+            const auto start = clock::now();
+
+            for (size_t j = 0; j < iterations; ++j) {
+                _call(func);
+            }
+
+            const std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+            samples.push_back(elapsed.count() / iterations);
+        }
+
+        calls += sample_cnt * iterations;
+
+        const double allocations = (double)allocs.allocations() / (sample_cnt * iterations);
+
+        return _record(name, iterations, calls, allocations, std::move(samples));
+    }
+
+    /// Everything run since the last reset(), in order
+    static const std::vector<Result> &results();
+
+    static void reset();
+
+    static std::string to_json();
+
+    static void save_json(const std::filesystem::path &path);
+
+    /// Reads back what save_json() wrote
+    static std::vector<Result> load_json(const std::filesystem::path &path);
+
+    struct Comparison {
+        std::string name;
+        double baseline_median = 0;
+        double median = 0;
+        /// Of the samples being this much slower than the baseline's by pure chance
+        double p_value = 1;
+        bool regressed = false;
+
+
+        inline double ratio() const noexcept {
+            return median / baseline_median;
+        }
+    };
+
+    /**
+     * Compares results() against the baseline, by name, and logs the outcome.
+     * Benchmarks that got slower by more than regression_threshold, with
+     * a p-value of at most significance, are regressions, and count as failed tests.
+     */
+    static std::vector<Comparison> compare(const std::vector<Result> &baseline);
+
+    /**
+     * Compares against the baseline stored in path, or, if there's none yet,
+     * stores results() there. Returns whether nothing regressed.
+     */
+    static bool check_baseline(const std::filesystem::path &path);
+
+    /**
+     * The one-sided Mann-Whitney U test: how likely samples are to rank
+     * this high against baseline, if both come from the same distribution.
+     * Exact for small sample counts, normally approximated for larger ones.
+     */
+    static double mann_whitney_p(const std::vector<double> &samples, const std::vector<double> &baseline);
+
+protected:
+    static std::vector<Result> results_;
+
+
+    template <typename F>
+    static inline void _call(F &func) {
+        if constexpr (std::is_void_v<std::invoke_result_t<F &>>) {
+            func();
+        } else {
+            do_not_optimize(func());
+        }
+    }
+
+    template <typename F>
+    static duration_type _time_batch(F &func, size_t count) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < count; ++i) {
+            _call(func);
+        }
+
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    /// Computes the statistics, logs them and keeps the result
+    static Result _record(std::string_view name, size_t iterations, size_t calls,
+                          double allocations, std::vector<double> samples);
+
+};
+
+template <std::invocable<> F>
+inline Bench::Result bench(std::string_view name, F &&func) {
+    return Bench::run(name, std::forward<F>(func));
+}
+
+namespace _impl {
+struct BenchProxy {
+    std::string_view name;
+
+    template <std::invocable<> F>
+    Bench::Result operator<<(F &&func) {
+        return Bench::run(name, std::forward<F>(func));
+    }
+};
+}
+
+namespace literals {
+constexpr auto operator ""_bench(const char *str, size_t) {
+    return _impl::BenchProxy(str);
+}
+}
+#pragma endregion Bench
+
+
 }  // namespace utest